@@ -0,0 +1,246 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/textconsole.h"
+#include "common/util.h"
+
+#include "audio/audiostream.h"
+#include "audio/decoders/cache.h"
+
+namespace Audio {
+
+/**
+ * Decoded PCM data shared by the cache and all streams playing it. It is
+ * deleted when the last reference to it is released.
+ */
+struct DecodedAudioCache::Buffer {
+	Buffer(int16 *data_, uint32 numSamples_, int rate_, bool stereo_)
+		: data(data_), numSamples(numSamples_), rate(rate_), stereo(stereo_), _refCount(1) {}
+
+	int16 *data;
+	uint32 numSamples;
+	int rate;
+	bool stereo;
+
+	uint32 size() const { return numSamples * sizeof(int16); }
+
+	void incRef() {
+		Common::StackLock lock(_mutex);
+		++_refCount;
+	}
+
+	void decRef() {
+		bool last;
+		{
+			Common::StackLock lock(_mutex);
+			last = (--_refCount == 0);
+		}
+		if (last)
+			delete this;
+	}
+
+private:
+	~Buffer() { free(data); }
+
+	Common::Mutex _mutex;
+	int _refCount;
+};
+
+#pragma mark -
+#pragma mark --- CachedAudioStream ---
+#pragma mark -
+
+/**
+ * A stream playing decoded PCM data owned by a DecodedAudioCache.
+ */
+class CachedAudioStream : public SeekableAudioStream {
+public:
+	CachedAudioStream(DecodedAudioCache::Buffer *buffer)
+		: _buffer(buffer), _pos(0) {
+		_buffer->incRef();
+	}
+
+	~CachedAudioStream() {
+		_buffer->decRef();
+	}
+
+	int readBuffer(int16 *buffer, const int numSamples) {
+		const int samples = MIN<int>(numSamples, _buffer->numSamples - _pos);
+		memcpy(buffer, _buffer->data + _pos, samples * sizeof(int16));
+		_pos += samples;
+		return samples;
+	}
+
+	bool isStereo() const  { return _buffer->stereo; }
+	bool endOfData() const { return _pos >= _buffer->numSamples; }
+
+	int getRate() const         { return _buffer->rate; }
+	Timestamp getLength() const { return Timestamp(0, _buffer->numSamples / (_buffer->stereo ? 2 : 1), _buffer->rate); }
+
+	bool seek(const Timestamp &where) {
+		const uint32 seekSample = convertTimeToStreamPos(where, getRate(), isStereo()).totalNumberOfFrames();
+		if (seekSample > _buffer->numSamples) {
+			_pos = _buffer->numSamples;
+			return false;
+		}
+
+		_pos = seekSample;
+		return true;
+	}
+
+private:
+	DecodedAudioCache::Buffer *_buffer;
+	uint32 _pos;
+};
+
+#pragma mark -
+#pragma mark --- DecodedAudioCache ---
+#pragma mark -
+
+DecodedAudioCache::DecodedAudioCache(uint32 memoryBudget)
+	: _memoryBudget(memoryBudget), _memoryUsage(0), _hits(0), _misses(0) {
+}
+
+DecodedAudioCache::~DecodedAudioCache() {
+	clear();
+}
+
+Common::String DecodedAudioCache::makeKey(const Common::String &member, uint32 offset) {
+	return Common::String::format("%s:%u", member.c_str(), offset);
+}
+
+SeekableAudioStream *DecodedAudioCache::getStream(const Common::String &member, uint32 offset) {
+	Common::StackLock lock(_mutex);
+
+	EntryMap::iterator i = _entries.find(makeKey(member, offset));
+	if (i == _entries.end()) {
+		_misses++;
+		return 0;
+	}
+
+	_hits++;
+
+	// Move the entry to the front of the LRU list
+	_lru.erase(i->_value.lruPos);
+	_lru.push_front(i->_key);
+	i->_value.lruPos = _lru.begin();
+
+	return new CachedAudioStream(i->_value.buffer);
+}
+
+SeekableAudioStream *DecodedAudioCache::addStream(const Common::String &member, uint32 offset, SeekableAudioStream *stream) {
+	if (!stream)
+		return 0;
+
+	// Decode the whole stream
+	const bool stereo = stream->isStereo();
+	const int rate = stream->getRate();
+	uint32 capacity = stream->getLength().totalNumberOfFrames() * (stereo ? 2 : 1);
+	if (capacity == 0)
+		capacity = 4096;
+
+	int16 *data = (int16 *)malloc(capacity * sizeof(int16));
+	uint32 numSamples = 0;
+
+	while (data && !stream->endOfData()) {
+		if (numSamples == capacity) {
+			capacity *= 2;
+			int16 *newData = (int16 *)realloc(data, capacity * sizeof(int16));
+			if (!newData)
+				free(data);
+			data = newData;
+			if (!data)
+				break;
+		}
+
+		const int samples = stream->readBuffer(data + numSamples, capacity - numSamples);
+		if (samples <= 0)
+			break;
+		numSamples += samples;
+	}
+
+	delete stream;
+
+	if (!data) {
+		warning("DecodedAudioCache::addStream: Cannot allocate memory for decoded sample");
+		return 0;
+	}
+
+	// The cache's reference is released below if the buffer is not kept
+	Buffer *buffer = new Buffer(data, numSamples, rate, stereo);
+	SeekableAudioStream *result = new CachedAudioStream(buffer);
+
+	Common::StackLock lock(_mutex);
+
+	const Common::String key = makeKey(member, offset);
+	EntryMap::iterator i = _entries.find(key);
+	if (i != _entries.end())
+		removeEntry(i);
+
+	if (buffer->size() <= _memoryBudget) {
+		evict(buffer->size());
+
+		_lru.push_front(key);
+		Entry &entry = _entries[key];
+		entry.buffer = buffer;
+		entry.lruPos = _lru.begin();
+		_memoryUsage += buffer->size();
+	} else {
+		buffer->decRef();
+	}
+
+	return result;
+}
+
+void DecodedAudioCache::clear() {
+	Common::StackLock lock(_mutex);
+
+	for (EntryMap::iterator i = _entries.begin(); i != _entries.end(); ++i)
+		i->_value.buffer->decRef();
+	_entries.clear();
+	_lru.clear();
+	_memoryUsage = 0;
+}
+
+void DecodedAudioCache::setMemoryBudget(uint32 memoryBudget) {
+	Common::StackLock lock(_mutex);
+
+	_memoryBudget = memoryBudget;
+	evict(0);
+}
+
+void DecodedAudioCache::evict(uint32 neededSpace) {
+	while (!_lru.empty() && _memoryUsage + neededSpace > _memoryBudget) {
+		EntryMap::iterator i = _entries.find(_lru.back());
+		assert(i != _entries.end());
+		removeEntry(i);
+	}
+}
+
+void DecodedAudioCache::removeEntry(EntryMap::iterator entry) {
+	_memoryUsage -= entry->_value.buffer->size();
+	_lru.erase(entry->_value.lruPos);
+	entry->_value.buffer->decRef();
+	_entries.erase(entry);
+}
+
+} // End of namespace Audio
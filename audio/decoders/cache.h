@@ -0,0 +1,148 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef AUDIO_DECODERS_CACHE_H
+#define AUDIO_DECODERS_CACHE_H
+
+#include "common/scummsys.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+#include "common/list.h"
+#include "common/mutex.h"
+#include "common/str.h"
+
+namespace Audio {
+
+class SeekableAudioStream;
+
+/**
+ * A cache for fully decoded sound effects.
+ *
+ * Engines which play the same short samples over and over again (footsteps,
+ * UI clicks) can keep the decoded PCM data in this cache instead of running
+ * the VOC/WAV/ADPCM/MP3/Vorbis/FLAC decoder every time. Entries are keyed by
+ * the archive member name and the offset of the sample inside that member.
+ *
+ * Every stream handed out by the cache is a lightweight, independently
+ * seekable view on a shared PCM buffer. When the memory budget is exceeded,
+ * the least recently used entries are dropped from the cache; their buffers
+ * stay alive until the last view on them has been deleted.
+ *
+ * The streams are usually played and deleted by the mixer thread, while the
+ * engine thread uses the cache. Both the cache and the reference counts of
+ * the buffers are therefore guarded by mutexes. Streams may also outlive the
+ * cache.
+ *
+ * Typical usage:
+ * @code
+ * Audio::SeekableAudioStream *stream = _cache.getStream(name, offset);
+ * if (!stream)
+ *     stream = _cache.addStream(name, offset, Audio::makeVOCStream(...));
+ * @endcode
+ */
+class DecodedAudioCache {
+public:
+	/**
+	 * Creates a new cache.
+	 *
+	 * @param memoryBudget Maximum size of the decoded PCM data kept by the cache, in bytes.
+	 */
+	DecodedAudioCache(uint32 memoryBudget);
+	~DecodedAudioCache();
+
+	/**
+	 * Looks up a decoded sample.
+	 *
+	 * @param member Name of the archive member the sample comes from.
+	 * @param offset Offset of the sample inside the member.
+	 * @return A new stream playing the cached sample, or 0 if the sample is not cached.
+	 */
+	SeekableAudioStream *getStream(const Common::String &member, uint32 offset);
+
+	/**
+	 * Decodes the given stream completely and adds the result to the cache.
+	 * The stream is deleted in the process.
+	 *
+	 * If the decoded data does not fit into the memory budget, it is not
+	 * kept in the cache, but a stream playing it is still returned.
+	 *
+	 * @param member Name of the archive member the sample comes from.
+	 * @param offset Offset of the sample inside the member.
+	 * @param stream The stream to decode, may be 0.
+	 * @return A new stream playing the decoded sample, or 0 if stream was 0.
+	 */
+	SeekableAudioStream *addStream(const Common::String &member, uint32 offset, SeekableAudioStream *stream);
+
+	/**
+	 * Removes all entries from the cache.
+	 */
+	void clear();
+
+	/**
+	 * Changes the memory budget, evicting entries if necessary.
+	 */
+	void setMemoryBudget(uint32 memoryBudget);
+	uint32 getMemoryBudget() const { return _memoryBudget; }
+
+	/** Returns the size of the PCM data currently kept by the cache, in bytes. */
+	uint32 getMemoryUsage() const { return _memoryUsage; }
+
+	/** Returns the number of getStream() calls which found the sample in the cache. */
+	uint32 getHits() const { return _hits; }
+
+	/** Returns the number of getStream() calls which did not find the sample in the cache. */
+	uint32 getMisses() const { return _misses; }
+
+	/** Resets the hit and miss counters. */
+	void resetStatistics() { _hits = _misses = 0; }
+
+	struct Buffer;
+
+private:
+	typedef Common::List<Common::String> KeyList;
+
+	struct Entry {
+		Buffer *buffer; ///< Holds a reference for the cache
+		KeyList::iterator lruPos;
+	};
+
+	typedef Common::HashMap<Common::String, Entry> EntryMap;
+
+	static Common::String makeKey(const Common::String &member, uint32 offset);
+
+	void evict(uint32 neededSpace);
+	void removeEntry(EntryMap::iterator entry);
+
+	Common::Mutex _mutex;
+
+	uint32 _memoryBudget;
+	uint32 _memoryUsage;
+	uint32 _hits;
+	uint32 _misses;
+
+	EntryMap _entries;
+	KeyList _lru; ///< Keys in order of use, most recently used first
+};
+
+} // End of namespace Audio
+
+#endif
@@ -61,7 +61,7 @@ public:
 	/**
 	 * Queries whether the channel is still playing or not.
 	 */
-	bool isFinished() const { return _stream->endOfStream(); }
+	bool isFinished() const { return _stream->endOfStream() && _drained; }
 
 	/**
 	 * Queries whether the channel is a permanent channel.
@@ -166,6 +166,8 @@ private:
 	uint32 _pauseTime;
 
 	RateConverter *_converter;
+	/** Whether the converter has written all output for the ended stream */
+	bool _drained;
 	Common::DisposablePtr<AudioStream> _stream;
 };
 
@@ -175,17 +177,23 @@ private:
 
 // TODO: parameter "system" is unused
 MixerImpl::MixerImpl(OSystem *system, uint sampleRate)
-	: _mutex(), _sampleRate(sampleRate), _mixerReady(false), _handleSeed(0), _soundTypeSettings() {
+	: _mutex(), _stateMutex(), _sampleRate(sampleRate), _mixerReady(false), _handleSeed(0), _soundTypeSettings(),
+	  _pendingStateChanges(false), _mixBus(0), _channelBuffer(0), _mixBufferSize(0) {
 
 	assert(sampleRate > 0);
 
-	for (int i = 0; i != NUM_CHANNELS; i++)
+	_channels.resize(INITIAL_CHANNELS);
+	_channelStates.resize(INITIAL_CHANNELS);
+	for (uint i = 0; i != _channels.size(); i++)
 		_channels[i] = 0;
 }
 
 MixerImpl::~MixerImpl() {
-	for (int i = 0; i != NUM_CHANNELS; i++)
+	for (uint i = 0; i != _channels.size(); i++)
 		delete _channels[i];
+
+	free(_mixBus);
+	free(_channelBuffer);
 }
 
 void MixerImpl::setReady(bool ready) {
@@ -196,29 +204,100 @@ uint MixerImpl::getOutputRate() const {
 	return _sampleRate;
 }
 
+MixerImpl::ChannelState *MixerImpl::findChannelState(SoundHandle handle) {
+	// The default handle has the same value as an empty slot, so it must
+	// never match one
+	if (handle._val == 0xFFFFFFFF)
+		return 0;
+
+	const uint index = handle._val % MAX_CHANNELS;
+	if (index >= _channelStates.size() || !_channelStates[index].isActive() || _channelStates[index].handle != handle._val)
+		return 0;
+
+	return &_channelStates[index];
+}
+
+void MixerImpl::deleteChannel(uint index) {
+	delete _channels[index];
+	_channels[index] = 0;
+
+	Common::StackLock lock(_stateMutex);
+	_channelStates[index] = ChannelState();
+}
+
+void MixerImpl::applyPendingStateChanges() {
+	Common::StackLock lock(_stateMutex);
+
+	if (!_pendingStateChanges)
+		return;
+
+	for (uint i = 0; i != _channelStates.size(); i++) {
+		ChannelState &state = _channelStates[i];
+		if (state.dirty && _channels[i]) {
+			_channels[i]->setVolume(state.volume);
+			_channels[i]->setBalance(state.balance);
+		}
+		state.dirty = false;
+	}
+
+	_pendingStateChanges = false;
+}
+
 void MixerImpl::insertChannel(SoundHandle *handle, Channel *chan) {
 	int index = -1;
-	for (int i = 0; i != NUM_CHANNELS; i++) {
+	for (uint i = 0; i != _channels.size(); i++) {
 		if (_channels[i] == 0) {
 			index = i;
 			break;
 		}
 	}
+
 	if (index == -1) {
-		warning("MixerImpl::out of mixer slots");
-		delete chan;
-		return;
+		if (_channels.size() >= MAX_CHANNELS) {
+			warning("MixerImpl::out of mixer slots");
+			delete chan;
+			return;
+		}
+
+		// Grow the channel table. The audio thread holds _mutex while
+		// mixing, so it cannot observe the reallocation.
+		const uint oldSize = _channels.size();
+		const uint newSize = MIN<uint>(oldSize * 2, MAX_CHANNELS);
+
+		_channels.resize(newSize);
+		for (uint i = oldSize; i != newSize; i++)
+			_channels[i] = 0;
+
+		Common::StackLock lock(_stateMutex);
+		_channelStates.resize(newSize);
+
+		index = oldSize;
 	}
 
 	_channels[index] = chan;
 
 	SoundHandle chanHandle;
-	chanHandle._val = index + (_handleSeed * NUM_CHANNELS);
+	chanHandle._val = index + (_handleSeed * MAX_CHANNELS);
+
+	// The value of the default handle is never handed out
+	if (chanHandle._val == 0xFFFFFFFF) {
+		_handleSeed++;
+		chanHandle._val = index + (_handleSeed * MAX_CHANNELS);
+	}
 
 	chan->setHandle(chanHandle);
 	_handleSeed++;
 	if (handle)
 		*handle = chanHandle;
+
+	Common::StackLock lock(_stateMutex);
+	ChannelState &state = _channelStates[index];
+	state.handle = chanHandle._val;
+	state.id = chan->getId();
+	state.type = chan->getType();
+	state.volume = chan->getVolume();
+	state.balance = chan->getBalance();
+	state.dirty = false;
 }
 
 void MixerImpl::playStream(
@@ -241,7 +320,7 @@ void MixerImpl::playStream(
 
 	// Prevent duplicate sounds
 	if (id != -1) {
-		for (int i = 0; i != NUM_CHANNELS; i++)
+		for (uint i = 0; i != _channels.size(); i++)
 			if (_channels[i] != 0 && _channels[i]->getId() == id) {
 				// Delete the stream if were asked to auto-dispose it.
 				// Note: This could cause trouble if the client code does not
@@ -266,31 +345,41 @@ void MixerImpl::playStream(
 	insertChannel(handle, chan);
 }
 
-int MixerImpl::mixCallback(byte *samples, uint len) {
-	assert(samples);
+int MixerImpl::mixChannels(uint len) {
+	// Since the mixer callback has been called, the mixer must be ready...
+	_mixerReady = true;
 
-	Common::StackLock lock(_mutex);
+	// Pick up volume changes made by the game threads
+	applyPendingStateChanges();
 
-	int16 *buf = (int16 *)samples;
-	// we store stereo, 16-bit samples
-	assert(len % 4 == 0);
-	len >>= 2;
+	if (len > _mixBufferSize) {
+		free(_mixBus);
+		free(_channelBuffer);
+		_mixBus = (int32 *)malloc(2 * len * sizeof(int32));
+		_channelBuffer = (int16 *)malloc(2 * len * sizeof(int16));
+		_mixBufferSize = len;
 
-	// Since the mixer callback has been called, the mixer must be ready...
-	_mixerReady = true;
+		if (!_mixBus || !_channelBuffer)
+			error("MixerImpl::mixChannels: Cannot allocate memory for mix buffers");
+	}
 
-	//  zero the buf
-	memset(buf, 0, 2 * len * sizeof(int16));
+	//  zero the bus
+	memset(_mixBus, 0, 2 * len * sizeof(int32));
 
 	// mix all channels
 	int res = 0, tmp;
-	for (int i = 0; i != NUM_CHANNELS; i++)
+	for (uint i = 0; i != _channels.size(); i++)
 		if (_channels[i]) {
 			if (_channels[i]->isFinished()) {
-				delete _channels[i];
-				_channels[i] = 0;
+				deleteChannel(i);
 			} else if (!_channels[i]->isPaused()) {
-				tmp = _channels[i]->mix(buf, len);
+				// Render the channel on its own, so that only its own
+				// samples get clamped, and accumulate it into the bus.
+				memset(_channelBuffer, 0, 2 * len * sizeof(int16));
+				tmp = _channels[i]->mix(_channelBuffer, len);
+
+				for (int j = 0; j != 2 * tmp; ++j)
+					_mixBus[j] += _channelBuffer[j];
 
 				if (tmp > res)
 					res = tmp;
@@ -300,22 +389,57 @@ int MixerImpl::mixCallback(byte *samples, uint len) {
 	return res;
 }
 
+int MixerImpl::mixCallback(byte *samples, uint len) {
+	assert(samples);
+
+	Common::StackLock lock(_mutex);
+
+	int16 *buf = (int16 *)samples;
+	// we store stereo, 16-bit samples
+	assert(len % 4 == 0);
+	len >>= 2;
+
+	const int res = mixChannels(len);
+
+	// Saturate the bus into the output buffer
+	for (uint i = 0; i != 2 * len; ++i)
+		buf[i] = (int16)CLIP<int32>(_mixBus[i], ST_SAMPLE_MIN, ST_SAMPLE_MAX);
+
+	return res;
+}
+
+int MixerImpl::mixCallbackFloat(float *samples, uint len) {
+	assert(samples);
+
+	Common::StackLock lock(_mutex);
+
+	// we store stereo, 32-bit float samples
+	assert(len % 8 == 0);
+	len >>= 3;
+
+	const int res = mixChannels(len);
+
+	// Saturate the bus into the output buffer
+	for (uint i = 0; i != 2 * len; ++i)
+		samples[i] = CLIP<int32>(_mixBus[i], ST_SAMPLE_MIN, ST_SAMPLE_MAX) * (1.0f / 32768.0f);
+
+	return res;
+}
+
 void MixerImpl::stopAll() {
 	Common::StackLock lock(_mutex);
-	for (int i = 0; i != NUM_CHANNELS; i++) {
+	for (uint i = 0; i != _channels.size(); i++) {
 		if (_channels[i] != 0 && !_channels[i]->isPermanent()) {
-			delete _channels[i];
-			_channels[i] = 0;
+			deleteChannel(i);
 		}
 	}
 }
 
 void MixerImpl::stopID(int id) {
 	Common::StackLock lock(_mutex);
-	for (int i = 0; i != NUM_CHANNELS; i++) {
+	for (uint i = 0; i != _channels.size(); i++) {
 		if (_channels[i] != 0 && _channels[i]->getId() == id) {
-			delete _channels[i];
-			_channels[i] = 0;
+			deleteChannel(i);
 		}
 	}
 }
@@ -324,19 +448,18 @@ void MixerImpl::stopHandle(SoundHandle handle) {
 	Common::StackLock lock(_mutex);
 
 	// Simply ignore stop requests for handles of sounds that already terminated
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	const uint index = handle._val % MAX_CHANNELS;
+	if (index >= _channels.size() || !_channels[index] || _channels[index]->getHandle()._val != handle._val)
 		return;
 
-	delete _channels[index];
-	_channels[index] = 0;
+	deleteChannel(index);
 }
 
 void MixerImpl::muteSoundType(SoundType type, bool mute) {
 	assert(0 <= (int)type && (int)type < ARRAYSIZE(_soundTypeSettings));
 	_soundTypeSettings[type].mute = mute;
 
-	for (int i = 0; i != NUM_CHANNELS; ++i) {
+	for (uint i = 0; i != _channels.size(); ++i) {
 		if (_channels[i] && _channels[i]->getType() == type)
 			_channels[i]->notifyGlobalVolChange();
 	}
@@ -348,39 +471,47 @@ bool MixerImpl::isSoundTypeMuted(SoundType type) const {
 }
 
 void MixerImpl::setChannelVolume(SoundHandle handle, byte volume) {
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_stateMutex);
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	ChannelState *state = findChannelState(handle);
+	if (!state)
 		return;
 
-	_channels[index]->setVolume(volume);
+	state->volume = volume;
+	state->dirty = true;
+	_pendingStateChanges = true;
 }
 
 byte MixerImpl::getChannelVolume(SoundHandle handle) {
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	Common::StackLock lock(_stateMutex);
+
+	const ChannelState *state = findChannelState(handle);
+	if (!state)
 		return 0;
 
-	return _channels[index]->getVolume();
+	return state->volume;
 }
 
 void MixerImpl::setChannelBalance(SoundHandle handle, int8 balance) {
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_stateMutex);
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	ChannelState *state = findChannelState(handle);
+	if (!state)
 		return;
 
-	_channels[index]->setBalance(balance);
+	state->balance = balance;
+	state->dirty = true;
+	_pendingStateChanges = true;
 }
 
 int8 MixerImpl::getChannelBalance(SoundHandle handle) {
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	Common::StackLock lock(_stateMutex);
+
+	const ChannelState *state = findChannelState(handle);
+	if (!state)
 		return 0;
 
-	return _channels[index]->getBalance();
+	return state->balance;
 }
 
 uint32 MixerImpl::getSoundElapsedTime(SoundHandle handle) {
@@ -390,8 +521,8 @@ uint32 MixerImpl::getSoundElapsedTime(SoundHandle handle) {
 Timestamp MixerImpl::getElapsedTime(SoundHandle handle) {
 	Common::StackLock lock(_mutex);
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	const uint index = handle._val % MAX_CHANNELS;
+	if (index >= _channels.size() || !_channels[index] || _channels[index]->getHandle()._val != handle._val)
 		return Timestamp(0, _sampleRate);
 
 	return _channels[index]->getElapsedTime();
@@ -399,7 +530,7 @@ Timestamp MixerImpl::getElapsedTime(SoundHandle handle) {
 
 void MixerImpl::pauseAll(bool paused) {
 	Common::StackLock lock(_mutex);
-	for (int i = 0; i != NUM_CHANNELS; i++) {
+	for (uint i = 0; i != _channels.size(); i++) {
 		if (_channels[i] != 0) {
 			_channels[i]->pause(paused);
 		}
@@ -408,7 +539,7 @@ void MixerImpl::pauseAll(bool paused) {
 
 void MixerImpl::pauseID(int id, bool paused) {
 	Common::StackLock lock(_mutex);
-	for (int i = 0; i != NUM_CHANNELS; i++) {
+	for (uint i = 0; i != _channels.size(); i++) {
 		if (_channels[i] != 0 && _channels[i]->getId() == id) {
 			_channels[i]->pause(paused);
 			return;
@@ -420,49 +551,48 @@ void MixerImpl::pauseHandle(SoundHandle handle, bool paused) {
 	Common::StackLock lock(_mutex);
 
 	// Simply ignore (un)pause requests for sounds that already terminated
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	const uint index = handle._val % MAX_CHANNELS;
+	if (index >= _channels.size() || !_channels[index] || _channels[index]->getHandle()._val != handle._val)
 		return;
 
 	_channels[index]->pause(paused);
 }
 
 bool MixerImpl::isSoundIDActive(int id) {
-	Common::StackLock lock(_mutex);
-
 #ifdef ENABLE_EVENTRECORDER
 	g_eventRec.updateSubsystems();
 #endif
 
-	for (int i = 0; i != NUM_CHANNELS; i++)
-		if (_channels[i] && _channels[i]->getId() == id)
+	Common::StackLock lock(_stateMutex);
+	for (uint i = 0; i != _channelStates.size(); i++)
+		if (_channelStates[i].isActive() && _channelStates[i].id == id)
 			return true;
 	return false;
 }
 
 int MixerImpl::getSoundID(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
-	const int index = handle._val % NUM_CHANNELS;
-	if (_channels[index] && _channels[index]->getHandle()._val == handle._val)
-		return _channels[index]->getId();
-	return 0;
+	Common::StackLock lock(_stateMutex);
+
+	const ChannelState *state = findChannelState(handle);
+	if (!state)
+		return 0;
+
+	return state->id;
 }
 
 bool MixerImpl::isSoundHandleActive(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
-
 #ifdef ENABLE_EVENTRECORDER
 	g_eventRec.updateSubsystems();
 #endif
 
-	const int index = handle._val % NUM_CHANNELS;
-	return _channels[index] && _channels[index]->getHandle()._val == handle._val;
+	Common::StackLock lock(_stateMutex);
+	return findChannelState(handle) != 0;
 }
 
 bool MixerImpl::hasActiveChannelOfType(SoundType type) {
-	Common::StackLock lock(_mutex);
-	for (int i = 0; i != NUM_CHANNELS; i++)
-		if (_channels[i] && _channels[i]->getType() == type)
+	Common::StackLock lock(_stateMutex);
+	for (uint i = 0; i != _channelStates.size(); i++)
+		if (_channelStates[i].isActive() && _channelStates[i].type == type)
 			return true;
 	return false;
 }
@@ -482,7 +612,7 @@ void MixerImpl::setVolumeForSoundType(SoundType type, int volume) {
 	Common::StackLock lock(_mutex);
 	_soundTypeSettings[type].volume = volume;
 
-	for (int i = 0; i != NUM_CHANNELS; ++i) {
+	for (uint i = 0; i != _channels.size(); ++i) {
 		if (_channels[i] && _channels[i]->getType() == type)
 			_channels[i]->notifyGlobalVolChange();
 	}
@@ -503,7 +633,7 @@ Channel::Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream,
                  DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent)
     : _type(type), _mixer(mixer), _id(id), _permanent(permanent), _volume(Mixer::kMaxChannelVolume),
       _balance(0), _pauseLevel(0), _samplesConsumed(0), _samplesDecoded(0), _mixerTimeStamp(0),
-      _pauseStartTime(0), _pauseTime(0), _converter(0), _volL(0), _volR(0),
+      _pauseStartTime(0), _pauseTime(0), _converter(0), _drained(false), _volL(0), _volR(0),
       _stream(stream, autofreeStream) {
 	assert(mixer);
 	assert(stream);
@@ -610,11 +740,9 @@ Timestamp Channel::getElapsedTime() {
 int Channel::mix(int16 *data, uint len) {
 	assert(_stream);
 
+	assert(_converter);
 	int res = 0;
-	if (_stream->endOfData()) {
-		// TODO: call drain method
-	} else {
-		assert(_converter);
+	if (!_stream->endOfData()) {
 		_samplesConsumed = _samplesDecoded;
 		_mixerTimeStamp = g_system->getMillis(true);
 		_pauseTime = 0;
@@ -622,6 +750,14 @@ int Channel::mix(int16 *data, uint len) {
 		_samplesDecoded += res;
 	}
 
+	// Once the stream has ended, play what the converter still holds
+	if (_stream->endOfStream() && !_drained && res < (int)len) {
+		const int drained = _converter->drain(data + res * 2, len - res, _volL, _volR);
+		_drained = (res + drained < (int)len);
+		_samplesDecoded += drained;
+		res += drained;
+	}
+
 	return res;
 }
 
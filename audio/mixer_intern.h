@@ -24,6 +24,7 @@
 #define AUDIO_MIXER_INTERN_H
 
 #include "common/scummsys.h"
+#include "common/array.h"
 #include "common/mutex.h"
 #include "audio/mixer.h"
 
@@ -51,11 +52,33 @@ namespace Audio {
 class MixerImpl : public Mixer {
 private:
 	enum {
-		NUM_CHANNELS = 16
+		/**
+		 * Number of channel slots allocated up front. The channel table grows
+		 * on demand when more streams are played simultaneously.
+		 */
+		INITIAL_CHANNELS = 16,
+
+		/**
+		 * Upper limit for the channel table. Also used for encoding the
+		 * channel index into sound handles, so it must be a power of two.
+		 */
+		MAX_CHANNELS = 256
 	};
 
+	/**
+	 * Protects the channel table and the channels themselves. This is held
+	 * by the audio thread for a complete mixing pass.
+	 */
 	Common::Mutex _mutex;
 
+	/**
+	 * Protects the published channel states. This is only ever held for
+	 * a few instructions, so game threads polling the state of sounds or
+	 * adjusting their volume never have to wait for a mixing pass to finish.
+	 * When both locks are needed, _mutex has to be acquired first.
+	 */
+	Common::Mutex _stateMutex;
+
 	const uint _sampleRate;
 	bool _mixerReady;
 	uint32 _handleSeed;
@@ -67,9 +90,41 @@ private:
 		int volume;
 	};
 
+	/**
+	 * Snapshot of a channel's state as seen by the game threads. Volume and
+	 * balance changes are recorded here and picked up by the audio thread at
+	 * the start of the next mixing pass.
+	 */
+	struct ChannelState {
+		ChannelState() : handle(0xFFFFFFFF), id(-1), type(kPlainSoundType), volume(0), balance(0), dirty(false) {}
+
+		uint32 handle;
+		int id;
+		SoundType type;
+		byte volume;
+		int8 balance;
+		bool dirty;
+
+		bool isActive() const { return handle != 0xFFFFFFFF; }
+	};
+
 	SoundTypeSettings _soundTypeSettings[4];
-	Channel *_channels[NUM_CHANNELS];
+	Common::Array<Channel *> _channels;
+	Common::Array<ChannelState> _channelStates;
+	bool _pendingStateChanges;
+
+	/**
+	 * The mix bus all channels are accumulated into. Samples are kept at
+	 * 32 bits, so overlapping loud channels only saturate once, when the
+	 * bus is converted into the output format.
+	 */
+	int32 *_mixBus;
 
+	/** Scratch buffer a single channel is rendered into. */
+	int16 *_channelBuffer;
+
+	/** Size of _mixBus and _channelBuffer in sample pairs. */
+	uint _mixBufferSize;
 
 public:
 
@@ -121,6 +176,35 @@ public:
 protected:
 	void insertChannel(SoundHandle *handle, Channel *chan);
 
+private:
+	/**
+	 * Looks up the channel state slot for the given handle.
+	 * Must be called with _stateMutex held.
+	 *
+	 * @return the slot, or 0 if the handle does not refer to an active sound
+	 */
+	ChannelState *findChannelState(SoundHandle handle);
+
+	/**
+	 * Deletes the channel in the given slot and unpublishes its state.
+	 * Must be called with _mutex held.
+	 */
+	void deleteChannel(uint index);
+
+	/**
+	 * Applies volume and balance changes requested by game threads since
+	 * the last mixing pass. Must be called with _mutex held.
+	 */
+	void applyPendingStateChanges();
+
+	/**
+	 * Mixes all channels into the mix bus. Must be called with _mutex held.
+	 *
+	 * @param len number of sample pairs to mix
+	 * @return number of sample pairs processed (which can still be silence!)
+	 */
+	int mixChannels(uint len);
+
 public:
 	/**
 	 * The mixer callback function, to be called at regular intervals by
@@ -133,6 +217,16 @@ public:
 	 */
 	int mixCallback(byte *samples, uint len);
 
+	/**
+	 * Variant of mixCallback() for backends whose audio device accepts
+	 * floating point samples natively.
+	 *
+	 * @param samples Sample buffer, in which stereo float samples in the range [-1.0, 1.0] will be stored.
+	 * @param len Length of the provided buffer to fill (in bytes, should be divisible by 8).
+	 * @return number of sample pairs processed (which can still be silence!)
+	 */
+	int mixCallbackFloat(float *samples, uint len);
+
 	/**
 	 * Set the internal 'is ready' flag of the mixer.
 	 * Backends should invoke Mixer::setReady(true) once initialisation of
@@ -31,10 +31,19 @@
 #include "audio/audiostream.h"
 #include "audio/rate.h"
 #include "audio/mixer.h"
+#include "common/config-manager.h"
 #include "common/frac.h"
 #include "common/textconsole.h"
 #include "common/util.h"
 
+#if defined(__SSE2__) && !defined(OUTPUT_UNSIGNED_AUDIO)
+#define RATE_MIX_SSE2
+#include <emmintrin.h>
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON)) && !defined(OUTPUT_UNSIGNED_AUDIO)
+#define RATE_MIX_NEON
+#include <arm_neon.h>
+#endif
+
 namespace Audio {
 
 
@@ -57,6 +66,97 @@ enum {
 	FRAC_HALF_LOW = (1L << (FRAC_BITS_LOW-1))
 };
 
+/**
+ * Number of sample pairs collected by the converters before they are
+ * scaled and mixed into the output buffer in one go.
+ */
+#define MIX_BLOCK_SIZE 256
+
+/**
+ * Mixes interleaved stereo sample pairs into the output buffer. The pairs
+ * have to be in output order already; vol0 applies to the first sample of
+ * each pair and vol1 to the second. The result is identical to calling
+ * clampedAdd() on every sample.
+ */
+static void mixStereoBlock(st_sample_t *obuf, const st_sample_t *src, st_size_t pairs, st_volume_t vol0, st_volume_t vol1) {
+	st_size_t done = 0;
+
+#if defined(RATE_MIX_SSE2) || defined(RATE_MIX_NEON)
+	// The vector code multiplies signed 16 bit values and divides by
+	// shifting, which only matches the scalar code under these conditions.
+	if (Audio::Mixer::kMaxMixerVolume == 256 && vol0 <= 0x7FFF && vol1 <= 0x7FFF) {
+#ifdef RATE_MIX_SSE2
+		const __m128i vol = _mm_set_epi16(vol1, vol0, vol1, vol0, vol1, vol0, vol1, vol0);
+
+		for (; done + 4 <= pairs; done += 4) {
+			const __m128i in = _mm_loadu_si128((const __m128i *)(src + done * 2));
+			const __m128i prodLo = _mm_mullo_epi16(in, vol);
+			const __m128i prodHi = _mm_mulhi_epi16(in, vol);
+			__m128i p0 = _mm_unpacklo_epi16(prodLo, prodHi);
+			__m128i p1 = _mm_unpackhi_epi16(prodLo, prodHi);
+
+			// Divide by 256, rounding towards zero like the C division does
+			p0 = _mm_srai_epi32(_mm_add_epi32(p0, _mm_srli_epi32(_mm_srai_epi32(p0, 31), 24)), 8);
+			p1 = _mm_srai_epi32(_mm_add_epi32(p1, _mm_srli_epi32(_mm_srai_epi32(p1, 31), 24)), 8);
+
+			__m128i *out = (__m128i *)(obuf + done * 2);
+			_mm_storeu_si128(out, _mm_adds_epi16(_mm_loadu_si128(out), _mm_packs_epi32(p0, p1)));
+		}
+#else
+		const int16 volArray[4] = { (int16)vol0, (int16)vol1, (int16)vol0, (int16)vol1 };
+		const int16x4_t vol = vld1_s16(volArray);
+
+		for (; done + 4 <= pairs; done += 4) {
+			const int16x8_t in = vld1q_s16(src + done * 2);
+			int32x4_t p0 = vmull_s16(vget_low_s16(in), vol);
+			int32x4_t p1 = vmull_s16(vget_high_s16(in), vol);
+
+			// Divide by 256, rounding towards zero like the C division does
+			p0 = vshrq_n_s32(vaddq_s32(p0, vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(vshrq_n_s32(p0, 31)), 24))), 8);
+			p1 = vshrq_n_s32(vaddq_s32(p1, vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(vshrq_n_s32(p1, 31)), 24))), 8);
+
+			int16 *out = obuf + done * 2;
+			vst1q_s16(out, vqaddq_s16(vld1q_s16(out), vcombine_s16(vqmovn_s32(p0), vqmovn_s32(p1))));
+		}
+#endif
+	}
+#endif
+
+	for (; done < pairs; ++done) {
+		clampedAdd(obuf[done * 2    ], (src[done * 2    ] * (int)vol0) / Audio::Mixer::kMaxMixerVolume);
+		clampedAdd(obuf[done * 2 + 1], (src[done * 2 + 1] * (int)vol1) / Audio::Mixer::kMaxMixerVolume);
+	}
+}
+
+/**
+ * Collects the unscaled output of a converter and hands it to
+ * mixStereoBlock() in blocks of MIX_BLOCK_SIZE sample pairs.
+ */
+template<bool reverseStereo>
+class MixBlockWriter {
+	st_sample_t *_obuf;
+	st_volume_t _vol0, _vol1;
+	st_size_t _count;
+	st_sample_t _pairs[MIX_BLOCK_SIZE * 2];
+
+public:
+	MixBlockWriter(st_sample_t *obuf, st_volume_t vol_l, st_volume_t vol_r)
+		: _obuf(obuf), _vol0(reverseStereo ? vol_r : vol_l), _vol1(reverseStereo ? vol_l : vol_r), _count(0) {}
+
+	void put(st_sample_t left, st_sample_t right) {
+		_pairs[_count * 2 + (reverseStereo ? 1 : 0)] = left;
+		_pairs[_count * 2 + (reverseStereo ? 0 : 1)] = right;
+		if (++_count == MIX_BLOCK_SIZE)
+			flush();
+	}
+
+	void flush() {
+		mixStereoBlock(_obuf, _pairs, _count, _vol0, _vol1);
+		_obuf += _count * 2;
+		_count = 0;
+	}
+};
+
 /**
  * Audio rate converter based on simple resampling. Used when no
  * interpolation is required.
@@ -80,7 +180,7 @@ protected:
 public:
 	SimpleRateConverter(st_rate_t inrate, st_rate_t outrate);
 	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
-	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
+	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 		return ST_SUCCESS;
 	}
 };
@@ -118,6 +218,8 @@ int SimpleRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 	ostart = obuf;
 	oend = obuf + osamp * 2;
 
+	MixBlockWriter<reverseStereo> writer(obuf, vol_l, vol_r);
+
 	while (obuf < oend) {
 
 		// read enough input samples so that opos >= 0
@@ -126,8 +228,10 @@ int SimpleRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 			if (inLen == 0) {
 				inPtr = inBuf;
 				inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
-				if (inLen <= 0)
+				if (inLen <= 0) {
+					writer.flush();
 					return (obuf - ostart) / 2;
+				}
 			}
 			inLen -= (stereo ? 2 : 1);
 			opos--;
@@ -143,14 +247,11 @@ int SimpleRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 		// Increment output position
 		opos += opos_inc;
 
-		// output left channel
-		clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
-
-		// output right channel
-		clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+		writer.put(out0, out1);
 
 		obuf += 2;
 	}
+	writer.flush();
 	return (obuf - ostart) / 2;
 }
 
@@ -186,7 +287,7 @@ protected:
 public:
 	LinearRateConverter(st_rate_t inrate, st_rate_t outrate);
 	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
-	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
+	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 		return ST_SUCCESS;
 	}
 };
@@ -227,6 +328,8 @@ int LinearRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 	ostart = obuf;
 	oend = obuf + osamp * 2;
 
+	MixBlockWriter<reverseStereo> writer(obuf, vol_l, vol_r);
+
 	while (obuf < oend) {
 
 		// read enough input samples so that opos < 0
@@ -235,8 +338,10 @@ int LinearRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 			if (inLen == 0) {
 				inPtr = inBuf;
 				inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
-				if (inLen <= 0)
+				if (inLen <= 0) {
+					writer.flush();
 					return (obuf - ostart) / 2;
+				}
 			}
 			inLen -= (stereo ? 2 : 1);
 			ilast0 = icur0;
@@ -258,11 +363,7 @@ int LinearRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 						  (st_sample_t)(ilast1 + (((icur1 - ilast1) * opos + FRAC_HALF_LOW) >> FRAC_BITS_LOW)) :
 						  out0);
 
-			// output left channel
-			clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
-
-			// output right channel
-			clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+			writer.put(out0, out1);
 
 			obuf += 2;
 
@@ -270,6 +371,7 @@ int LinearRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 			opos += opos_inc;
 		}
 	}
+	writer.flush();
 	return (obuf - ostart) / 2;
 }
 
@@ -315,24 +417,29 @@ public:
 		len = input.readBuffer(_buffer, osamp);
 
 		// Mix the data into the output buffer
+		if (stereo && !reverseStereo) {
+			// The samples are in output order already
+			mixStereoBlock(obuf, _buffer, len / 2, vol_l, vol_r);
+			return len / 2;
+		}
+
+		MixBlockWriter<reverseStereo> writer(obuf, vol_l, vol_r);
+
 		ptr = _buffer;
 		for (; len > 0; len -= (stereo ? 2 : 1)) {
 			st_sample_t out0, out1;
 			out0 = *ptr++;
 			out1 = (stereo ? *ptr++ : out0);
 
-			// output left channel
-			clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
-
-			// output right channel
-			clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+			writer.put(out0, out1);
 
 			obuf += 2;
 		}
+		writer.flush();
 		return (obuf - ostart) / 2;
 	}
 
-	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
+	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 		return ST_SUCCESS;
 	}
 };
@@ -340,10 +447,284 @@ public:
 
 #pragma mark -
 
+
+enum {
+	/** Number of input frames each output sample of the sinc filter depends on. */
+	SINC_TAPS = 16,
+	/** Number of precomputed sub-sample positions of the filter. */
+	SINC_PHASES = 128,
+	/** Number of input frames buffered per channel by the sinc converter. */
+	SINC_BUFFER_FRAMES = INTERMEDIATE_BUFFER_SIZE + SINC_TAPS
+};
+
+/**
+ * Computes the dot product of one filter phase with SINC_TAPS samples.
+ * The coefficients are normalized to 1.0 == 32768, so the result has to be
+ * shifted right by 15 bits.
+ */
+static inline int32 sincDotProduct(const int16 *coeffs, const int16 *samples) {
+#if defined(RATE_MIX_SSE2)
+	__m128i sum = _mm_madd_epi16(_mm_load_si128((const __m128i *)coeffs), _mm_loadu_si128((const __m128i *)samples));
+	sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_load_si128((const __m128i *)(coeffs + 8)), _mm_loadu_si128((const __m128i *)(samples + 8))));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtsi128_si32(sum);
+#elif defined(RATE_MIX_NEON)
+	int32x4_t sum = vmull_s16(vld1_s16(coeffs), vld1_s16(samples));
+	sum = vmlal_s16(sum, vld1_s16(coeffs + 4), vld1_s16(samples + 4));
+	sum = vmlal_s16(sum, vld1_s16(coeffs + 8), vld1_s16(samples + 8));
+	sum = vmlal_s16(sum, vld1_s16(coeffs + 12), vld1_s16(samples + 12));
+	const int32x2_t half = vadd_s32(vget_low_s32(sum), vget_high_s32(sum));
+	return vget_lane_s32(vpadd_s32(half, half), 0);
+#else
+	int32 sum = 0;
+	for (int i = 0; i < SINC_TAPS; ++i)
+		sum += coeffs[i] * samples[i];
+	return sum;
+#endif
+}
+
+/**
+ * Audio rate converter based on a windowed sinc (polyphase FIR) filter.
+ *
+ * Compared to LinearRateConverter, this greatly reduces aliasing when
+ * upsampling low rate material like 11025 Hz speech, at the cost of
+ * SINC_TAPS multiply-adds per output sample and channel. The filter bank is
+ * computed once per converter; the filtering itself uses fixed point
+ * arithmetic only.
+ *
+ * Limited to sampling frequency < 131072 Hz.
+ */
 template<bool stereo, bool reverseStereo>
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate) {
+class SincRateConverter : public RateConverter {
+protected:
+	st_sample_t inBuf[INTERMEDIATE_BUFFER_SIZE];
+
+	/** filter coefficients, SINC_TAPS per phase */
+	int16 *_coeffs;
+
+	/** buffered input frames, one plane per channel */
+	int16 _frames[2][SINC_BUFFER_FRAMES];
+	/** number of valid frames in _frames */
+	int _frameCount;
+	/** first input frame the next output sample depends on */
+	int _framePos;
+	/**
+	 * number of frames required beyond the filter before an output sample
+	 * is written, so that it is known whether the input still covers it
+	 */
+	int _lookAhead;
+
+	const st_rate_t _inRate;
+	const st_rate_t _outRate;
+
+	/** number of input and output frames processed so far */
+	uint64 _inputFrames;
+	uint64 _outputFrames;
+
+	/** whether the input has ended and _frames is padded with silence */
+	bool _inputEnded;
+	/** number of output frames for the whole input, once it has ended */
+	uint64 _outputEnd;
+
+	/** fractional position of the output stream in input stream unit */
+	frac_t opos;
+
+	/** fractional position increment in the output stream */
+	frac_t opos_inc;
+
+	bool refill(AudioStream *input);
+	int convert(AudioStream *input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
+
+public:
+	SincRateConverter(st_rate_t inrate, st_rate_t outrate);
+	~SincRateConverter();
+	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+		return convert(&input, obuf, osamp, vol_l, vol_r);
+	}
+	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+		return convert(0, obuf, osamp, vol_l, vol_r);
+	}
+};
+
+/*
+ * Prepare processing.
+ */
+template<bool stereo, bool reverseStereo>
+SincRateConverter<stereo, reverseStereo>::SincRateConverter(st_rate_t inrate, st_rate_t outrate)
+	: _inRate(inrate), _outRate(outrate), _inputFrames(0), _outputFrames(0), _inputEnded(false), _outputEnd(0) {
+	if (inrate >= 131072 || outrate >= 131072) {
+		error("rate effect can only handle rates < 131072");
+	}
+
+	opos = 0;
+	opos_inc = (inrate << FRAC_BITS_LOW) / outrate;
+
+	// An output sample belongs to the input if the input reaches half an
+	// output sample beyond it. The filter already looks SINC_TAPS / 2
+	// frames ahead, which only falls short when downsampling a lot.
+	_lookAhead = CLIP<int>((((opos_inc + 1) / 2 + FRAC_ONE_LOW - 1) >> FRAC_BITS_LOW) - SINC_TAPS / 2, 0, INTERMEDIATE_BUFFER_SIZE / 4);
+
+	// Low pass at the lower of both Nyquist frequencies, with a little
+	// headroom for the transition band of the short filter.
+	const double cutoff = 0.9 * MIN<double>(1.0, (double)outrate / inrate);
+
+	// The buffers are aligned for the vector code
+	_coeffs = (int16 *)malloc(SINC_PHASES * SINC_TAPS * sizeof(int16) + 16);
+	if (!_coeffs)
+		error("[SincRateConverter] Cannot allocate memory for filter bank");
+	int16 *coeffs = (int16 *)(((size_t)_coeffs + 15) & ~(size_t)15);
+
+	for (int phase = 0; phase < SINC_PHASES; ++phase) {
+		double taps[SINC_TAPS];
+		double sum = 0.0;
+
+		for (int i = 0; i < SINC_TAPS; ++i) {
+			// Distance of the input frame from the output position
+			const double x = (i - (SINC_TAPS / 2 - 1)) - (double)phase / SINC_PHASES;
+			const double arg = M_PI * cutoff * x;
+			const double sinc = (x == 0.0) ? 1.0 : sin(arg) / arg;
+			// Blackman window spanning all taps
+			const double w = (x + SINC_TAPS / 2) / SINC_TAPS;
+			const double window = 0.42 - 0.5 * cos(2 * M_PI * w) + 0.08 * cos(4 * M_PI * w);
+
+			taps[i] = sinc * window;
+			sum += taps[i];
+		}
+
+		// Normalize each phase to unity gain, so DC passes unchanged
+		for (int i = 0; i < SINC_TAPS; ++i)
+			coeffs[phase * SINC_TAPS + i] = (int16)floor(taps[i] / sum * 32768.0 + 0.5);
+	}
+
+	// Start with silence in front of the first frame, so that the first
+	// output sample is centered on the first input frame.
+	memset(_frames, 0, sizeof(_frames));
+	_frameCount = SINC_TAPS / 2 - 1;
+	_framePos = 0;
+}
+
+template<bool stereo, bool reverseStereo>
+SincRateConverter<stereo, reverseStereo>::~SincRateConverter() {
+	free(_coeffs);
+}
+
+/*
+ * Discard frames that are no longer needed and read new ones. Without an
+ * input, or at the end of the input, pad the frames with silence once, so
+ * that the filter reaches the last input frames.
+ * Return false when the input is exhausted.
+ */
+template<bool stereo, bool reverseStereo>
+bool SincRateConverter<stereo, reverseStereo>::refill(AudioStream *input) {
+	if (_framePos >= _frameCount) {
+		// When downsampling by more than SINC_TAPS, the filter can move
+		// past all buffered frames. Frames read into the skipped part are
+		// dropped by the next refill.
+		_framePos -= _frameCount;
+		_frameCount = 0;
+	} else if (_framePos > 0) {
+		const int keep = _frameCount - _framePos;
+		memmove(_frames[0], _frames[0] + _framePos, keep * sizeof(int16));
+		if (stereo)
+			memmove(_frames[1], _frames[1] + _framePos, keep * sizeof(int16));
+		_frameCount = keep;
+		_framePos = 0;
+	}
+
+	if (_inputEnded)
+		return false;
+
+	const int space = MIN<int>(SINC_BUFFER_FRAMES - _frameCount, INTERMEDIATE_BUFFER_SIZE / 2);
+	const int len = input ? input->readBuffer(inBuf, space * (stereo ? 2 : 1)) : 0;
+	if (len <= 0) {
+		if (input && !input->endOfStream())
+			return false;
+
+		for (int i = 0; i < SINC_TAPS / 2 + _lookAhead; ++i) {
+			_frames[0][_frameCount] = 0;
+			_frames[1][_frameCount] = 0;
+			_frameCount++;
+		}
+
+		// Output as many frames as the input covers, rounded to nearest
+		_inputEnded = true;
+		_outputEnd = (_inputFrames * _outRate * 2 + _inRate) / (2 * _inRate);
+		return true;
+	}
+
+	_inputFrames += len / (stereo ? 2 : 1);
+
+	const st_sample_t *inPtr = inBuf;
+	for (int i = 0; i < len / (stereo ? 2 : 1); ++i) {
+		_frames[0][_frameCount] = *inPtr++;
+		if (stereo)
+			_frames[1][_frameCount] = *inPtr++;
+		_frameCount++;
+	}
+
+	return true;
+}
+
+/*
+ * Processed signed long samples from ibuf to obuf. Without an input, drain
+ * the frames that are still buffered.
+ * Return number of sample pairs processed.
+ */
+template<bool stereo, bool reverseStereo>
+int SincRateConverter<stereo, reverseStereo>::convert(AudioStream *input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+	st_sample_t *ostart, *oend;
+
+	ostart = obuf;
+	oend = obuf + osamp * 2;
+
+	const int16 *coeffs = (const int16 *)(((size_t)_coeffs + 15) & ~(size_t)15);
+
+	MixBlockWriter<reverseStereo> writer(obuf, vol_l, vol_r);
+
+	while (obuf < oend) {
+		// Make sure all frames covered by the filter are available
+		while (_framePos + SINC_TAPS + _lookAhead > _frameCount) {
+			if (!refill(input)) {
+				writer.flush();
+				return (obuf - ostart) / 2;
+			}
+		}
+
+		if (_inputEnded && _outputFrames >= _outputEnd)
+			break;
+
+		const int16 *phase = coeffs + ((opos * SINC_PHASES) >> FRAC_BITS_LOW) * SINC_TAPS;
+
+		st_sample_t out0, out1;
+		out0 = (st_sample_t)CLIP<int32>((sincDotProduct(phase, _frames[0] + _framePos) + FRAC_HALF_LOW) >> FRAC_BITS_LOW, ST_SAMPLE_MIN, ST_SAMPLE_MAX);
+		out1 = (stereo ?
+		        (st_sample_t)CLIP<int32>((sincDotProduct(phase, _frames[1] + _framePos) + FRAC_HALF_LOW) >> FRAC_BITS_LOW, ST_SAMPLE_MIN, ST_SAMPLE_MAX) :
+		        out0);
+
+		writer.put(out0, out1);
+
+		obuf += 2;
+		_outputFrames++;
+
+		// Increment output position
+		opos += opos_inc;
+		_framePos += opos >> FRAC_BITS_LOW;
+		opos &= FRAC_ONE_LOW - 1;
+	}
+	writer.flush();
+	return (obuf - ostart) / 2;
+}
+
+
+#pragma mark -
+
+template<bool stereo, bool reverseStereo>
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool highQuality) {
 	if (inrate != outrate) {
-		if ((inrate % outrate) == 0 && (inrate < 65536)) {
+		if (highQuality) {
+			return new SincRateConverter<stereo, reverseStereo>(inrate, outrate);
+		} else if ((inrate % outrate) == 0 && (inrate < 65536)) {
 			return new SimpleRateConverter<stereo, reverseStereo>(inrate, outrate);
 		} else {
 			return new LinearRateConverter<stereo, reverseStereo>(inrate, outrate);
@@ -357,13 +738,16 @@ RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate) {
  * Create and return a RateConverter object for the specified input and output rates.
  */
 RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo) {
+	// The "resampler" config key selects the windowed sinc converter
+	const bool highQuality = ConfMan.hasKey("resampler") && ConfMan.get("resampler") == "sinc";
+
 	if (stereo) {
 		if (reverseStereo)
-			return makeRateConverter<true, true>(inrate, outrate);
+			return makeRateConverter<true, true>(inrate, outrate, highQuality);
 		else
-			return makeRateConverter<true, false>(inrate, outrate);
+			return makeRateConverter<true, false>(inrate, outrate, highQuality);
 	} else
-		return makeRateConverter<false, false>(inrate, outrate);
+		return makeRateConverter<false, false>(inrate, outrate, highQuality);
 }
 
 } // End of namespace Audio
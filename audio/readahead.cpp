@@ -0,0 +1,263 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/array.h"
+#include "common/singleton.h"
+#include "common/system.h"
+#include "common/textconsole.h"
+#include "common/timer.h"
+#include "common/util.h"
+
+#include "audio/readahead.h"
+
+namespace Audio {
+
+/**
+ * Keeps track of all active ReadAheadAudioStreams and fills them from a
+ * single timer callback.
+ *
+ * The callback is installed when the first stream is registered, and it
+ * removes itself once no streams are left. It is not removed from the stream
+ * destructor: streams are usually destroyed from the audio thread while it
+ * holds the mixer lock, and other timer callbacks wait for that lock while
+ * the timer manager holds its own. For the same reason the timer manager is
+ * never called with _mutex held, except from the callback itself.
+ */
+class ReadAheadScheduler : public Common::Singleton<ReadAheadScheduler> {
+public:
+	ReadAheadScheduler() : _timerInstalled(false) {}
+
+	/**
+	 * Adds a stream to the ones filled by the timer callback. Returns false
+	 * if no timer could be installed, in which case the stream is not added.
+	 */
+	bool registerStream(ReadAheadAudioStream *stream) {
+		bool installTimer;
+		{
+			Common::StackLock lock(_mutex);
+			_streams.push_back(stream);
+			installTimer = !_timerInstalled;
+			_timerInstalled = true;
+		}
+
+		if (installTimer) {
+			Common::TimerManager *timerManager = g_system->getTimerManager();
+			if (!timerManager || !timerManager->installTimerProc(&timerProc, kFillInterval, this, "readAheadAudio")) {
+				warning("ReadAheadScheduler: Could not install timer, audio is decoded on demand");
+
+				Common::StackLock lock(_mutex);
+				_timerInstalled = false;
+				unregisterStreamLocked(stream);
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	/**
+	 * Removes a stream from the ones filled by the timer callback, waiting
+	 * for a running fill() call to finish.
+	 */
+	void unregisterStream(ReadAheadAudioStream *stream) {
+		Common::StackLock lock(_mutex);
+		unregisterStreamLocked(stream);
+	}
+
+private:
+	enum {
+		/** Interval of the fill callback, in microseconds. */
+		kFillInterval = 10000,
+
+		/**
+		 * Amount of audio decoded per stream and callback at most, in
+		 * milliseconds. Anything above the interval lets the ring buffer
+		 * catch up, but limits how long the callback blocks the timer
+		 * thread, which the MIDI drivers use, too.
+		 */
+		kMaxFillTime = 40
+	};
+
+	void unregisterStreamLocked(ReadAheadAudioStream *stream) {
+		for (uint i = 0; i < _streams.size(); ++i) {
+			if (_streams[i] == stream) {
+				_streams.remove_at(i);
+				break;
+			}
+		}
+	}
+
+	static void timerProc(void *refCon) {
+		ReadAheadScheduler *scheduler = (ReadAheadScheduler *)refCon;
+
+		Common::StackLock lock(scheduler->_mutex);
+		if (scheduler->_streams.empty()) {
+			// The timer manager allows removing the running callback
+			g_system->getTimerManager()->removeTimerProc(&timerProc);
+			scheduler->_timerInstalled = false;
+			return;
+		}
+
+		for (uint i = 0; i < scheduler->_streams.size(); ++i) {
+			ReadAheadAudioStream *stream = scheduler->_streams[i];
+			stream->fill(stream->getRate() * (stream->isStereo() ? 2 : 1) * kMaxFillTime / 1000);
+		}
+	}
+
+	Common::Mutex _mutex;
+	Common::Array<ReadAheadAudioStream *> _streams;
+	bool _timerInstalled;
+};
+
+ReadAheadAudioStream::ReadAheadAudioStream(SeekableAudioStream *stream, uint32 leadTime, DisposeAfterUse::Flag disposeAfterUse)
+	: _stream(stream, disposeAfterUse), _stereo(stream->isStereo()), _rate(stream->getRate()), _length(stream->getLength()),
+	  _buffer(0), _bufferSize(0), _readPos(0), _bufferedSamples(0), _streamFinished(false),
+	  _synchronous(false), _underruns(0), _underrunSamples(0) {
+
+	_bufferSize = MAX<uint32>((uint32)((uint64)leadTime * _rate / 1000) * (_stereo ? 2 : 1), 4096);
+	_buffer = (int16 *)malloc(_bufferSize * sizeof(int16));
+	if (!_buffer)
+		error("ReadAheadAudioStream: Cannot allocate memory for ring buffer");
+
+	// Start with a full buffer, so playback does not begin with an underrun
+	fill();
+
+	_synchronous = !ReadAheadScheduler::instance().registerStream(this);
+}
+
+ReadAheadAudioStream::~ReadAheadAudioStream() {
+	if (!_synchronous)
+		ReadAheadScheduler::instance().unregisterStream(this);
+
+	free(_buffer);
+}
+
+int ReadAheadAudioStream::readBuffer(int16 *buffer, const int numSamples) {
+	int samples = readFromRingBuffer(buffer, numSamples);
+
+	// Without a timer nobody else fills the ring buffer, so decode here
+	while (_synchronous && samples < numSamples) {
+		fill();
+
+		const int read = readFromRingBuffer(buffer + samples, numSamples - samples);
+		if (read == 0)
+			break;
+		samples += read;
+	}
+
+	Common::StackLock lock(_bufferMutex);
+	if (samples < numSamples && !_streamFinished) {
+		_underruns++;
+		_underrunSamples += numSamples - samples;
+	}
+
+	return samples;
+}
+
+int ReadAheadAudioStream::readFromRingBuffer(int16 *buffer, const int numSamples) {
+	Common::StackLock lock(_bufferMutex);
+
+	const int samples = MIN<int>(numSamples, _bufferedSamples);
+
+	// Copy out of the ring buffer in at most two pieces
+	const uint32 firstPart = MIN<uint32>(samples, _bufferSize - _readPos);
+	memcpy(buffer, _buffer + _readPos, firstPart * sizeof(int16));
+	memcpy(buffer + firstPart, _buffer, (samples - firstPart) * sizeof(int16));
+
+	_readPos = (_readPos + samples) % _bufferSize;
+	_bufferedSamples -= samples;
+
+	return samples;
+}
+
+bool ReadAheadAudioStream::endOfData() const {
+	Common::StackLock lock(_bufferMutex);
+	return _streamFinished && _bufferedSamples == 0;
+}
+
+void ReadAheadAudioStream::fill(uint32 maxSamples) {
+	Common::StackLock streamLock(_streamMutex);
+
+	while (maxSamples > 0) {
+		uint32 writePos, space;
+		{
+			Common::StackLock lock(_bufferMutex);
+			if (_streamFinished)
+				return;
+
+			writePos = (_readPos + _bufferedSamples) % _bufferSize;
+			// Only fill up to the end of the ring buffer in one go
+			space = MIN<uint32>(_bufferSize - _bufferedSamples, _bufferSize - writePos);
+		}
+
+		space = MIN(space, maxSamples);
+
+		// Keep stereo samples paired
+		if (_stereo)
+			space &= ~1;
+		if (space == 0)
+			return;
+
+		// Decode without holding the buffer lock. The reader never touches
+		// the free part of the ring buffer.
+		const int samples = _stream->readBuffer(_buffer + writePos, space);
+
+		Common::StackLock lock(_bufferMutex);
+		if (samples > 0) {
+			_bufferedSamples += samples;
+			maxSamples -= samples;
+		}
+
+		if (samples < (int)space && _stream->endOfData())
+			_streamFinished = true;
+		else if (samples <= 0)
+			return;
+	}
+}
+
+bool ReadAheadAudioStream::seek(const Timestamp &where) {
+	Common::StackLock streamLock(_streamMutex);
+	Common::StackLock lock(_bufferMutex);
+
+	_readPos = 0;
+	_bufferedSamples = 0;
+	_streamFinished = false;
+
+	const bool result = _stream->seek(where);
+	if (_stream->endOfData())
+		_streamFinished = true;
+
+	return result;
+}
+
+ReadAheadAudioStream *makeReadAheadAudioStream(SeekableAudioStream *stream, uint32 leadTime, DisposeAfterUse::Flag disposeAfterUse) {
+	if (!stream)
+		return 0;
+
+	return new ReadAheadAudioStream(stream, leadTime, disposeAfterUse);
+}
+
+} // End of namespace Audio
+
+namespace Common {
+DECLARE_SINGLETON(Audio::ReadAheadScheduler);
+}
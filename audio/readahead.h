@@ -0,0 +1,122 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef AUDIO_READAHEAD_H
+#define AUDIO_READAHEAD_H
+
+#include "common/scummsys.h"
+#include "common/mutex.h"
+#include "common/types.h"
+
+#include "audio/audiostream.h"
+
+namespace Audio {
+
+/**
+ * A wrapper which decodes another SeekableAudioStream ahead of time.
+ *
+ * Decoders like MP3, Vorbis or FLAC normally do their work inside
+ * readBuffer(), i.e. on the audio thread. A slow disk read or a large frame
+ * can then stall the mixer. This wrapper instead decodes the wrapped stream
+ * from a timer callback into a ring buffer, keeping a configurable amount of
+ * audio ready. readBuffer() only copies from that ring buffer.
+ *
+ * If the ring buffer runs empty, readBuffer() returns fewer samples than
+ * requested rather than decoding synchronously, and the event is counted as
+ * an underrun. Only if no timer can be installed, readBuffer() decodes
+ * synchronously instead.
+ */
+class ReadAheadAudioStream : public SeekableAudioStream {
+public:
+	/**
+	 * @param stream          The stream to decode ahead of time.
+	 * @param leadTime        Amount of audio to keep decoded, in milliseconds.
+	 * @param disposeAfterUse Whether the wrapped stream should be destroyed on destruction of this stream.
+	 */
+	ReadAheadAudioStream(SeekableAudioStream *stream, uint32 leadTime, DisposeAfterUse::Flag disposeAfterUse = DisposeAfterUse::YES);
+	~ReadAheadAudioStream();
+
+	int readBuffer(int16 *buffer, const int numSamples);
+
+	bool isStereo() const { return _stereo; }
+	int getRate() const { return _rate; }
+	bool endOfData() const;
+
+	bool seek(const Timestamp &where);
+	Timestamp getLength() const { return _length; }
+
+	/**
+	 * Decodes data from the wrapped stream until the ring buffer is full,
+	 * or until the given number of samples has been decoded. This is called
+	 * periodically from a timer callback.
+	 */
+	void fill(uint32 maxSamples = 0xFFFFFFFF);
+
+	/** Returns how often readBuffer() could not be satisfied completely. */
+	uint32 getUnderruns() const { return _underruns; }
+
+	/** Returns the total number of samples missing in underruns. */
+	uint32 getUnderrunSamples() const { return _underrunSamples; }
+
+private:
+	/** Copies as many samples as available out of the ring buffer. */
+	int readFromRingBuffer(int16 *buffer, const int numSamples);
+
+	Common::DisposablePtr<SeekableAudioStream> _stream;
+	const bool _stereo;
+	const int _rate;
+	const Timestamp _length;
+
+	/**
+	 * Protects the wrapped stream. Held while decoding, so seeking has to
+	 * wait for a running fill() call to finish.
+	 */
+	Common::Mutex _streamMutex;
+
+	/** Protects the ring buffer. Only held for copying samples. */
+	Common::Mutex _bufferMutex;
+
+	int16 *_buffer;
+	uint32 _bufferSize;
+	uint32 _readPos;
+	uint32 _bufferedSamples;
+	bool _streamFinished;
+
+	/** Whether readBuffer() decodes itself, since there is no timer. */
+	bool _synchronous;
+
+	uint32 _underruns;
+	uint32 _underrunSamples;
+};
+
+/**
+ * Factory function for a ReadAheadAudioStream.
+ *
+ * @param stream          The stream to decode ahead of time.
+ * @param leadTime        Amount of audio to keep decoded, in milliseconds.
+ * @param disposeAfterUse Whether the wrapped stream should be destroyed on destruction of the returned stream.
+ */
+ReadAheadAudioStream *makeReadAheadAudioStream(SeekableAudioStream *stream, uint32 leadTime = 500, DisposeAfterUse::Flag disposeAfterUse = DisposeAfterUse::YES);
+
+} // End of namespace Audio
+
+#endif
@@ -126,6 +126,14 @@ public:
 	 */
 	virtual Common::String getDisplayName() const { return getName(); }
 
+	/**
+	 * Returns the modification time and the size of the file, if the
+	 * filesystem can tell them without opening it.
+	 *
+	 * @note By default, this method returns false.
+	 */
+	virtual bool getStamp(uint32 &modificationTime, uint32 &size) const { return false; }
+
 	/**
 	 * Returns the last component of the path pointed by this FSNode.
 	 *
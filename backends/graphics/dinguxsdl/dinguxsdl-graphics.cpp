@@ -290,6 +290,8 @@ void DINGUXSdlGraphicsManager::internUpdateScreen() {
 	if (_mouseNeedsRedraw)
 		undrawMouse();
 
+	flushDirtyRegion();
+
 	// Force a full redraw if requested
 	if (_forceFull) {
 		_numDirtyRects = 1;
@@ -405,6 +407,8 @@ void DINGUXSdlGraphicsManager::internUpdateScreen() {
 		SDL_UpdateRects(_hwscreen, _numDirtyRects, _dirtyRectList);
 	}
 
+	reportFrameStatistics();
+
 	_numDirtyRects = 0;
 	_forceFull = false;
 	_mouseNeedsRedraw = false;
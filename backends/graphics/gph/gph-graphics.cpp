@@ -319,6 +319,8 @@ void GPHGraphicsManager::internUpdateScreen() {
 	if (_mouseNeedsRedraw)
 		undrawMouse();
 
+	flushDirtyRegion();
+
 	// Force a full redraw if requested
 	if (_forceFull) {
 		_numDirtyRects = 1;
@@ -436,6 +438,8 @@ void GPHGraphicsManager::internUpdateScreen() {
 		SDL_UpdateRects(_hwscreen, _numDirtyRects, _dirtyRectList);
 	}
 
+	reportFrameStatistics();
+
 	_numDirtyRects = 0;
 	_forceFull = false;
 	_mouseNeedsRedraw = false;
@@ -0,0 +1,479 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "backends/graphics/headless/headless-graphics.h"
+#include "common/endian.h"
+#include "common/textconsole.h"
+
+static const OSystem::GraphicsMode s_headlessGraphicsModes[] = {
+	{"1x", "Normal (no scaling)", GFX_HEADLESS_NORMAL},
+#ifdef USE_SCALERS
+	{"2x", "2x", GFX_HEADLESS_DOUBLESIZE},
+	{"3x", "3x", GFX_HEADLESS_TRIPLESIZE},
+	{"advmame2x", "AdvMAME2x", GFX_HEADLESS_ADVMAME2X},
+	{"advmame3x", "AdvMAME3x", GFX_HEADLESS_ADVMAME3X},
+#ifdef USE_HQ_SCALERS
+	{"hq2x", "HQ2x", GFX_HEADLESS_HQ2X},
+	{"hq3x", "HQ3x", GFX_HEADLESS_HQ3X},
+#endif
+#endif
+	{0, 0, 0}
+};
+
+HeadlessGraphicsManager::HeadlessGraphicsManager()
+	: _mode(GFX_HEADLESS_NORMAL), _pendingMode(GFX_HEADLESS_NORMAL),
+	  _scaleFactor(1), _scalerProc(Normal1x),
+	  _pendingWidth(320), _pendingHeight(200), _screenChangeID(0),
+	  _screenFormat(Graphics::PixelFormat::createFormatCLUT8()),
+	  _pendingFormat(Graphics::PixelFormat::createFormatCLUT8()),
+	  _outputFormat(2, 5, 6, 5, 0, 11, 5, 0, 0),
+	  _overlayVisible(false), _forceFull(true),
+	  _cursorPaletteEnabled(false), _cursorVisible(false), _mouseX(0), _mouseY(0) {
+
+	memset(_palette, 0, sizeof(_palette));
+	memset(_paletteMap, 0, sizeof(_paletteMap));
+	memset(_cursorPalette, 0, sizeof(_cursorPalette));
+
+	_cursor.w = _cursor.h = 0;
+	_cursor.hotspotX = _cursor.hotspotY = 0;
+	_cursor.keycolor = 0;
+	_cursor.dontScale = false;
+	_cursor.format = Graphics::PixelFormat::createFormatCLUT8();
+
+	// The smoothing scalers need their color masks set up
+	InitScalers(565);
+
+	_pendingMode = getDefaultGraphicsMode();
+	setupScreen();
+}
+
+HeadlessGraphicsManager::~HeadlessGraphicsManager() {
+	_screen.free();
+	_source.free();
+	_overlay.free();
+	_output.free();
+
+	DestroyScalers();
+}
+
+bool HeadlessGraphicsManager::hasFeature(OSystem::Feature f) {
+	return f == OSystem::kFeatureCursorPalette;
+}
+
+void HeadlessGraphicsManager::setFeatureState(OSystem::Feature f, bool enable) {
+	if (f == OSystem::kFeatureCursorPalette)
+		_cursorPaletteEnabled = enable;
+}
+
+bool HeadlessGraphicsManager::getFeatureState(OSystem::Feature f) {
+	if (f == OSystem::kFeatureCursorPalette)
+		return _cursorPaletteEnabled;
+	return false;
+}
+
+const OSystem::GraphicsMode *HeadlessGraphicsManager::getSupportedGraphicsModes() const {
+	return s_headlessGraphicsModes;
+}
+
+int HeadlessGraphicsManager::getDefaultGraphicsMode() const {
+#ifdef USE_SCALERS
+	return GFX_HEADLESS_DOUBLESIZE;
+#else
+	return GFX_HEADLESS_NORMAL;
+#endif
+}
+
+bool HeadlessGraphicsManager::setGraphicsMode(int mode) {
+	for (const OSystem::GraphicsMode *m = s_headlessGraphicsModes; m->name; ++m) {
+		if (m->id == mode) {
+			_pendingMode = mode;
+			return true;
+		}
+	}
+
+	warning("HeadlessGraphicsManager::setGraphicsMode: unknown mode %d", mode);
+	return false;
+}
+
+void HeadlessGraphicsManager::resetGraphicsScale() {
+	setGraphicsMode(GFX_HEADLESS_NORMAL);
+}
+
+#ifdef USE_RGB_COLOR
+Common::List<Graphics::PixelFormat> HeadlessGraphicsManager::getSupportedFormats() const {
+	Common::List<Graphics::PixelFormat> list;
+	list.push_back(_outputFormat);
+	list.push_back(Graphics::PixelFormat::createFormatCLUT8());
+	return list;
+}
+#endif
+
+void HeadlessGraphicsManager::initSize(uint width, uint height, const Graphics::PixelFormat *format) {
+	_pendingWidth = width;
+	_pendingHeight = height;
+	_pendingFormat = format ? *format : Graphics::PixelFormat::createFormatCLUT8();
+}
+
+OSystem::TransactionError HeadlessGraphicsManager::endGFXTransaction() {
+	int errors = OSystem::kTransactionSuccess;
+
+	if (_pendingFormat != Graphics::PixelFormat::createFormatCLUT8() && _pendingFormat != _outputFormat) {
+		_pendingFormat = Graphics::PixelFormat::createFormatCLUT8();
+		errors |= OSystem::kTransactionFormatNotSupported;
+	}
+
+	setupScreen();
+
+	return (OSystem::TransactionError)errors;
+}
+
+void HeadlessGraphicsManager::setupScreen() {
+	switch (_pendingMode) {
+#ifdef USE_SCALERS
+	case GFX_HEADLESS_DOUBLESIZE:
+		_scaleFactor = 2;
+		_scalerProc = Normal2x;
+		break;
+	case GFX_HEADLESS_TRIPLESIZE:
+		_scaleFactor = 3;
+		_scalerProc = Normal3x;
+		break;
+	case GFX_HEADLESS_ADVMAME2X:
+		_scaleFactor = 2;
+		_scalerProc = AdvMame2x;
+		break;
+	case GFX_HEADLESS_ADVMAME3X:
+		_scaleFactor = 3;
+		_scalerProc = AdvMame3x;
+		break;
+#ifdef USE_HQ_SCALERS
+	case GFX_HEADLESS_HQ2X:
+		_scaleFactor = 2;
+		_scalerProc = HQ2x;
+		break;
+	case GFX_HEADLESS_HQ3X:
+		_scaleFactor = 3;
+		_scalerProc = HQ3x;
+		break;
+#endif
+#endif
+	default:
+		_scaleFactor = 1;
+		_scalerProc = Normal1x;
+		break;
+	}
+	_mode = _pendingMode;
+
+	if (_screen.w != (int)_pendingWidth || _screen.h != (int)_pendingHeight || _screen.format != _pendingFormat) {
+		_screen.create(_pendingWidth, _pendingHeight, _pendingFormat);
+		_screenFormat = _pendingFormat;
+		++_screenChangeID;
+	}
+
+	const uint outputWidth = _screen.w * _scaleFactor;
+	const uint outputHeight = _screen.h * _scaleFactor;
+
+	if (_output.w != (int)outputWidth || _output.h != (int)outputHeight) {
+		_output.create(outputWidth, outputHeight, _outputFormat);
+		_overlay.create(outputWidth, outputHeight, _outputFormat);
+		++_screenChangeID;
+	}
+
+	// Like the SDL backend, keep a border around the converted screen, since
+	// some scalers read the pixels around each source pixel.
+	_source.create(_screen.w + 3, _screen.h + 3, _outputFormat);
+
+	_dirtyRegion.clear();
+	_forceFull = true;
+}
+
+void HeadlessGraphicsManager::setPalette(const byte *colors, uint start, uint num) {
+	assert(colors);
+	assert(start + num <= 256);
+
+	memcpy(_palette + 3 * start, colors, 3 * num);
+	for (uint i = start; i < start + num; ++i)
+		_paletteMap[i] = mapColor(_palette, i, Graphics::PixelFormat::createFormatCLUT8());
+
+	if (_screenFormat.bytesPerPixel == 1)
+		_forceFull = true;
+}
+
+void HeadlessGraphicsManager::grabPalette(byte *colors, uint start, uint num) {
+	assert(colors);
+	assert(start + num <= 256);
+
+	memcpy(colors, _palette + 3 * start, 3 * num);
+}
+
+void HeadlessGraphicsManager::copyRectToScreen(const void *buf, int pitch, int x, int y, int w, int h) {
+	assert(buf);
+	assert(x >= 0 && x + w <= _screen.w);
+	assert(y >= 0 && y + h <= _screen.h);
+
+	_screen.copyRectToSurface(buf, pitch, x, y, w, h);
+	addDirtyRect(x, y, w, h);
+}
+
+Graphics::Surface *HeadlessGraphicsManager::lockScreen() {
+	return &_screen;
+}
+
+void HeadlessGraphicsManager::unlockScreen() {
+	_forceFull = true;
+}
+
+void HeadlessGraphicsManager::fillScreen(uint32 col) {
+	_screen.fillRect(Common::Rect(_screen.w, _screen.h), col);
+	_forceFull = true;
+}
+
+void HeadlessGraphicsManager::updateScreen() {
+	convertScreen();
+	scaleScreen();
+	drawCursor();
+}
+
+void HeadlessGraphicsManager::addDirtyRect(int x, int y, int w, int h) {
+	if (_forceFull)
+		return;
+
+	// Extend the dirty region by 1 pixel for scalers that "smear" the
+	// screen, and clip it.
+	Common::Rect r(x - 1, y - 1, x + w + 1, y + h + 1);
+	r.clip(_screen.w, _screen.h);
+	if (r.isEmpty())
+		return;
+
+	_dirtyRegion.add(r);
+
+	if (_dirtyRegion.getRects().size() > 256)
+		_dirtyRegion.limit(64);
+}
+
+void HeadlessGraphicsManager::convertScreen() {
+	_scaleRects.clear();
+
+	if (_overlayVisible)
+		return;
+
+	if (_forceFull) {
+		_scaleRects.push_back(Common::Rect(_screen.w, _screen.h));
+		_forceFull = false;
+	} else {
+		_scaleRects = _dirtyRegion.getRects();
+	}
+	_dirtyRegion.clear();
+
+	for (uint i = 0; i < _scaleRects.size(); ++i) {
+		const Common::Rect &r = _scaleRects[i];
+
+		for (int y = r.top; y < r.bottom; ++y) {
+			uint16 *dst = (uint16 *)_source.getBasePtr(r.left + 1, y + 1);
+
+			if (_screenFormat.bytesPerPixel == 1) {
+				const byte *src = (const byte *)_screen.getBasePtr(r.left, y);
+				for (int x = 0; x < r.width(); ++x)
+					dst[x] = _paletteMap[src[x]];
+			} else {
+				memcpy(dst, _screen.getBasePtr(r.left, y), r.width() * 2);
+			}
+		}
+	}
+}
+
+uint32 HeadlessGraphicsManager::scaleScreen() {
+	if (_overlayVisible) {
+		_output.copyRectToSurface(_overlay, 0, 0, Common::Rect(_overlay.w, _overlay.h));
+		return _output.w * _output.h;
+	}
+
+	uint32 pixels = 0;
+
+	for (uint i = 0; i < _scaleRects.size(); ++i) {
+		const Common::Rect &r = _scaleRects[i];
+
+		_scalerProc((const uint8 *)_source.getBasePtr(r.left + 1, r.top + 1), _source.pitch,
+			(uint8 *)_output.getBasePtr(r.left * _scaleFactor, r.top * _scaleFactor), _output.pitch,
+			r.width(), r.height());
+
+		pixels += r.width() * r.height() * _scaleFactor * _scaleFactor;
+	}
+
+	return pixels;
+}
+
+uint16 HeadlessGraphicsManager::mapColor(const byte *palette, uint32 color, const Graphics::PixelFormat &format) const {
+	if (format.bytesPerPixel == 1)
+		return _outputFormat.RGBToColor(palette[3 * color], palette[3 * color + 1], palette[3 * color + 2]);
+
+	byte r, g, b;
+	format.colorToRGB(color, r, g, b);
+	return _outputFormat.RGBToColor(r, g, b);
+}
+
+void HeadlessGraphicsManager::drawCursor() {
+	if (!_cursorVisible || _cursor.data.empty())
+		return;
+
+	const int posScale = _overlayVisible ? 1 : _scaleFactor;
+	const int scale = (_overlayVisible || _cursor.dontScale) ? 1 : _scaleFactor;
+	const byte *palette = _cursorPaletteEnabled ? _cursorPalette : _palette;
+	const uint bpp = _cursor.format.bytesPerPixel;
+
+	const int x0 = _mouseX * posScale - _cursor.hotspotX * scale;
+	const int y0 = _mouseY * posScale - _cursor.hotspotY * scale;
+
+	for (uint cy = 0; cy < _cursor.h; ++cy) {
+		const byte *src = &_cursor.data[cy * _cursor.w * bpp];
+
+		for (uint cx = 0; cx < _cursor.w; ++cx, src += bpp) {
+			uint32 color;
+			if (bpp == 1)
+				color = *src;
+			else if (bpp == 2)
+				color = READ_UINT16(src);
+			else
+				color = READ_UINT32(src);
+
+			if (color == _cursor.keycolor)
+				continue;
+
+			const uint16 outColor = mapColor(palette, color, _cursor.format);
+
+			Common::Rect block(x0 + cx * scale, y0 + cy * scale, x0 + (cx + 1) * scale, y0 + (cy + 1) * scale);
+			block.clip(_output.w, _output.h);
+			for (int y = block.top; y < block.bottom; ++y) {
+				uint16 *dst = (uint16 *)_output.getBasePtr(block.left, y);
+				for (int x = 0; x < block.width(); ++x)
+					dst[x] = outColor;
+			}
+		}
+	}
+
+	// Restore the area below the cursor on the next update
+	if (!_overlayVisible) {
+		const int left = x0 / posScale;
+		const int top = y0 / posScale;
+		const int right = (x0 + (int)_cursor.w * scale + posScale - 1) / posScale;
+		const int bottom = (y0 + (int)_cursor.h * scale + posScale - 1) / posScale;
+		addDirtyRect(left, top, right - left, bottom - top);
+	}
+}
+
+void HeadlessGraphicsManager::showOverlay() {
+	_overlayVisible = true;
+}
+
+void HeadlessGraphicsManager::hideOverlay() {
+	_overlayVisible = false;
+	_forceFull = true;
+}
+
+void HeadlessGraphicsManager::clearOverlay() {
+	// Show the scaled game screen below the overlay, like the SDL backend
+	const bool overlayVisible = _overlayVisible;
+	_overlayVisible = false;
+	_forceFull = true;
+
+	convertScreen();
+	scaleScreen();
+
+	_overlayVisible = overlayVisible;
+	_overlay.copyRectToSurface(_output, 0, 0, Common::Rect(_output.w, _output.h));
+}
+
+void HeadlessGraphicsManager::grabOverlay(void *buf, int pitch) {
+	assert(buf);
+
+	byte *dst = (byte *)buf;
+	for (int y = 0; y < _overlay.h; ++y, dst += pitch)
+		memcpy(dst, _overlay.getBasePtr(0, y), _overlay.w * _overlay.format.bytesPerPixel);
+}
+
+void HeadlessGraphicsManager::copyRectToOverlay(const void *buf, int pitch, int x, int y, int w, int h) {
+	const byte *src = (const byte *)buf;
+
+	// Clip the coordinates
+	if (x < 0) {
+		w += x;
+		src -= x * 2;
+		x = 0;
+	}
+
+	if (y < 0) {
+		h += y;
+		src -= y * pitch;
+		y = 0;
+	}
+
+	if (w > _overlay.w - x)
+		w = _overlay.w - x;
+
+	if (h > _overlay.h - y)
+		h = _overlay.h - y;
+
+	if (w <= 0 || h <= 0)
+		return;
+
+	_overlay.copyRectToSurface(src, pitch, x, y, w, h);
+}
+
+bool HeadlessGraphicsManager::showMouse(bool visible) {
+	const bool last = _cursorVisible;
+	_cursorVisible = visible;
+	return last;
+}
+
+void HeadlessGraphicsManager::warpMouse(int x, int y) {
+	_mouseX = x;
+	_mouseY = y;
+}
+
+void HeadlessGraphicsManager::setMouseCursor(const void *buf, uint w, uint h, int hotspotX, int hotspotY, uint32 keycolor, bool dontScale, const Graphics::PixelFormat *format) {
+	_cursor.format = format ? *format : Graphics::PixelFormat::createFormatCLUT8();
+	if (_cursor.format.bytesPerPixel == 3) {
+		warning("HeadlessGraphicsManager::setMouseCursor: 24bpp cursors are not supported");
+		_cursor.data.clear();
+		return;
+	}
+
+	_cursor.w = w;
+	_cursor.h = h;
+	_cursor.hotspotX = hotspotX;
+	_cursor.hotspotY = hotspotY;
+	_cursor.keycolor = keycolor;
+	_cursor.dontScale = dontScale;
+
+	const uint size = w * h * _cursor.format.bytesPerPixel;
+	_cursor.data.resize(size);
+	if (size)
+		memcpy(&_cursor.data[0], buf, size);
+}
+
+void HeadlessGraphicsManager::setCursorPalette(const byte *colors, uint start, uint num) {
+	assert(colors);
+	assert(start + num <= 256);
+
+	memcpy(_cursorPalette + 3 * start, colors, 3 * num);
+	_cursorPaletteEnabled = true;
+}
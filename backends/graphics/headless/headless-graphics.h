@@ -0,0 +1,178 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BACKENDS_GRAPHICS_HEADLESS_H
+#define BACKENDS_GRAPHICS_HEADLESS_H
+
+#include "backends/graphics/graphics.h"
+#include "common/dirtyregion.h"
+#include "graphics/scaler.h"
+#include "graphics/surface.h"
+
+enum {
+	GFX_HEADLESS_NORMAL = 0,
+	GFX_HEADLESS_DOUBLESIZE = 1,
+	GFX_HEADLESS_TRIPLESIZE = 2,
+	GFX_HEADLESS_ADVMAME2X = 3,
+	GFX_HEADLESS_ADVMAME3X = 4,
+	GFX_HEADLESS_HQ2X = 5,
+	GFX_HEADLESS_HQ3X = 6
+};
+
+/**
+ * Graphics manager which renders into memory only.
+ *
+ * Unlike NullGraphicsManager it keeps real game, overlay and output surfaces
+ * and does all the work a display backend would do on updateScreen(): color
+ * conversion of the dirty areas, scaling and cursor drawing. The result is
+ * never shown anywhere, which makes it suitable for measuring the rendering
+ * cost of engines without a display.
+ *
+ * updateScreen() is split into the public steps convertScreen(),
+ * scaleScreen() and drawCursor(), so that callers can time them separately.
+ */
+class HeadlessGraphicsManager : public GraphicsManager {
+public:
+	HeadlessGraphicsManager();
+	virtual ~HeadlessGraphicsManager();
+
+	virtual bool hasFeature(OSystem::Feature f);
+	virtual void setFeatureState(OSystem::Feature f, bool enable);
+	virtual bool getFeatureState(OSystem::Feature f);
+
+	virtual const OSystem::GraphicsMode *getSupportedGraphicsModes() const;
+	virtual int getDefaultGraphicsMode() const;
+	virtual bool setGraphicsMode(int mode);
+	virtual void resetGraphicsScale();
+	virtual int getGraphicsMode() const { return _mode; }
+#ifdef USE_RGB_COLOR
+	virtual Graphics::PixelFormat getScreenFormat() const { return _screenFormat; }
+	virtual Common::List<Graphics::PixelFormat> getSupportedFormats() const;
+#endif
+	virtual void initSize(uint width, uint height, const Graphics::PixelFormat *format = NULL);
+	virtual int getScreenChangeID() const { return _screenChangeID; }
+
+	virtual void beginGFXTransaction() {}
+	virtual OSystem::TransactionError endGFXTransaction();
+
+	virtual int16 getHeight() { return _screen.h; }
+	virtual int16 getWidth() { return _screen.w; }
+	virtual void setPalette(const byte *colors, uint start, uint num);
+	virtual void grabPalette(byte *colors, uint start, uint num);
+	virtual void copyRectToScreen(const void *buf, int pitch, int x, int y, int w, int h);
+	virtual Graphics::Surface *lockScreen();
+	virtual void unlockScreen();
+	virtual void fillScreen(uint32 col);
+	virtual void updateScreen();
+	virtual void setShakePos(int shakeOffset) {}
+	virtual void setFocusRectangle(const Common::Rect& rect) {}
+	virtual void clearFocusRectangle() {}
+
+	virtual void showOverlay();
+	virtual void hideOverlay();
+	virtual Graphics::PixelFormat getOverlayFormat() const { return _overlay.format; }
+	virtual void clearOverlay();
+	virtual void grabOverlay(void *buf, int pitch);
+	virtual void copyRectToOverlay(const void *buf, int pitch, int x, int y, int w, int h);
+	virtual int16 getOverlayHeight() { return _overlay.h; }
+	virtual int16 getOverlayWidth() { return _overlay.w; }
+
+	virtual bool showMouse(bool visible);
+	virtual void warpMouse(int x, int y);
+	virtual void setMouseCursor(const void *buf, uint w, uint h, int hotspotX, int hotspotY, uint32 keycolor, bool dontScale = false, const Graphics::PixelFormat *format = NULL);
+	virtual void setCursorPalette(const byte *colors, uint start, uint num);
+
+	/**
+	 * Convert the dirty areas of the game screen to the output pixel format.
+	 */
+	void convertScreen();
+
+	/**
+	 * Scale the converted areas, or the overlay when it is shown, to the
+	 * output surface.
+	 *
+	 * @return the number of output pixels written
+	 */
+	uint32 scaleScreen();
+
+	/**
+	 * Draw the mouse cursor onto the output surface.
+	 */
+	void drawCursor();
+
+	/**
+	 * Return the surface updateScreen() renders to.
+	 */
+	const Graphics::Surface &getOutputSurface() const { return _output; }
+
+private:
+	void setupScreen();
+	void addDirtyRect(int x, int y, int w, int h);
+	uint16 mapColor(const byte *palette, uint32 color, const Graphics::PixelFormat &format) const;
+
+	int _mode;
+	int _pendingMode;
+	uint _scaleFactor;
+	ScalerProc *_scalerProc;
+
+	uint _pendingWidth, _pendingHeight;
+	int _screenChangeID;
+
+	Graphics::PixelFormat _screenFormat;
+	Graphics::PixelFormat _pendingFormat;
+	Graphics::PixelFormat _outputFormat;
+
+	/** The game screen, in the game pixel format. */
+	Graphics::Surface _screen;
+	/** The game screen in the output format, with a border for the scalers. */
+	Graphics::Surface _source;
+	/** The overlay, at output resolution. */
+	Graphics::Surface _overlay;
+	/** The final, scaled image. */
+	Graphics::Surface _output;
+
+	bool _overlayVisible;
+
+	byte _palette[3 * 256];
+	uint16 _paletteMap[256];
+
+	Common::DirtyRegion _dirtyRegion;
+	Common::Array<Common::Rect> _scaleRects;
+	bool _forceFull;
+
+	struct Cursor {
+		Common::Array<byte> data;
+		uint w, h;
+		int hotspotX, hotspotY;
+		uint32 keycolor;
+		bool dontScale;
+		Graphics::PixelFormat format;
+	} _cursor;
+
+	byte _cursorPalette[3 * 256];
+	bool _cursorPaletteEnabled;
+	bool _cursorVisible;
+	int _mouseX, _mouseY;
+	Common::Rect _cursorRect;
+};
+
+#endif
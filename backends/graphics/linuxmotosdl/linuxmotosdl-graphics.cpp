@@ -331,6 +331,8 @@ void LinuxmotoSdlGraphicsManager::internUpdateScreen() {
 	if (_mouseNeedsRedraw)
 		undrawMouse();
 
+	flushDirtyRegion();
+
 	// Force a full redraw if requested
 	if (_forceFull) {
 		_numDirtyRects = 1;
@@ -447,6 +449,8 @@ void LinuxmotoSdlGraphicsManager::internUpdateScreen() {
 		SDL_UpdateRects(_hwscreen, _numDirtyRects, _dirtyRectList);
 	}
 
+	reportFrameStatistics();
+
 	_numDirtyRects = 0;
 	_forceFull = false;
 	_mouseNeedsRedraw = false;
@@ -28,6 +28,7 @@
 #include "backends/events/sdl/sdl-events.h"
 #include "backends/platform/sdl/sdl.h"
 #include "common/config-manager.h"
+#include "common/debug.h"
 #include "common/mutex.h"
 #include "common/textconsole.h"
 #include "common/translation.h"
@@ -146,6 +147,7 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 	_screenIsLocked(false),
 	_graphicsMutex(0),
 	_displayDisabled(false),
+	_dirtyRegionFlushed(0), _numDirtyRects(0), _frameRectsSubmitted(0), _framePixelsScaled(0),
 #ifdef USE_SDL_DEBUG_FOCUSRECT
 	_enableFocusRectDebugCode(false), _enableFocusRect(false), _focusRect(),
 #endif
@@ -1099,6 +1101,8 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 	if (_mouseNeedsRedraw)
 		undrawMouse();
 
+	bool moreRects = flushDirtyRegion(true);
+
 	// Force a full redraw if requested
 	if (_forceFull) {
 		_numDirtyRects = 1;
@@ -1115,59 +1119,76 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 		uint32 srcPitch, dstPitch;
 		SDL_Rect *lastRect = _dirtyRectList + _numDirtyRects;
 
-		for (r = _dirtyRectList; r != lastRect; ++r) {
-			dst = *r;
-			dst.x++;	// Shift rect by one since 2xSai needs to access the data around
-			dst.y++;	// any pixel to scale it, and we want to avoid mem access crashes.
+		// The dirty region is drawn in batches, if it has more rectangles
+		// than fit into the dirty rect list at once
+		for (;;) {
+			for (r = _dirtyRectList; r != lastRect; ++r) {
+				dst = *r;
+				dst.x++;	// Shift rect by one since 2xSai needs to access the data around
+				dst.y++;	// any pixel to scale it, and we want to avoid mem access crashes.
 
-			if (SDL_BlitSurface(origSurf, r, srcSurf, &dst) != 0)
-				error("SDL_BlitSurface failed: %s", SDL_GetError());
-		}
+				if (SDL_BlitSurface(origSurf, r, srcSurf, &dst) != 0)
+					error("SDL_BlitSurface failed: %s", SDL_GetError());
+			}
 
-		SDL_LockSurface(srcSurf);
-		SDL_LockSurface(_hwscreen);
+			SDL_LockSurface(srcSurf);
+			SDL_LockSurface(_hwscreen);
 
-		srcPitch = srcSurf->pitch;
-		dstPitch = _hwscreen->pitch;
+			srcPitch = srcSurf->pitch;
+			dstPitch = _hwscreen->pitch;
 
-		for (r = _dirtyRectList; r != lastRect; ++r) {
-			register int dst_y = r->y + _currentShakePos;
-			register int dst_h = 0;
+			for (r = _dirtyRectList; r != lastRect; ++r) {
+				register int dst_y = r->y + _currentShakePos;
+				register int dst_h = 0;
 #ifdef USE_SCALERS
-			register int orig_dst_y = 0;
+				register int orig_dst_y = 0;
 #endif
-			register int rx1 = r->x * scale1;
+				register int rx1 = r->x * scale1;
 
-			if (dst_y < height) {
-				dst_h = r->h;
-				if (dst_h > height - dst_y)
-					dst_h = height - dst_y;
+				if (dst_y < height) {
+					dst_h = r->h;
+					if (dst_h > height - dst_y)
+						dst_h = height - dst_y;
 
 #ifdef USE_SCALERS
-				orig_dst_y = dst_y;
+					orig_dst_y = dst_y;
 #endif
-				dst_y = dst_y * scale1;
+					dst_y = dst_y * scale1;
 
-				if (_videoMode.aspectRatioCorrection && !_overlayVisible)
-					dst_y = real2Aspect(dst_y);
+					if (_videoMode.aspectRatioCorrection && !_overlayVisible)
+						dst_y = real2Aspect(dst_y);
 
-				assert(scalerProc != NULL);
-				scalerProc((byte *)srcSurf->pixels + (r->x * 2 + 2) + (r->y + 1) * srcPitch, srcPitch,
-					(byte *)_hwscreen->pixels + rx1 * 2 + dst_y * dstPitch, dstPitch, r->w, dst_h);
-			}
+					assert(scalerProc != NULL);
+					scalerProc((byte *)srcSurf->pixels + (r->x * 2 + 2) + (r->y + 1) * srcPitch, srcPitch,
+						(byte *)_hwscreen->pixels + rx1 * 2 + dst_y * dstPitch, dstPitch, r->w, dst_h);
+					_framePixelsScaled += r->w * dst_h;
+				}
 
-			r->x = rx1;
-			r->y = dst_y;
-			r->w = r->w * scale1;
-			r->h = dst_h * scale1;
+				r->x = rx1;
+				r->y = dst_y;
+				r->w = r->w * scale1;
+				r->h = dst_h * scale1;
 
 #ifdef USE_SCALERS
-			if (_videoMode.aspectRatioCorrection && orig_dst_y < height && !_overlayVisible)
-				r->h = stretch200To240((uint8 *) _hwscreen->pixels, dstPitch, r->w, r->h, r->x, r->y, orig_dst_y * scale1);
+				if (_videoMode.aspectRatioCorrection && orig_dst_y < height && !_overlayVisible)
+					r->h = stretch200To240((uint8 *) _hwscreen->pixels, dstPitch, r->w, r->h, r->x, r->y, orig_dst_y * scale1);
 #endif
+			}
+			SDL_UnlockSurface(srcSurf);
+			SDL_UnlockSurface(_hwscreen);
+
+			if (!moreRects)
+				break;
+
+			// Update the screen with this batch and go on with the next one.
+			// The mouse cursor is only drawn with the last batch.
+			if (!_displayDisabled) {
+				SDL_UpdateRects(_hwscreen, _numDirtyRects, _dirtyRectList);
+			}
+			_numDirtyRects = 0;
+			moreRects = flushDirtyRegion(true);
+			lastRect = _dirtyRectList + _numDirtyRects;
 		}
-		SDL_UnlockSurface(srcSurf);
-		SDL_UnlockSurface(_hwscreen);
 
 		// Readjust the dirty rect list in case we are doing a full update.
 		// This is necessary if shaking is active.
@@ -1262,11 +1283,59 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 		}
 	}
 
+	reportFrameStatistics();
+
 	_numDirtyRects = 0;
 	_forceFull = false;
 	_mouseNeedsRedraw = false;
 }
 
+bool SurfaceSdlGraphicsManager::flushDirtyRegion(bool inBatches) {
+	// Rectangles in real coordinates are added directly to the list
+	const int freeRects = NUM_DIRTY_RECT - 1 - _numDirtyRects;
+
+	if (freeRects <= 0)
+		_forceFull = true;
+
+	if (_forceFull) {
+		_dirtyRegion.clear();
+		_dirtyRegionFlushed = 0;
+		return false;
+	}
+
+	if (!inBatches)
+		_dirtyRegion.limit(freeRects);
+
+	const Common::Array<Common::Rect> &rects = _dirtyRegion.getRects();
+	const uint end = MIN<uint>(rects.size(), _dirtyRegionFlushed + freeRects);
+
+	for (uint i = _dirtyRegionFlushed; i < end; ++i) {
+		SDL_Rect *r = &_dirtyRectList[_numDirtyRects++];
+
+		r->x = rects[i].left;
+		r->y = rects[i].top;
+		r->w = rects[i].width();
+		r->h = rects[i].height();
+	}
+
+	if (end < rects.size()) {
+		_dirtyRegionFlushed = end;
+		return true;
+	}
+
+	_dirtyRegion.clear();
+	_dirtyRegionFlushed = 0;
+	return false;
+}
+
+void SurfaceSdlGraphicsManager::reportFrameStatistics() {
+	if (_frameRectsSubmitted != 0 || _framePixelsScaled != 0)
+		debug(9, "SurfaceSdlGraphicsManager: %u dirty rects submitted, %u pixels scaled", _frameRectsSubmitted, _framePixelsScaled);
+
+	_frameRectsSubmitted = 0;
+	_framePixelsScaled = 0;
+}
+
 bool SurfaceSdlGraphicsManager::saveScreenshot(const char *filename) {
 	assert(_hwscreen != NULL);
 
@@ -1403,7 +1472,7 @@ void SurfaceSdlGraphicsManager::addDirtyRect(int x, int y, int w, int h, bool re
 	if (_forceFull)
 		return;
 
-	if (_numDirtyRects == NUM_DIRTY_RECT) {
+	if (realCoordinates && _numDirtyRects == NUM_DIRTY_RECT) {
 		_forceFull = true;
 		return;
 	}
@@ -1458,12 +1527,20 @@ void SurfaceSdlGraphicsManager::addDirtyRect(int x, int y, int w, int h, bool re
 	}
 
 	if (w > 0 && h > 0) {
-		SDL_Rect *r = &_dirtyRectList[_numDirtyRects++];
+		++_frameRectsSubmitted;
+
+		if (realCoordinates) {
+			// These are only added by drawMouse(), after the dirty region
+			// has been flushed, and do not need any scaling.
+			SDL_Rect *r = &_dirtyRectList[_numDirtyRects++];
 
-		r->x = x;
-		r->y = y;
-		r->w = w;
-		r->h = h;
+			r->x = x;
+			r->y = y;
+			r->w = w;
+			r->h = h;
+		} else {
+			_dirtyRegion.add(Common::Rect(x, y, x + w, y + h));
+		}
 	}
 }
 
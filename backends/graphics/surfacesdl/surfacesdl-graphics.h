@@ -27,6 +27,7 @@
 #include "backends/graphics/sdl/sdl-graphics.h"
 #include "graphics/pixelformat.h"
 #include "graphics/scaler.h"
+#include "common/dirtyregion.h"
 #include "common/events.h"
 #include "common/system.h"
 
@@ -289,9 +290,15 @@ protected:
 	};
 
 	// Dirty rect management
+	Common::DirtyRegion _dirtyRegion;
+	uint _dirtyRegionFlushed;	///< Rectangles of _dirtyRegion already in _dirtyRectList
 	SDL_Rect _dirtyRectList[NUM_DIRTY_RECT];
 	int _numDirtyRects;
 
+	// Per frame statistics, printed at debug level 9
+	uint _frameRectsSubmitted;
+	uint32 _framePixelsScaled;
+
 	struct MousePos {
 		// The mouse position, using either virtual (game) or real
 		// (overlay) coordinates.
@@ -360,6 +367,22 @@ protected:
 
 	virtual void addDirtyRect(int x, int y, int w, int h, bool realCoordinates = false);
 
+	/**
+	 * Move the accumulated dirty region into _dirtyRectList. Needs to be
+	 * called by internUpdateScreen() after the mouse cursor has been undrawn.
+	 * One list entry is kept free for the cursor drawn afterwards.
+	 *
+	 * If the region has more rectangles than fit into the list, they are
+	 * merged until they do. With inBatches set, only the rectangles which
+	 * fit are moved instead, and the rest is kept for the next call.
+	 *
+	 * @return true if rectangles are left for another batch
+	 */
+	bool flushDirtyRegion(bool inBatches = false);
+
+	/** Print and reset the per frame statistics. */
+	void reportFrameStatistics();
+
 	virtual void drawMouse();
 	virtual void undrawMouse();
 	virtual void blitCursor();
@@ -531,6 +531,10 @@ void WINCESdlGraphicsManager::internUpdateScreen() {
 		update_scalers();
 	}
 
+	// Move the rectangles queued by addDirtyRect() and drawMouse() into
+	// the dirty rect list
+	flushDirtyRegion();
+
 	// Force a full redraw if requested
 	if (_forceFull) {
 		_numDirtyRects = 1;
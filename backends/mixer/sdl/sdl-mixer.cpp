@@ -87,8 +87,9 @@ void SdlMixerManager::init() {
 
 	// The obtained sample format is not supported by the mixer, call
 	// SDL_OpenAudio again with NULL as the second argument to force
-	// SDL to do resampling to the desired audio spec.
-	if (_obtained.format != desired.format) {
+	// SDL to do resampling to the desired audio spec. Devices with native
+	// float output are fed by the mixer directly to skip the conversion.
+	if (_obtained.format != desired.format && !isFloatOutput()) {
 		debug(1, "SDL mixer sound format: %d differs from desired: %d", _obtained.format, desired.format);
 		SDL_CloseAudio();
 
@@ -159,9 +160,20 @@ void SdlMixerManager::startAudio() {
 	SDL_PauseAudio(0);
 }
 
+bool SdlMixerManager::isFloatOutput() const {
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+	return supportsFloatOutput() && _obtained.format == AUDIO_F32SYS;
+#else
+	return false;
+#endif
+}
+
 void SdlMixerManager::callbackHandler(byte *samples, int len) {
 	assert(_mixer);
-	_mixer->mixCallback(samples, len);
+	if (isFloatOutput())
+		_mixer->mixCallbackFloat((float *)samples, len);
+	else
+		_mixer->mixCallback(samples, len);
 }
 
 void SdlMixerManager::sdlCallback(void *this_, byte *samples, int len) {
@@ -82,6 +82,19 @@ protected:
 	 */
 	virtual void startAudio();
 
+	/**
+	 * Whether callbackHandler() can fill the audio buffer with float
+	 * samples, which allows using devices with a native float format
+	 * without conversion by SDL. Subclasses which handle the sample
+	 * buffers themselves should return false.
+	 */
+	virtual bool supportsFloatOutput() const { return true; }
+
+	/**
+	 * Returns true if the opened audio device expects float samples.
+	 */
+	bool isFloatOutput() const;
+
 	/**
 	 * Handles the audio callback
 	 */
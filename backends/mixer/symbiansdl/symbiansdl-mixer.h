@@ -38,6 +38,7 @@ protected:
 
 	virtual void startAudio();
 	virtual void callbackHandler(byte *samples, int len);
+	virtual bool supportsFloatOutput() const { return false; }
 };
 
 #endif
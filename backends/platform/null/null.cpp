@@ -27,6 +27,7 @@
 #define FORBIDDEN_SYMBOL_EXCEPTION_stdout
 #define FORBIDDEN_SYMBOL_EXCEPTION_stderr
 #define FORBIDDEN_SYMBOL_EXCEPTION_fputs
+#define FORBIDDEN_SYMBOL_EXCEPTION_time_h
 
 #include "backends/modular-backend.h"
 #include "base/main.h"
@@ -37,8 +38,16 @@
 #include "backends/events/default/default-events.h"
 #include "backends/mutex/null/null-mutex.h"
 #include "backends/graphics/null/null-graphics.h"
+#include "backends/graphics/headless/headless-graphics.h"
 #include "audio/mixer_intern.h"
+#include "common/config-manager.h"
+#include "common/fs.h"
 #include "common/scummsys.h"
+#include "common/textconsole.h"
+
+#if defined(POSIX)
+#include <sys/time.h>
+#endif
 
 /*
  * Include header files needed for the getFilesystemFactory() method.
@@ -65,10 +74,56 @@ public:
 	virtual void delayMillis(uint msecs);
 	virtual void getTimeAndDate(TimeDate &t) const {}
 
+	virtual void updateScreen();
+
 	virtual void logMessage(LogMessageType::Type type, const char *message);
+
+private:
+	/**
+	 * Timings of one frame, i.e. the time between two updateScreen() calls,
+	 * in microseconds of real time.
+	 */
+	struct FrameTiming {
+		uint32 virtualTime;
+		uint32 engineTime;
+		uint32 updateScreenTime;
+		uint32 scaleTime;
+		uint32 mixTime;
+		uint32 timerTime;
+		uint32 scaledPixels;
+	};
+
+	/** Whether getWallMicros() measures anything on this platform */
+	static bool hasWallClock();
+	static uint32 getWallMicros();
+
+	void advanceVirtualTime(uint msecs);
+	static Common::String formatMicros(uint32 micros, bool json);
+	void writeBenchmarkResults();
+
+	/**
+	 * Whether the headless benchmark mode is active. It is enabled by
+	 * setting the "benchmark_output" config key.
+	 */
+	bool _benchmark;
+	Common::String _benchmarkOutput;
+	uint _benchmarkFrames;
+	bool _quitRequested;
+
+	uint32 _virtualMillis;
+	uint32 _mixedSamples;
+	Common::Array<int16> _mixBuffer;
+
+	Common::Array<FrameTiming> _frames;
+	FrameTiming _currentFrame;
+	uint32 _frameStart;
 };
 
-OSystem_NULL::OSystem_NULL() {
+OSystem_NULL::OSystem_NULL()
+	: _benchmark(false), _benchmarkFrames(0), _quitRequested(false),
+	  _virtualMillis(0), _mixedSamples(0), _frameStart(0) {
+	memset(&_currentFrame, 0, sizeof(_currentFrame));
+
 	#if defined(__amigaos4__)
 		_fsFactory = new AmigaOSFilesystemFactory();
 	#elif defined(POSIX)
@@ -81,34 +136,203 @@ OSystem_NULL::OSystem_NULL() {
 }
 
 OSystem_NULL::~OSystem_NULL() {
+	if (_benchmark)
+		writeBenchmarkResults();
+
+	// The timer and event managers use mutexes, so delete them while the
+	// mutex manager is still available.
+	delete _timerManager;
+	_timerManager = 0;
+	delete _eventManager;
+	_eventManager = 0;
 }
 
 void OSystem_NULL::initBackend() {
+	_benchmark = ConfMan.hasKey("benchmark_output");
+
 	_mutexManager = new NullMutexManager();
 	_timerManager = new DefaultTimerManager();
 	_eventManager = new DefaultEventManager(this);
 	_savefileManager = new DefaultSaveFileManager();
-	_graphicsManager = new NullGraphicsManager();
 	_mixer = new Audio::MixerImpl(this, 22050);
 
-	((Audio::MixerImpl *)_mixer)->setReady(false);
+	if (_benchmark) {
+		// In benchmark mode everything is done for real, but there is
+		// no display or audio device. Time is virtual and advances only
+		// when the engine waits, so the game runs as fast as possible.
+		// Timers and the mixer are driven from that virtual clock.
+		_benchmarkOutput = ConfMan.get("benchmark_output");
+		_benchmarkFrames = ConfMan.hasKey("benchmark_frames") ? ConfMan.getInt("benchmark_frames") : 0;
+		_graphicsManager = new HeadlessGraphicsManager();
+		((Audio::MixerImpl *)_mixer)->setReady(true);
+		_frameStart = getWallMicros();
+
+		if (!hasWallClock())
+			warning("No wall clock available, the benchmark results will only contain the virtual time and the scaled pixels");
+	} else {
+		_graphicsManager = new NullGraphicsManager();
+		((Audio::MixerImpl *)_mixer)->setReady(false);
 
-	// Note that both the mixer and the timer manager are useless
-	// this way; they need to be hooked into the system somehow to
-	// be functional. Of course, can't do that in a NULL backend :).
+		// Note that both the mixer and the timer manager are useless
+		// this way; they need to be hooked into the system somehow to
+		// be functional. Of course, can't do that in a NULL backend :).
+	}
 
 	ModularBackend::initBackend();
 }
 
 bool OSystem_NULL::pollEvent(Common::Event &event) {
+	if (_quitRequested) {
+		_quitRequested = false;
+		event.type = Common::EVENT_QUIT;
+		return true;
+	}
+
 	return false;
 }
 
 uint32 OSystem_NULL::getMillis(bool skipRecord) {
-	return 0;
+	return _virtualMillis;
 }
 
 void OSystem_NULL::delayMillis(uint msecs) {
+	if (_benchmark)
+		advanceVirtualTime(msecs);
+}
+
+void OSystem_NULL::updateScreen() {
+	if (!_benchmark) {
+		ModularBackend::updateScreen();
+		return;
+	}
+
+	HeadlessGraphicsManager *graphicsManager = (HeadlessGraphicsManager *)_graphicsManager;
+
+	const uint32 start = getWallMicros();
+	graphicsManager->convertScreen();
+	const uint32 scaleStart = getWallMicros();
+	_currentFrame.scaledPixels = graphicsManager->scaleScreen();
+	const uint32 scaleEnd = getWallMicros();
+	graphicsManager->drawCursor();
+	const uint32 end = getWallMicros();
+
+	// Everything not spent in the backend is accounted to the engine
+	const uint32 backendTime = _currentFrame.mixTime + _currentFrame.timerTime;
+	const uint32 frameTime = start - _frameStart;
+
+	_currentFrame.virtualTime = _virtualMillis;
+	_currentFrame.engineTime = frameTime > backendTime ? frameTime - backendTime : 0;
+	_currentFrame.updateScreenTime = end - start;
+	_currentFrame.scaleTime = scaleEnd - scaleStart;
+
+	_frames.push_back(_currentFrame);
+	memset(&_currentFrame, 0, sizeof(_currentFrame));
+	_frameStart = end;
+
+	if (_benchmarkFrames && _frames.size() == _benchmarkFrames)
+		_quitRequested = true;
+}
+
+bool OSystem_NULL::hasWallClock() {
+#if defined(POSIX)
+	return true;
+#else
+	return false;
+#endif
+}
+
+uint32 OSystem_NULL::getWallMicros() {
+#if defined(POSIX)
+	timeval tv;
+	gettimeofday(&tv, 0);
+	return (uint32)(tv.tv_sec * 1000000 + tv.tv_usec);
+#else
+	// getMillis() is the virtual clock, so there is nothing to fall back
+	// to. The timings are reported as unavailable instead.
+	return 0;
+#endif
+}
+
+void OSystem_NULL::advanceVirtualTime(uint msecs) {
+	Audio::MixerImpl *mixer = (Audio::MixerImpl *)_mixer;
+	const uint32 rate = mixer->getOutputRate();
+
+	// Advance in small steps, so that timers fire at their usual rate
+	// and the mixer is pulled in chunks of a typical size.
+	while (msecs > 0) {
+		const uint step = MIN<uint>(msecs, 10);
+		msecs -= step;
+		_virtualMillis += step;
+
+		uint32 start = getWallMicros();
+		((DefaultTimerManager *)_timerManager)->handler();
+		uint32 end = getWallMicros();
+		_currentFrame.timerTime += end - start;
+
+		const uint32 samples = (uint32)((uint64)_virtualMillis * rate / 1000) - _mixedSamples;
+		if (samples > 0) {
+			if (_mixBuffer.size() < samples * 2)
+				_mixBuffer.resize(samples * 2);
+
+			start = end;
+			mixer->mixCallback((byte *)&_mixBuffer[0], samples * 4);
+			end = getWallMicros();
+			_currentFrame.mixTime += end - start;
+			_mixedSamples += samples;
+		}
+	}
+}
+
+Common::String OSystem_NULL::formatMicros(uint32 micros, bool json) {
+	// Without a wall clock the timings are left empty in CSV and null in
+	// JSON, rather than reported as zero
+	if (!hasWallClock())
+		return json ? "null" : "";
+
+	return Common::String::format("%u", micros);
+}
+
+void OSystem_NULL::writeBenchmarkResults() {
+	Common::WriteStream *out = Common::FSNode(_benchmarkOutput).createWriteStream();
+	if (!out) {
+		warning("Could not open '%s' for writing benchmark results", _benchmarkOutput.c_str());
+		return;
+	}
+
+	Common::String extension = _benchmarkOutput;
+	extension.toLowercase();
+	const bool json = extension.hasSuffix(".json");
+
+	if (json)
+		out->writeString("{\n\t\"frames\": [\n");
+	else
+		out->writeString("frame,virtual_ms,engine_us,update_screen_us,scale_us,mix_us,timers_us,scaled_pixels\n");
+
+	for (uint i = 0; i < _frames.size(); ++i) {
+		const FrameTiming &f = _frames[i];
+		const Common::String engineTime = formatMicros(f.engineTime, json);
+		const Common::String updateScreenTime = formatMicros(f.updateScreenTime, json);
+		const Common::String scaleTime = formatMicros(f.scaleTime, json);
+		const Common::String mixTime = formatMicros(f.mixTime, json);
+		const Common::String timerTime = formatMicros(f.timerTime, json);
+
+		if (json) {
+			out->writeString(Common::String::format("\t\t{\"frame\": %u, \"virtual_ms\": %u, \"engine_us\": %s, "
+				"\"update_screen_us\": %s, \"scale_us\": %s, \"mix_us\": %s, \"timers_us\": %s, \"scaled_pixels\": %u}%s\n",
+				i, f.virtualTime, engineTime.c_str(), updateScreenTime.c_str(), scaleTime.c_str(), mixTime.c_str(),
+				timerTime.c_str(), f.scaledPixels, i + 1 < _frames.size() ? "," : ""));
+		} else {
+			out->writeString(Common::String::format("%u,%u,%s,%s,%s,%s,%s,%u\n",
+				i, f.virtualTime, engineTime.c_str(), updateScreenTime.c_str(), scaleTime.c_str(), mixTime.c_str(),
+				timerTime.c_str(), f.scaledPixels));
+		}
+	}
+
+	if (json)
+		out->writeString("\t]\n}\n");
+
+	out->finalize();
+	delete out;
 }
 
 void OSystem_NULL::logMessage(LogMessageType::Type type, const char *message) {
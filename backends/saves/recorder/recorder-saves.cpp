@@ -29,6 +29,14 @@ Common::InSaveFile *RecorderSaveFileManager::openForLoading(const Common::String
 	return result;
 }
 
+Common::OutSaveFile *RecorderSaveFileManager::openForSaving(const Common::String &filename, bool compress) {
+	Common::OutSaveFile *result = g_eventRec.processSaveOutStream(filename);
+	if (result == NULL) {
+		result = DefaultSaveFileManager::openForSaving(filename, compress);
+	}
+	return result;
+}
+
 Common::StringArray RecorderSaveFileManager::listSaveFiles(const Common::String &pattern) {
 	return g_eventRec.listSaveFiles(pattern);
 }
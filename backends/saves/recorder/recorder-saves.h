@@ -31,6 +31,7 @@
 class RecorderSaveFileManager : public DefaultSaveFileManager {
 	virtual Common::StringArray listSaveFiles(const Common::String &pattern);
 	virtual Common::InSaveFile *openForLoading(const Common::String &filename);
+	virtual Common::OutSaveFile *openForSaving(const Common::String &filename, bool compress = true);
 };
 
 #endif
@@ -83,6 +83,8 @@ static const char HELP_STRING[] =
 	"  --gui-theme=THEME        Select GUI theme\n"
 	"  --themepath=PATH         Path to where GUI themes are stored\n"
 	"  --list-themes            Display list of all usable GUI themes\n"
+	"  --benchmark-themes       Load each usable GUI theme several times, print the\n"
+	"                           load times and quit\n"
 	"  -e, --music-driver=MODE  Select music driver (see README for details)\n"
 	"  --list-audio-devices     List all available audio devices\n"
 	"  -q, --language=LANG      Select language (en,de,fr,it,pt,es,jp,zh,kr,se,gb,\n"
@@ -123,6 +125,14 @@ static const char HELP_STRING[] =
 	"  --record-mode=MODE       Specify record mode for event recorder (record, playback,\n"
 	"                           passthrough [default])\n"
 	"  --record-file-name=FILE  Specify record file name\n"
+	"  --record-keyframes=SECS Save a keyframe every SECS seconds while recording,\n"
+	"                           to allow --record-seek during playback (default: 0,\n"
+	"                           no keyframes)\n"
+	"  --record-seek=SECONDS    Fast-forward playback to the given time, starting\n"
+	"                           from the nearest keyframe of the recording\n"
+	"  --record-turbo           Play back the recording as fast as possible and report\n"
+	"                           screenshot mismatches at the end. Use together with\n"
+	"                           --disable-display to run without a window\n"
 	"  --disable-display        Disable any gfx output. Used for headless events\n"
 	"                           playback by Event Recorder\n"
 #endif
@@ -243,8 +253,11 @@ void registerDefaults() {
 	ConfMan.registerDefault("disable_display", false);
 	ConfMan.registerDefault("record_mode", "none");
 	ConfMan.registerDefault("record_file_name", "record.bin");
+	ConfMan.registerDefault("record_turbo", false);
+	ConfMan.registerDefault("benchmark_themes", false);
 
 	ConfMan.registerDefault("gui_saveload_chooser", "grid");
+	ConfMan.registerDefault("gui_theme_cache", true);
 	ConfMan.registerDefault("gui_saveload_last_pos", "0");
 
 	ConfMan.registerDefault("gui_browser_show_hidden", false);
@@ -440,6 +453,15 @@ Common::String parseCommandLine(Common::StringMap &settings, int argc, const cha
 
 			DO_LONG_OPTION("record-file-name")
 			END_OPTION
+
+			DO_LONG_OPTION_INT("record-keyframes")
+			END_OPTION
+
+			DO_LONG_OPTION_INT("record-seek")
+			END_OPTION
+
+			DO_LONG_OPTION_BOOL("record-turbo")
+			END_OPTION
 #endif
 
 			DO_LONG_OPTION("opl-driver")
@@ -566,6 +588,9 @@ Common::String parseCommandLine(Common::StringMap &settings, int argc, const cha
 			DO_LONG_COMMAND("list-themes")
 			END_COMMAND
 
+			DO_LONG_OPTION_BOOL("benchmark-themes")
+			END_OPTION
+
 			DO_LONG_OPTION("target-md5")
 			END_OPTION
 
@@ -31,6 +31,12 @@
 // FIXME: Avoid using printf
 #define FORBIDDEN_SYMBOL_EXCEPTION_printf
 
+// The theme benchmark measures its run time with clock()
+#define FORBIDDEN_SYMBOL_EXCEPTION_time_h
+#define FORBIDDEN_SYMBOL_EXCEPTION_clock
+
+#include <time.h>
+
 #include "engines/engine.h"
 #include "engines/metaengine.h"
 #include "base/commandLine.h"
@@ -54,6 +60,7 @@
 
 #include "gui/gui-manager.h"
 #include "gui/error.h"
+#include "gui/ThemeEngine.h"
 
 #include "audio/mididrv.h"
 #include "audio/musicplugin.h"  /* for music manager */
@@ -265,6 +272,46 @@ static Common::Error runGame(const EnginePlugin *plugin, OSystem &system, const
 	return result;
 }
 
+/**
+ * Loads each usable theme several times and prints how long that takes.
+ * The first load also has to read the theme files from disk.
+ */
+static void benchmarkThemes() {
+	typedef Common::List<GUI::ThemeEngine::ThemeDescriptor> ThList;
+	ThList thList;
+	GUI::ThemeEngine::listUsableThemes(thList);
+
+	const GUI::ThemeEngine::GraphicsMode mode = GUI::ThemeEngine::findMode(ConfMan.get("gui_renderer"));
+	const int runs = 10;
+
+	printf("Theme          First load    Average Description\n");
+	printf("-------------- ---------- ---------- -------------------------------------\n");
+
+	for (ThList::const_iterator i = thList.begin(); i != thList.end(); ++i) {
+		double first = 0.0, rest = 0.0;
+		bool loaded = true;
+
+		for (int run = 0; run < runs && loaded; ++run) {
+			const clock_t start = clock();
+
+			GUI::ThemeEngine *theme = new GUI::ThemeEngine(i->id, mode);
+			loaded = theme->init();
+			delete theme;
+
+			const double time = (clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+			if (run == 0)
+				first = time;
+			else
+				rest += time;
+		}
+
+		if (loaded)
+			printf("%-14s %7.1f ms %7.1f ms %s\n", i->id.c_str(), first, rest / (runs - 1), i->name.c_str());
+		else
+			printf("%-14s     failed            %s\n", i->id.c_str(), i->name.c_str());
+	}
+}
+
 static void setupGraphics(OSystem &system) {
 
 	system.beginGFXTransaction();
@@ -458,9 +505,14 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 	// Now as the event manager is created, setup the keymapper
 	setupKeymapper(system);
 
-	// Unless a game was specified, show the launcher dialog
-	if (0 == ConfMan.getActiveDomain())
+	if (ConfMan.getBool("benchmark_themes")) {
+		// Only measure the theme loading, and quit afterwards
+		benchmarkThemes();
+		ConfMan.setActiveDomain("");
+	} else if (0 == ConfMan.getActiveDomain()) {
+		// Unless a game was specified, show the launcher dialog
 		launcherDialog();
+	}
 
 	// FIXME: We're now looping the launcher. This, of course, doesn't
 	// work as well as it should. In theory everything should be destroyed
@@ -484,7 +536,7 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 			} else if ((recordMode == "info") && (!recordFileName.empty())) {
 				Common::PlaybackFile record;
 				record.openRead(recordFileName);
-				debug("info:author=%s name=%s description=%s", record.getHeader().author.c_str(), record.getHeader().name.c_str(), record.getHeader().description.c_str());
+				debug("info:author=%s name=%s description=%s keyframes=%d", record.getHeader().author.c_str(), record.getHeader().name.c_str(), record.getHeader().description.c_str(), record.getKeyframes().size());
 				break;
 			}
 #endif
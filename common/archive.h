@@ -111,6 +111,16 @@ public:
 	 */
 	virtual const ArchiveMemberPtr getMember(const String &name) const = 0;
 
+	/**
+	 * Get a stamp of the member with the given name, which changes whenever
+	 * its contents change, and its size, without reading the member. What
+	 * the stamp is depends on the archive, e.g. a CRC or a modification time.
+	 *
+	 * @return true if the archive knows the stamp of the member, false
+	 *         if the member does not exist or the archive can't tell.
+	 */
+	virtual bool getMemberStamp(const String &name, uint32 &stamp, uint32 &size) const { return false; }
+
 	/**
 	 * Create a stream bound to a member with the specified name in the
 	 * archive. If no member with this name exists, 0 is returned.
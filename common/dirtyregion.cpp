@@ -0,0 +1,134 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/dirtyregion.h"
+
+namespace Common {
+
+static inline uint32 rectArea(const Rect &r) {
+	return (uint32)r.width() * r.height();
+}
+
+/**
+ * Check whether the union of two rectangles is a rectangle again.
+ */
+static bool canMerge(const Rect &a, const Rect &b) {
+	if (a.left == b.left && a.right == b.right)
+		return a.top <= b.bottom && b.top <= a.bottom;
+	if (a.top == b.top && a.bottom == b.bottom)
+		return a.left <= b.right && b.left <= a.right;
+	return false;
+}
+
+void DirtyRegion::add(const Rect &rect) {
+	if (rect.isEmpty())
+		return;
+
+	Rect r = rect;
+
+	// Only the most recently added rectangles are checked, as these are
+	// the ones most likely to touch the new one. This keeps adding cheap.
+	const uint first = _rects.size() > kRecentRects ? _rects.size() - kRecentRects : 0;
+
+	for (uint i = _rects.size(); i-- > first; ) {
+		const Rect &other = _rects[i];
+
+		// Most rectangles do not even touch. Checking that without
+		// branching is much cheaper for the scattered rectangles of a
+		// busy frame.
+		if (!((other.left <= r.right) & (r.left <= other.right) & (other.top <= r.bottom) & (r.top <= other.bottom)))
+			continue;
+
+		if (other.contains(r))
+			return;
+
+		if (r.contains(other) || canMerge(other, r)) {
+			r.extend(other);
+			_rects.remove_at(i);
+		}
+	}
+
+	_rects.push_back(r);
+}
+
+uint32 DirtyRegion::area() const {
+	uint32 total = 0;
+	for (uint i = 0; i < _rects.size(); ++i)
+		total += rectArea(_rects[i]);
+	return total;
+}
+
+void DirtyRegion::limit(uint maxRects) {
+	if (maxRects == 0)
+		maxRects = 1;
+
+	if (_rects.size() <= maxRects)
+		return;
+
+	Rect bounds = _rects[0];
+	for (uint i = 1; i < _rects.size(); ++i)
+		bounds.extend(_rects[i]);
+
+	// Split the bounding box into a grid of at most maxRects cells
+	int columns = 1;
+	while ((uint)((columns + 1) * (columns + 1)) <= maxRects)
+		++columns;
+	const int rows = maxRects / columns;
+
+	const int cellWidth = (bounds.width() + columns - 1) / columns;
+	const int cellHeight = (bounds.height() + rows - 1) / rows;
+
+	// Replace the parts of the rectangles within each cell by their
+	// bounding box. Cells are disjoint, so the results are as well.
+	Array<Rect> cells;
+	cells.resize(columns * rows);
+
+	for (uint i = 0; i < _rects.size(); ++i) {
+		const Rect &r = _rects[i];
+		const int firstColumn = (r.left - bounds.left) / cellWidth;
+		const int lastColumn = (r.right - 1 - bounds.left) / cellWidth;
+		const int firstRow = (r.top - bounds.top) / cellHeight;
+		const int lastRow = (r.bottom - 1 - bounds.top) / cellHeight;
+
+		for (int y = firstRow; y <= lastRow; ++y) {
+			for (int x = firstColumn; x <= lastColumn; ++x) {
+				Rect part(bounds.left + x * cellWidth, bounds.top + y * cellHeight,
+				          bounds.left + (x + 1) * cellWidth, bounds.top + (y + 1) * cellHeight);
+				part.clip(r);
+
+				Rect &cell = cells[y * columns + x];
+				if (cell.isEmpty())
+					cell = part;
+				else
+					cell.extend(part);
+			}
+		}
+	}
+
+	_rects.clear();
+	for (uint i = 0; i < cells.size(); ++i) {
+		if (!cells[i].isEmpty())
+			_rects.push_back(cells[i]);
+	}
+}
+
+} // End of namespace Common
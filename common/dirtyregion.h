@@ -0,0 +1,85 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_DIRTYREGION_H
+#define COMMON_DIRTYREGION_H
+
+#include "common/array.h"
+#include "common/rect.h"
+
+namespace Common {
+
+/**
+ * A set of dirty screen areas, stored as a list of rectangles.
+ *
+ * A rectangle added to the region is merged with the most recently added
+ * ones if it is contained in them, contains them, or their union is a
+ * rectangle again. Adding is therefore cheap, but the rectangles may
+ * overlap. limit() bounds their number.
+ */
+class DirtyRegion {
+public:
+	/**
+	 * Add a rectangle to the region.
+	 */
+	void add(const Rect &rect);
+
+	/**
+	 * Remove all rectangles from the region.
+	 */
+	void clear() { _rects.clear(); }
+
+	bool empty() const { return _rects.empty(); }
+
+	/**
+	 * Return the rectangles making up the region.
+	 */
+	const Array<Rect> &getRects() const { return _rects; }
+
+	/**
+	 * Return the number of pixels in all rectangles of the region. Pixels
+	 * in overlapping rectangles are counted once for each of them.
+	 */
+	uint32 area() const;
+
+	/**
+	 * Reduce the number of rectangles to at most maxRects. If there are more,
+	 * the bounding box of the region is split into a grid of at most maxRects
+	 * cells, and the rectangles within each cell are replaced by their
+	 * bounding box. This takes linear time. Afterwards the rectangles are
+	 * disjoint and may cover more than the added area, but never more than
+	 * the bounding box of the region.
+	 */
+	void limit(uint maxRects);
+
+private:
+	enum {
+		/** The number of most recently added rectangles add() merges with. */
+		kRecentRects = 4
+	};
+
+	Array<Rect> _rects;
+};
+
+} // End of namespace Common
+
+#endif
@@ -0,0 +1,561 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+// The layout of the hash map in this file follows the "Swiss table" design:
+// one control byte per slot, probed a group of slots at a time.
+
+#ifndef COMMON_FLATHASHMAP_H
+#define COMMON_FLATHASHMAP_H
+
+#include "common/func.h"
+
+namespace Common {
+
+/**
+ * FlatHashMap<Key,Val> is a drop-in replacement for HashMap<Key,Val> which
+ * stores the keys and values directly in its table, instead of allocating a
+ * node for every entry. Next to the table, it keeps one control byte per
+ * slot, which tells whether the slot is empty, erased or in use. For used
+ * slots, it also holds 7 bits of the hash of the key. Lookups check a whole
+ * group of control bytes at once with plain integer arithmetic, and only
+ * compare keys whose hash bits match.
+ *
+ * This makes lookups cheaper and saves the per entry allocation. The price is
+ * that the table holds a full key/value pair for every slot, so maps with big
+ * values are better off with HashMap. Like with HashMap, inserting into the
+ * map invalidates all iterators and pointers to values, erasing does not.
+ */
+template<class Key, class Val, class HashFunc = Hash<Key>, class EqualFunc = EqualTo<Key> >
+class FlatHashMap {
+public:
+	typedef uint size_type;
+
+private:
+
+	typedef FlatHashMap<Key, Val, HashFunc, EqualFunc> HM_t;
+
+	struct Node {
+		const Key _key;
+		Val _value;
+		explicit Node(const Key &key) : _key(key), _value() {}
+		Node(const Key &key, const Val &value) : _key(key), _value(value) {}
+	};
+
+	/**
+	 * The control bytes of a group of slots, packed into one integer. The
+	 * control byte of slot i of the group is stored in bits 8*i to 8*i+7,
+	 * independent of the endianness of the machine.
+	 */
+#ifdef HAVE_INT64
+	typedef uint64 Group;
+#else
+	typedef uint32 Group;
+#endif
+
+	enum {
+		GROUP_SIZE = sizeof(Group),
+		MIN_CAPACITY = 16,
+
+		// Control byte values. Used slots contain 7 bits of the hash,
+		// so their highest bit is always clear.
+		CTRL_EMPTY = 0x80,
+		CTRL_DELETED = 0xFE,
+
+		// The quotient of the next two constants controls how much the
+		// table may fill up (including erased slots) before it is rebuilt.
+		LOADFACTOR_NUMERATOR = 7,
+		LOADFACTOR_DENOMINATOR = 8
+	};
+
+	static Group lowBits() { return (Group)-1 / 0xFF; }
+	static Group highBits() { return lowBits() << 7; }
+
+	/** Returns a mask with the highest bit set for all slots which may contain h2. */
+	static Group matchHash(Group group, byte h2) {
+		const Group x = group ^ (lowBits() * h2);
+		// This may also flag a used slot next to a match; these are sorted
+		// out when comparing the keys.
+		return (x - lowBits()) & ~x & highBits();
+	}
+
+	/** Returns a mask with the highest bit set for all empty slots. */
+	static Group matchEmpty(Group group) {
+		return group & (~group << 6) & highBits();
+	}
+
+	/** Returns a mask with the highest bit set for all empty and erased slots. */
+	static Group matchFree(Group group) {
+		return group & ~(group << 7) & highBits();
+	}
+
+	/** Returns the index of the first slot flagged in a non-zero match mask. */
+	static size_type firstMatch(Group mask) {
+#if defined(__GNUC__) && defined(HAVE_INT64)
+		return __builtin_ctzll(mask) / 8;
+#elif defined(__GNUC__)
+		return __builtin_ctz(mask) / 8;
+#else
+		size_type idx = 0;
+		while (!(mask & 0x80)) {
+			mask >>= 8;
+			++idx;
+		}
+		return idx;
+#endif
+	}
+
+	static byte getCtrl(Group group, size_type slot) {
+		return (byte)(group >> (slot * 8));
+	}
+
+	Group *_groups;	///< control bytes, one group per GROUP_SIZE slots
+	Node *_slots;	///< the slots, only constructed if they are in use
+	size_type _mask;	///< Number of groups minus one; the number of groups is a power of two
+	size_type _size;
+	size_type _deleted;	///< Number of erased slots which have not been reused yet
+
+	HashFunc _hash;
+	EqualFunc _equal;
+
+	/** Default value, returned by the const getVal. */
+	const Val _defaultVal;
+
+	size_type capacity() const { return (_mask + 1) * GROUP_SIZE; }
+
+	bool isUsed(size_type idx) const {
+		return !(getCtrl(_groups[idx / GROUP_SIZE], idx % GROUP_SIZE) & 0x80);
+	}
+
+	void setCtrl(size_type idx, byte ctrl) {
+		const size_type shift = (idx % GROUP_SIZE) * 8;
+		Group &group = _groups[idx / GROUP_SIZE];
+		group = (group & ~((Group)0xFF << shift)) | ((Group)ctrl << shift);
+	}
+
+	/** Split a hash into the start of the probe sequence and the control byte. */
+	static size_type hashGroup(size_type hash) { return hash; }
+	static byte hashCtrl(size_type hash) { return (byte)((hash * 2654435769U) >> 25); }
+
+	void allocStorage(size_type groups);
+	void freeStorage();
+	void assign(const HM_t &map);
+	size_type lookup(const Key &key) const;
+	size_type findFreeSlot(size_type hash) const;
+	size_type lookupAndCreateIfMissing(const Key &key);
+	void rehash(size_type newCapacity);
+	void eraseSlot(size_type idx);
+
+	template<class T> friend class IteratorImpl;
+
+	/**
+	 * Simple FlatHashMap iterator implementation.
+	 */
+	template<class NodeType>
+	class IteratorImpl {
+		friend class FlatHashMap;
+		template<class T> friend class IteratorImpl;
+	protected:
+		typedef const FlatHashMap hashmap_t;
+
+		size_type _idx;
+		hashmap_t *_hashmap;
+
+	protected:
+		IteratorImpl(size_type idx, hashmap_t *hashmap) : _idx(idx), _hashmap(hashmap) {}
+
+		NodeType *deref() const {
+			assert(_hashmap != 0);
+			assert(_idx < _hashmap->capacity());
+			assert(_hashmap->isUsed(_idx));
+			return &_hashmap->_slots[_idx];
+		}
+
+	public:
+		IteratorImpl() : _idx(0), _hashmap(0) {}
+		template<class T>
+		IteratorImpl(const IteratorImpl<T> &c) : _idx(c._idx), _hashmap(c._hashmap) {}
+
+		NodeType &operator*() const { return *deref(); }
+		NodeType *operator->() const { return deref(); }
+
+		bool operator==(const IteratorImpl &iter) const { return _idx == iter._idx && _hashmap == iter._hashmap; }
+		bool operator!=(const IteratorImpl &iter) const { return !(*this == iter); }
+
+		IteratorImpl &operator++() {
+			assert(_hashmap);
+			_idx = _hashmap->nextUsed(_idx + 1);
+			return *this;
+		}
+
+		IteratorImpl operator++(int) {
+			IteratorImpl old = *this;
+			operator ++();
+			return old;
+		}
+	};
+
+	/** Returns the index of the first used slot at or after idx, or -1. */
+	size_type nextUsed(size_type idx) const {
+		const size_type cap = capacity();
+		while (idx < cap) {
+			// Skip groups without any used slots at once
+			if (idx % GROUP_SIZE == 0 && matchFree(_groups[idx / GROUP_SIZE]) == highBits()) {
+				idx += GROUP_SIZE;
+				continue;
+			}
+			if (isUsed(idx))
+				return idx;
+			++idx;
+		}
+		return (size_type)-1;
+	}
+
+public:
+	typedef IteratorImpl<Node> iterator;
+	typedef IteratorImpl<const Node> const_iterator;
+
+	FlatHashMap();
+	FlatHashMap(const HM_t &map);
+	~FlatHashMap();
+
+	HM_t &operator=(const HM_t &map) {
+		if (this == &map)
+			return *this;
+
+		// Remove the previous content and ...
+		freeStorage();
+		// ... copy the new stuff.
+		assign(map);
+		return *this;
+	}
+
+	bool contains(const Key &key) const;
+
+	Val &operator[](const Key &key);
+	const Val &operator[](const Key &key) const;
+
+	Val &getVal(const Key &key);
+	const Val &getVal(const Key &key) const;
+	const Val &getVal(const Key &key, const Val &defaultVal) const;
+	void setVal(const Key &key, const Val &val);
+
+	void clear(bool shrinkArray = 0);
+
+	void erase(iterator entry);
+	void erase(const Key &key);
+
+	size_type size() const { return _size; }
+
+	/** Returns the number of bytes used by the table. */
+	size_type memoryUsage() const { return (_mask + 1) * sizeof(Group) + capacity() * sizeof(Node); }
+
+	iterator	begin() {
+		return iterator(nextUsed(0), this);
+	}
+	iterator	end() {
+		return iterator((size_type)-1, this);
+	}
+
+	const_iterator	begin() const {
+		return const_iterator(nextUsed(0), this);
+	}
+	const_iterator	end() const {
+		return const_iterator((size_type)-1, this);
+	}
+
+	iterator	find(const Key &key) {
+		return iterator(lookup(key), this);
+	}
+
+	const_iterator	find(const Key &key) const {
+		return const_iterator(lookup(key), this);
+	}
+
+	bool empty() const {
+		return (_size == 0);
+	}
+};
+
+//-------------------------------------------------------
+// FlatHashMap functions
+
+/**
+ * Base constructor, creates an empty hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::FlatHashMap() : _defaultVal() {
+	allocStorage(MIN_CAPACITY / GROUP_SIZE);
+}
+
+/**
+ * Copy constructor, creates a full copy of the given hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::FlatHashMap(const HM_t &map) : _defaultVal() {
+	assign(map);
+}
+
+/**
+ * Destructor, frees all used memory.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::~FlatHashMap() {
+	freeStorage();
+}
+
+/**
+ * Internal method for allocating an empty table with the given number
+ * of groups, which must be a power of two.
+ *
+ * @note We do *not* deallocate the previous storage here -- the caller is
+ *       responsible for doing that!
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::allocStorage(size_type groups) {
+	_mask = groups - 1;
+	_groups = new Group[groups];
+	assert(_groups != NULL);
+	for (size_type i = 0; i < groups; ++i)
+		_groups[i] = highBits();	// all slots CTRL_EMPTY
+
+	// The slots are constructed on demand, so only get raw memory here
+	_slots = (Node *)malloc(capacity() * sizeof(Node));
+	assert(_slots != NULL);
+
+	_size = 0;
+	_deleted = 0;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::freeStorage() {
+	for (size_type idx = nextUsed(0); idx != (size_type)-1; idx = nextUsed(idx + 1))
+		_slots[idx].~Node();
+
+	free(_slots);
+	delete[] _groups;
+}
+
+/**
+ * Internal method for assigning the content of another FlatHashMap
+ * to this one.
+ *
+ * @note We do *not* deallocate the previous storage here -- the caller is
+ *       responsible for doing that!
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::assign(const HM_t &map) {
+	allocStorage(map._mask + 1);
+
+	// Simply clone the map given to us, slot by slot.
+	for (size_type ctr = 0; ctr <= _mask; ++ctr)
+		_groups[ctr] = map._groups[ctr];
+
+	for (size_type idx = nextUsed(0); idx != (size_type)-1; idx = nextUsed(idx + 1))
+		new ((void *)&_slots[idx]) Node(map._slots[idx]._key, map._slots[idx]._value);
+
+	_size = map._size;
+	_deleted = map._deleted;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::clear(bool shrinkArray) {
+	freeStorage();
+	allocStorage(shrinkArray ? MIN_CAPACITY / GROUP_SIZE : _mask + 1);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::rehash(size_type newCapacity) {
+	const size_type oldCapacity = capacity();
+	Group *oldGroups = _groups;
+	Node *oldSlots = _slots;
+#ifndef NDEBUG
+	const size_type oldSize = _size;
+#endif
+
+	allocStorage(newCapacity / GROUP_SIZE);
+
+	// Move all the old elements over. Since we know that no key exists
+	// twice in the old table, we don't need to call _equal().
+	for (size_type idx = 0; idx < oldCapacity; ++idx) {
+		if (getCtrl(oldGroups[idx / GROUP_SIZE], idx % GROUP_SIZE) & 0x80)
+			continue;
+
+		const size_type hash = _hash(oldSlots[idx]._key);
+		const size_type newIdx = findFreeSlot(hash);
+		new ((void *)&_slots[newIdx]) Node(oldSlots[idx]._key, oldSlots[idx]._value);
+		setCtrl(newIdx, hashCtrl(hash));
+		oldSlots[idx].~Node();
+		_size++;
+	}
+
+	// Perform a sanity check: Old number of elements should match the new one!
+	assert(_size == oldSize);
+
+	free(oldSlots);
+	delete[] oldGroups;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookup(const Key &key) const {
+	const size_type hash = _hash(key);
+	const byte h2 = hashCtrl(hash);
+
+	// Probe the groups in triangular order, which visits all of them since
+	// their number is a power of two. The load factor guarantees that there
+	// is an empty slot somewhere, which ends the search.
+	size_type group = hashGroup(hash) & _mask;
+	for (size_type step = 1; ; ++step) {
+		const Group ctrl = _groups[group];
+
+		for (Group match = matchHash(ctrl, h2); match; ) {
+			const size_type slot = firstMatch(match);
+			const size_type idx = group * GROUP_SIZE + slot;
+			if (_equal(_slots[idx]._key, key))
+				return idx;
+			match &= ~((Group)0x80 << (slot * 8));
+		}
+
+		if (matchEmpty(ctrl))
+			return (size_type)-1;
+
+		group = (group + step) & _mask;
+	}
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::findFreeSlot(size_type hash) const {
+	size_type group = hashGroup(hash) & _mask;
+	for (size_type step = 1; ; ++step) {
+		const Group match = matchFree(_groups[group]);
+		if (match)
+			return group * GROUP_SIZE + firstMatch(match);
+
+		group = (group + step) & _mask;
+	}
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookupAndCreateIfMissing(const Key &key) {
+	size_type idx = lookup(key);
+	if (idx != (size_type)-1)
+		return idx;
+
+	// Keep the load factor below a certain threshold. Erased slots are also
+	// counted, since they do not end a search. If most of them are erased
+	// slots, rebuilding the table at its current size is enough.
+	size_type cap = capacity();
+	if ((_size + _deleted + 1) * LOADFACTOR_DENOMINATOR > cap * LOADFACTOR_NUMERATOR) {
+		if ((_size + 1) * LOADFACTOR_DENOMINATOR * 2 > cap * LOADFACTOR_NUMERATOR)
+			cap *= 2;
+		rehash(cap);
+	}
+
+	const size_type hash = _hash(key);
+	idx = findFreeSlot(hash);
+	if (getCtrl(_groups[idx / GROUP_SIZE], idx % GROUP_SIZE) == CTRL_DELETED)
+		_deleted--;
+
+	new ((void *)&_slots[idx]) Node(key);
+	setCtrl(idx, hashCtrl(hash));
+	_size++;
+
+	return idx;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::eraseSlot(size_type idx) {
+	_slots[idx].~Node();
+
+	// If the group still has an empty slot, no search has ever gone past
+	// it, so this slot can become empty again. Otherwise searches for other
+	// keys must continue past it.
+	if (matchEmpty(_groups[idx / GROUP_SIZE])) {
+		setCtrl(idx, CTRL_EMPTY);
+	} else {
+		setCtrl(idx, CTRL_DELETED);
+		_deleted++;
+	}
+	_size--;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+bool FlatHashMap<Key, Val, HashFunc, EqualFunc>::contains(const Key &key) const {
+	return lookup(key) != (size_type)-1;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) {
+	return getVal(key);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) const {
+	return getVal(key);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) {
+	// This may rehash, so _slots must only be read afterwards
+	const size_type idx = lookupAndCreateIfMissing(key);
+	return _slots[idx]._value;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) const {
+	return getVal(key, _defaultVal);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key, const Val &defaultVal) const {
+	const size_type idx = lookup(key);
+	if (idx != (size_type)-1)
+		return _slots[idx]._value;
+	else
+		return defaultVal;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::setVal(const Key &key, const Val &val) {
+	const size_type idx = lookupAndCreateIfMissing(key);
+	_slots[idx]._value = val;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(iterator entry) {
+	// Check whether we have a valid iterator
+	assert(entry._hashmap == this);
+	assert(entry._idx < capacity());
+	assert(isUsed(entry._idx));
+
+	eraseSlot(entry._idx);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(const Key &key) {
+	const size_type idx = lookup(key);
+	if (idx != (size_type)-1)
+		eraseSlot(idx);
+}
+
+} // End of namespace Common
+
+#endif
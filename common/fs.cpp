@@ -125,6 +125,10 @@ bool FSNode::isWritable() const {
 	return _realNode && _realNode->isWritable();
 }
 
+bool FSNode::getStamp(uint32 &modificationTime, uint32 &size) const {
+	return _realNode && _realNode->getStamp(modificationTime, size);
+}
+
 SeekableReadStream *FSNode::createReadStream() const {
 	if (_realNode == 0)
 		return 0;
@@ -189,7 +193,7 @@ FSNode FSDirectory::getFSNode() const {
 FSNode *FSDirectory::lookupCache(NodeCache &cache, const String &name) const {
 	// make caching as lazy as possible
 	if (!name.empty()) {
-		ensureCached();
+		ensureCachedPath(name);
 
 		if (cache.contains(name))
 			return &cache[name];
@@ -223,6 +227,14 @@ const ArchiveMemberPtr FSDirectory::getMember(const String &name) const {
 	return ArchiveMemberPtr(new FSNode(*node));
 }
 
+bool FSDirectory::getMemberStamp(const String &name, uint32 &stamp, uint32 &size) const {
+	if (name.empty() || !_node.isDirectory())
+		return false;
+
+	FSNode *node = lookupCache(_fileCache, name);
+	return node && node->getStamp(stamp, size);
+}
+
 SeekableReadStream *FSDirectory::createReadStreamForMember(const String &name) const {
 	if (name.empty() || !_node.isDirectory())
 		return 0;
@@ -252,7 +264,7 @@ FSDirectory *FSDirectory::getSubDirectory(const String &prefix, const String &na
 	return new FSDirectory(prefix, *node, depth, flat);
 }
 
-void FSDirectory::cacheDirectoryRecursive(FSNode node, int depth, const String& prefix) const {
+void FSDirectory::cacheDirectory(const FSNode &node, int depth, const String& prefix, FSList *subDirs) const {
 	if (depth <= 0)
 		return;
 
@@ -275,7 +287,8 @@ void FSDirectory::cacheDirectoryRecursive(FSNode node, int depth, const String&
 				if (_subDirCache.contains(lowercaseName)) {
 					warning("FSDirectory::cacheDirectory: name clash when building subDirCache with subdirectory '%s'", name.c_str());
 				}
-				cacheDirectoryRecursive(*it, depth - 1, _flat ? prefix : lowercaseName + "/");
+				if (subDirs)
+					subDirs->push_back(*it);
 				_subDirCache[lowercaseName] = *it;
 			}
 		} else {
@@ -286,16 +299,75 @@ void FSDirectory::cacheDirectoryRecursive(FSNode node, int depth, const String&
 			}
 		}
 	}
+}
+
+void FSDirectory::cacheDirectoryRecursive(FSNode node, int depth, const String& prefix) const {
+	FSList subDirs;
+	cacheDirectory(node, depth, prefix, &subDirs);
 
+	FSList::iterator it = subDirs.begin();
+	for ( ; it != subDirs.end(); ++it) {
+		String lowercaseName = prefix + it->getName();
+		lowercaseName.toLowercase();
+		cacheDirectoryRecursive(*it, depth - 1, _flat ? prefix : lowercaseName + "/");
+	}
 }
 
 void FSDirectory::ensureCached() const  {
 	if (_cached)
 		return;
+
+	// Start from scratch, as a lookup may already have cached parts of the
+	// tree, and caching them again would produce spurious name clashes.
+	_fileCache.clear();
+	_subDirCache.clear();
+	_cachedDirs.clear();
+
 	cacheDirectoryRecursive(_node, _depth, _prefix);
 	_cached = true;
 }
 
+void FSDirectory::ensureCachedPath(const String &name) const {
+	if (_cached)
+		return;
+
+	// Files in flat directories can be anywhere in the tree
+	if (_flat) {
+		ensureCached();
+		return;
+	}
+
+	// Only cache the directories on the way to name, so that lookups do
+	// not need to scan the whole tree first.
+	if (!_cachedDirs.contains(String())) {
+		cacheDirectory(_node, _depth, _prefix, 0);
+		_cachedDirs[String()] = true;
+	}
+
+	const char *start = name.c_str();
+	if (!_prefix.empty()) {
+		if (scumm_strnicmp(name.c_str(), _prefix.c_str(), _prefix.size()))
+			return;
+		start += _prefix.size();
+	}
+
+	int depth = _depth - 1;
+	for (const char *slash = strchr(start, '/'); slash && depth > 0; slash = strchr(slash + 1, '/'), --depth) {
+		String dirName(name.c_str(), slash);
+		if (_cachedDirs.contains(dirName))
+			continue;
+
+		NodeCache::const_iterator dir = _subDirCache.find(dirName);
+		if (dir == _subDirCache.end())
+			return;
+
+		String prefix = dirName;
+		prefix.toLowercase();
+		cacheDirectory(dir->_value, depth, prefix + "/", 0);
+		_cachedDirs[dirName] = true;
+	}
+}
+
 int FSDirectory::listMatchingMembers(ArchiveMemberList &list, const String &pattern) const {
 	if (!_node.isDirectory())
 		return 0;
@@ -213,6 +213,14 @@ public:
 	 */
 	bool isWritable() const;
 
+	/**
+	 * Gets the modification time and the size of the file referred by this
+	 * node, without opening it. Not all filesystems support this.
+	 *
+	 * @return true if the stamp is known, false otherwise.
+	 */
+	bool getStamp(uint32 &modificationTime, uint32 &size) const;
+
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
 	 * referred by this node. This assumes that the node actually refers
@@ -280,15 +288,24 @@ class FSDirectory : public Archive {
 	mutable int	_depth;
 	mutable bool _flat;
 
+	// Directories whose contents have already been cached by a lookup,
+	// keyed like _subDirCache. The root is stored with an empty key.
+	typedef HashMap<String, bool, IgnoreCase_Hash, IgnoreCase_EqualTo> DirSet;
+	mutable DirSet _cachedDirs;
+
 	// look for a match
 	FSNode *lookupCache(NodeCache &cache, const String &name) const;
 
 	// cache management
+	void cacheDirectory(const FSNode &node, int depth, const String& prefix, FSList *subDirs) const;
 	void cacheDirectoryRecursive(FSNode node, int depth, const String& prefix) const;
 
 	// fill cache if not already cached
 	void ensureCached() const;
 
+	// fill cache only for the directories leading to name
+	void ensureCachedPath(const String &name) const;
+
 public:
 	/**
 	 * Create a FSDirectory representing a tree with the specified depth. Will result in an
@@ -344,6 +361,12 @@ public:
 	 */
 	virtual const ArchiveMemberPtr getMember(const String &name) const;
 
+	/**
+	 * Get the modification time and the size of the specified file. A full
+	 * match of relative path and filename is needed for success.
+	 */
+	virtual bool getMemberStamp(const String &name, uint32 &stamp, uint32 &size) const;
+
 	/**
 	 * Open the specified file. A full match of relative path and filename is needed
 	 * for success.
@@ -245,13 +245,21 @@ public:
 	const Val &getVal(const Key &key, const Val &defaultVal) const;
 	void setVal(const Key &key, const Val &val);
 
-	void clear(bool shrinkArray = 0);
+	/**
+	 * Remove all entries. With shrinkArray, the storage array is reduced to
+	 * its minimal size. With keepNodePages, the memory pool keeps its pages
+	 * for refilling the map, instead of returning the unused ones.
+	 */
+	void clear(bool shrinkArray = 0, bool keepNodePages = false);
 
 	void erase(iterator entry);
 	void erase(const Key &key);
 
 	size_type size() const { return _size; }
 
+	/** Returns the number of bytes used by the table and the nodes, ignoring the pool overhead. */
+	size_type memoryUsage() const { return (_mask + 1) * sizeof(Node *) + _size * sizeof(Node); }
+
 	iterator	begin() {
 		// Find and return the first non-empty entry
 		for (size_type ctr = 0; ctr <= _mask; ++ctr) {
@@ -393,14 +401,15 @@ void HashMap<Key, Val, HashFunc, EqualFunc>::assign(const HM_t &map) {
 
 
 template<class Key, class Val, class HashFunc, class EqualFunc>
-void HashMap<Key, Val, HashFunc, EqualFunc>::clear(bool shrinkArray) {
+void HashMap<Key, Val, HashFunc, EqualFunc>::clear(bool shrinkArray, bool keepNodePages) {
 	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
 		freeNode(_storage[ctr]);
 		_storage[ctr] = NULL;
 	}
 
 #ifdef USE_HASHMAP_MEMORY_POOL
-	_nodePool.freeUnusedPages();
+	if (!keepNodePages)
+		_nodePool.freeUnusedPages();
 #endif
 
 	if (shrinkArray && _mask >= HASHMAP_MIN_CAPACITY) {
@@ -6,6 +6,7 @@ MODULE_OBJS := \
 	coroutines.o \
 	dcl.o \
 	debug.o \
+	dirtyregion.o \
 	error.o \
 	EventDispatcher.o \
 	EventMapper.o \
@@ -26,6 +27,7 @@ MODULE_OBJS := \
 	quicktime.o \
 	random.o \
 	rational.o \
+	recorderfile.o \
 	rendermode.o \
 	str.o \
 	stream.o \
@@ -51,10 +53,5 @@ MODULE_OBJS += \
 	rdft.o \
 	sinetables.o
 
-ifdef ENABLE_EVENTRECORDER
-MODULE_OBJS += \
-	recorderfile.o
-endif
-
 # Include common rules
 include $(srcdir)/rules.mk
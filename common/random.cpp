@@ -34,11 +34,18 @@ RandomSource::RandomSource(const String &name) {
 
 #ifdef ENABLE_EVENTRECORDER
 	setSeed(g_eventRec.getRandomSeed(name));
+	g_eventRec.registerRandomSource(name, this);
 #else
 	setSeed(g_system->getMillis());
 #endif
 }
 
+RandomSource::~RandomSource() {
+#ifdef ENABLE_EVENTRECORDER
+	g_eventRec.unregisterRandomSource(this);
+#endif
+}
+
 void RandomSource::setSeed(uint32 seed) {
 	_randSeed = seed;
 }
@@ -45,6 +45,7 @@ public:
 	 * if any.
 	 */
 	RandomSource(const String &name);
+	~RandomSource();
 
 	void setSeed(uint32 seed);
 
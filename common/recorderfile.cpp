@@ -21,19 +21,79 @@
  */
 
 #include "common/system.h"
-#include "gui/EventRecorder.h"
 #include "common/md5.h"
 #include "common/recorderfile.h"
 #include "common/savefile.h"
 #include "common/bufferedstream.h"
+#include "common/zlib.h"
 #include "graphics/thumbnail.h"
 #include "graphics/surface.h"
 #include "graphics/scaler.h"
 
-#define RECORD_VERSION 1
+#define RECORD_VERSION 2
+
+// Oldest version which can still be played back. Version 1 files store the
+// events uncompressed and have no keyframes.
+#define RECORD_MIN_VERSION 1
 
 namespace Common {
 
+static void writeVarUint(WriteStream &stream, uint32 value) {
+	while (value >= 0x80) {
+		stream.writeByte((value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+	stream.writeByte(value);
+}
+
+static uint32 readVarUint(ReadStream &stream) {
+	uint32 value = 0;
+	for (int shift = 0; shift < 32; shift += 7) {
+		byte b = stream.readByte();
+		value |= (uint32)(b & 0x7F) << shift;
+		if (!(b & 0x80))
+			break;
+	}
+	return value;
+}
+
+// Signed values are zigzag encoded, so that small negative numbers also
+// only need a single byte.
+static void writeVarInt(WriteStream &stream, int32 value) {
+	writeVarUint(stream, ((uint32)value << 1) ^ (uint32)(value >> 31));
+}
+
+static int32 readVarInt(ReadStream &stream) {
+	uint32 value = readVarUint(stream);
+	return (int32)(value >> 1) ^ -(int32)(value & 1);
+}
+
+/**
+ * Compress a buffer if zlib is available, otherwise just copy it.
+ * The caller has to free() the result.
+ */
+static byte *compressBuffer(const byte *data, uint32 size, uint32 &packedSize) {
+	MemoryWriteStreamDynamic *packed = new MemoryWriteStreamDynamic(DisposeAfterUse::NO);
+	WriteStream *compressed = wrapCompressedWriteStream(packed);
+	compressed->write(data, size);
+	compressed->finalize();
+	packedSize = packed->size();
+	byte *result = packed->getData();
+	delete compressed;
+	return result;
+}
+
+/**
+ * Read packedSize bytes written by compressBuffer from the stream, and
+ * decompress them into size bytes at data.
+ */
+static bool readCompressedBuffer(SeekableReadStream &stream, uint32 packedSize, byte *data, uint32 size) {
+	SeekableReadStream *packed = wrapCompressedReadStream(stream.readStream(packedSize), size);
+	const bool result = packed && packed->read(data, size) == size;
+	delete packed;
+	return result;
+}
+
 PlaybackFile::PlaybackFile() : _tmpRecordFile(_tmpBuffer, kRecordBuffSize), _tmpPlaybackFile(_tmpBuffer, kRecordBuffSize) {
 	_readStream = NULL;
 	_writeStream = NULL;
@@ -44,6 +104,9 @@ PlaybackFile::PlaybackFile() : _tmpRecordFile(_tmpBuffer, kRecordBuffSize), _tmp
 	_headerDumped = false;
 	_recordCount = 0;
 	_eventsSize = 0;
+	_packedEvents = false;
+	resetDeltaState();
+	_screenshotsChecked = 0;
 	memset(_tmpBuffer, 1, kRecordBuffSize);
 
 	_playbackParseState = kFileStateCheckFormat;
@@ -59,6 +122,7 @@ bool PlaybackFile::openWrite(const String &fileName) {
 	_writeStream = wrapBufferedWriteStream(g_system->getSavefileManager()->openForSaving(fileName), 128 * 1024);
 	_headerDumped = false;
 	_recordCount = 0;
+	resetDeltaState();
 	if (_writeStream == NULL) {
 		return false;
 	}
@@ -70,6 +134,9 @@ bool PlaybackFile::openRead(const String &fileName) {
 	close();
 	_header.fileName = fileName;
 	_eventsSize = 0;
+	_packedEvents = false;
+	_screenshotsChecked = 0;
+	_screenshotMismatches.clear();
 	_tmpPlaybackFile.seek(0);
 	_readStream = wrapBufferedSeekableReadStream(g_system->getSavefileManager()->openForLoading(fileName), 128 * 1024, DisposeAfterUse::YES);
 	if (_readStream == NULL) {
@@ -80,6 +147,7 @@ bool PlaybackFile::openRead(const String &fileName) {
 		debugC(1, kDebugLevelEventRec, "playback:action=\"Load File\" result=fail reason=\"header parsing failed\"");
 		return false;
 	}
+	buildKeyframeIndex();
 	_screenshotsFile = wrapBufferedWriteStream(g_system->getSavefileManager()->openForSaving("screenshots.bin"), 128 * 1024);
 	debugC(1, kDebugLevelEventRec, "playback:action=\"Load File\" result=success");
 	_mode = kRead;
@@ -130,8 +198,8 @@ bool PlaybackFile::parseHeader() {
 bool PlaybackFile::checkPlaybackFileVersion() {
 	uint32 version;
 	version = _readStream->readUint32LE();
-	if (version != RECORD_VERSION) {
-		warning("Incorrect playback file version. Expected version %d, but got %d.", RECORD_VERSION, version);
+	if (version < RECORD_MIN_VERSION || version > RECORD_VERSION) {
+		warning("Incorrect playback file version. Expected version %d to %d, but got %d.", RECORD_MIN_VERSION, RECORD_VERSION, version);
 		return false;
 	}
 	return true;
@@ -189,6 +257,8 @@ bool PlaybackFile::processChunk(ChunkHeader &nextChunk) {
 			_playbackParseState = kFileStateProcessRandom;
 			break;
 		case kEventTag:
+		case kPackedEventTag:
+		case kKeyframeTag:
 		case kScreenShotTag:
 			_readStream->seek(-8, SEEK_CUR);
 			_playbackParseState = kFileStateDone;
@@ -324,7 +394,7 @@ RecorderEvent PlaybackFile::getNextEvent() {
 	if (isEventsBufferEmpty()) {
 		PlaybackFile::ChunkHeader header;
 		header.id = kFormatIdTag;
-		while (header.id != kEventTag) {
+		while (header.id != kEventTag && header.id != kPackedEventTag) {
 			if (!readChunkHeader(header) || _readStream->eos()) {
 				break;
 			}
@@ -332,6 +402,9 @@ RecorderEvent PlaybackFile::getNextEvent() {
 			case kEventTag:
 				readEventsToBuffer(header.len);
 				break;
+			case kPackedEventTag:
+				readPackedEventsToBuffer(header.len);
+				break;
 			case kScreenShotTag:
 				_readStream->seek(-4, SEEK_CUR);
 				header.len = _readStream->readUint32BE();
@@ -356,6 +429,10 @@ bool PlaybackFile::isEventsBufferEmpty() {
 }
 
 void PlaybackFile::readEvent(RecorderEvent& event) {
+	if (_packedEvents) {
+		readPackedEvent(event);
+		return;
+	}
 	event.recordedtype = (RecorderEventType)_tmpPlaybackFile.readByte();
 	switch (event.recordedtype) {
 	case kRecorderEventTypeTimer:
@@ -393,10 +470,64 @@ void PlaybackFile::readEvent(RecorderEvent& event) {
 	event.synthetic = true;
 }
 
+void PlaybackFile::readPackedEvent(RecorderEvent &event) {
+	event.recordedtype = (RecorderEventType)_tmpPlaybackFile.readByte();
+	event.time = _lastEventTime + readVarInt(_tmpPlaybackFile);
+	_lastEventTime = event.time;
+	if (event.recordedtype == kRecorderEventTypeNormal) {
+		event.type = (EventType)readVarUint(_tmpPlaybackFile);
+		switch (event.type) {
+		case EVENT_KEYDOWN:
+		case EVENT_KEYUP:
+			event.kbd.keycode = (KeyCode)readVarInt(_tmpPlaybackFile);
+			event.kbd.ascii = readVarUint(_tmpPlaybackFile);
+			event.kbd.flags = _tmpPlaybackFile.readByte();
+			break;
+		case EVENT_MOUSEMOVE:
+		case EVENT_LBUTTONDOWN:
+		case EVENT_LBUTTONUP:
+		case EVENT_RBUTTONDOWN:
+		case EVENT_RBUTTONUP:
+		case EVENT_WHEELUP:
+		case EVENT_WHEELDOWN:
+		case EVENT_MBUTTONDOWN:
+		case EVENT_MBUTTONUP:
+			event.mouse.x = _lastMouseX + readVarInt(_tmpPlaybackFile);
+			event.mouse.y = _lastMouseY + readVarInt(_tmpPlaybackFile);
+			_lastMouseX = event.mouse.x;
+			_lastMouseY = event.mouse.y;
+			break;
+		default:
+			break;
+		}
+	}
+	event.synthetic = true;
+}
+
 void PlaybackFile::readEventsToBuffer(uint32 size) {
 	_readStream->read(_tmpBuffer, size);
 	_tmpPlaybackFile.seek(0);
 	_eventsSize = size;
+	_packedEvents = false;
+}
+
+void PlaybackFile::readPackedEventsToBuffer(uint32 size) {
+	const uint32 rawSize = _readStream->readUint32LE();
+	_eventsSize = 0;
+	if (rawSize > kRecordBuffSize || !readCompressedBuffer(*_readStream, size - 4, _tmpBuffer, rawSize)) {
+		warning("Corrupted events chunk in playback file");
+	} else {
+		_eventsSize = rawSize;
+	}
+	_tmpPlaybackFile.seek(0);
+	_packedEvents = true;
+	resetDeltaState();
+}
+
+void PlaybackFile::resetDeltaState() {
+	_lastEventTime = 0;
+	_lastMouseX = 0;
+	_lastMouseY = 0;
 }
 
 void PlaybackFile::saveScreenShot(Graphics::Surface &screen, byte md5[16]) {
@@ -415,11 +546,18 @@ void PlaybackFile::dumpRecordsToFile() {
 	if (_recordCount == 0) {
 		return;
 	}
-	_writeStream->writeUint32LE(kEventTag);
-	_writeStream->writeUint32LE(_tmpRecordFile.pos());
-	_writeStream->write(_tmpBuffer, _tmpRecordFile.pos());
+	const uint32 rawSize = _tmpRecordFile.pos();
+	uint32 packedSize;
+	byte *packed = compressBuffer(_tmpBuffer, rawSize, packedSize);
+	_writeStream->writeUint32LE(kPackedEventTag);
+	_writeStream->writeUint32LE(packedSize + 4);
+	_writeStream->writeUint32LE(rawSize);
+	_writeStream->write(packed, packedSize);
+	free(packed);
 	_tmpRecordFile.seek(0);
 	_recordCount = 0;
+	// Every chunk can be decoded on its own, which keyframes rely on
+	resetDeltaState();
 }
 
 void PlaybackFile::dumpHeaderToFile() {
@@ -509,42 +647,46 @@ void PlaybackFile::writeRandomRecords() {
 void PlaybackFile::writeEvent(const RecorderEvent &event) {
 	assert(_mode == kWrite);
 	_recordCount++;
+	writePackedEvent(event);
+	if (_recordCount == kMaxBufferedRecords) {
+		dumpRecordsToFile();
+	}
+}
+
+void PlaybackFile::writePackedEvent(const RecorderEvent &event) {
+	// Times are stored relative to the previous event, and mouse positions
+	// relative to the previous mouse event, so that most of the numbers
+	// fit into a single byte.
 	_tmpRecordFile.writeByte(event.recordedtype);
-	switch (event.recordedtype) {
-	case kRecorderEventTypeTimer:
-		_tmpRecordFile.writeUint32LE(event.time);
+	writeVarInt(_tmpRecordFile, (int32)(event.time - _lastEventTime));
+	_lastEventTime = event.time;
+	if (event.recordedtype != kRecorderEventTypeNormal) {
+		return;
+	}
+	writeVarUint(_tmpRecordFile, (uint32)event.type);
+	switch (event.type) {
+	case EVENT_KEYDOWN:
+	case EVENT_KEYUP:
+		writeVarInt(_tmpRecordFile, event.kbd.keycode);
+		writeVarUint(_tmpRecordFile, event.kbd.ascii);
+		_tmpRecordFile.writeByte(event.kbd.flags);
 		break;
-	case kRecorderEventTypeNormal:
-		_tmpRecordFile.writeUint32LE((uint32)event.type);
-		switch(event.type) {
-		case EVENT_KEYDOWN:
-		case EVENT_KEYUP:
-			_tmpRecordFile.writeUint32LE(event.time);
-			_tmpRecordFile.writeSint32LE(event.kbd.keycode);
-			_tmpRecordFile.writeUint16LE(event.kbd.ascii);
-			_tmpRecordFile.writeByte(event.kbd.flags);
-			break;
-		case EVENT_MOUSEMOVE:
-		case EVENT_LBUTTONDOWN:
-		case EVENT_LBUTTONUP:
-		case EVENT_RBUTTONDOWN:
-		case EVENT_RBUTTONUP:
-		case EVENT_WHEELUP:
-		case EVENT_WHEELDOWN:
-		case EVENT_MBUTTONDOWN:
-		case EVENT_MBUTTONUP:
-			_tmpRecordFile.writeUint32LE(event.time);
-			_tmpRecordFile.writeSint16LE(event.mouse.x);
-			_tmpRecordFile.writeSint16LE(event.mouse.y);
-			break;
-		default:
-			_tmpRecordFile.writeUint32LE(event.time);
-			break;
-		}
+	case EVENT_MOUSEMOVE:
+	case EVENT_LBUTTONDOWN:
+	case EVENT_LBUTTONUP:
+	case EVENT_RBUTTONDOWN:
+	case EVENT_RBUTTONUP:
+	case EVENT_WHEELUP:
+	case EVENT_WHEELDOWN:
+	case EVENT_MBUTTONDOWN:
+	case EVENT_MBUTTONUP:
+		writeVarInt(_tmpRecordFile, event.mouse.x - _lastMouseX);
+		writeVarInt(_tmpRecordFile, event.mouse.y - _lastMouseY);
+		_lastMouseX = event.mouse.x;
+		_lastMouseY = event.mouse.y;
+		break;
+	default:
 		break;
-	}
-	if (_recordCount == kMaxBufferedRecords) {
-		dumpRecordsToFile();
 	}
 }
 
@@ -649,7 +791,7 @@ void PlaybackFile::skipHeader() {
 		if (_readStream->eos()) {
 			break;
 		}
-		if ((id == kScreenShotTag) || (id == kEventTag) || (id == kMD5Tag)) {
+		if ((id == kScreenShotTag) || (id == kEventTag) || (id == kPackedEventTag) || (id == kKeyframeTag) || (id == kMD5Tag)) {
 			_readStream->seek(-4, SEEK_CUR);
 			return;
 		}
@@ -669,6 +811,129 @@ void PlaybackFile::addSaveFile(const String &fileName, InSaveFile *saveStream) {
 	saveStream->seek(oldPos);
 }
 
+void PlaybackFile::writeKeyframe(uint32 time, int slot, const HashMap<String, SaveFileBuffer> &saveFiles, const RandomSeedsDictionary &randomStates) {
+	assert(_mode == kWrite);
+	dumpRecordsToFile();
+
+	MemoryWriteStreamDynamic files(DisposeAfterUse::YES);
+	files.writeUint32LE(saveFiles.size());
+	for (HashMap<String, SaveFileBuffer>::const_iterator i = saveFiles.begin(); i != saveFiles.end(); ++i) {
+		files.writeUint32LE(i->_key.size());
+		files.writeString(i->_key);
+		files.writeUint32LE(i->_value.size);
+		files.write(i->_value.buffer, i->_value.size);
+	}
+	files.writeUint32LE(randomStates.size());
+	for (RandomSeedsDictionary::const_iterator i = randomStates.begin(); i != randomStates.end(); ++i) {
+		files.writeUint32LE(i->_key.size());
+		files.writeString(i->_key);
+		files.writeUint32LE(i->_value);
+	}
+
+	uint32 packedSize;
+	byte *packed = compressBuffer(files.getData(), files.size(), packedSize);
+	_writeStream->writeUint32LE(kKeyframeTag);
+	_writeStream->writeUint32LE(packedSize + 12);
+	_writeStream->writeUint32LE(time);
+	_writeStream->writeSint32LE(slot);
+	_writeStream->writeUint32LE(files.size());
+	_writeStream->write(packed, packedSize);
+	free(packed);
+	debugC(1, kDebugLevelEventRec, "recorder:action=\"Write keyframe\" time=%d slot=%d len=%d", time, slot, packedSize);
+}
+
+void PlaybackFile::buildKeyframeIndex() {
+	// updateHeader() moves all chunks when it rewrites the header, so the
+	// index is not stored in the file, but collected when opening it. This
+	// only needs to read the chunk headers.
+	_keyframes.clear();
+	const int32 start = _readStream->pos();
+	ChunkHeader chunk;
+	while (readChunkHeader(chunk)) {
+		if (chunk.id == kKeyframeTag) {
+			Keyframe keyframe;
+			keyframe.offset = _readStream->pos() - 8;
+			keyframe.time = _readStream->readUint32LE();
+			keyframe.slot = _readStream->readSint32LE();
+			_keyframes.push_back(keyframe);
+			_readStream->skip(chunk.len - 8);
+		} else if (chunk.id == kScreenShotTag) {
+			// The size of a thumbnail includes its tag and is stored big endian
+			_readStream->seek(-4, SEEK_CUR);
+			_readStream->skip(_readStream->readUint32BE() - 8);
+		} else {
+			_readStream->skip(chunk.len);
+		}
+	}
+	_readStream->seek(start);
+}
+
+bool PlaybackFile::seekToKeyframe(uint index, RandomSeedsDictionary &randomStates) {
+	assert(_mode == kRead);
+	if (index >= _keyframes.size()) {
+		return false;
+	}
+	_readStream->seek(_keyframes[index].offset);
+	ChunkHeader chunk;
+	if (!readChunkHeader(chunk) || (chunk.id != kKeyframeTag) || !readKeyframe(chunk.len, randomStates)) {
+		warning("Invalid keyframe in playback file");
+		return false;
+	}
+	// The next event is read from the chunk following the keyframe
+	_tmpPlaybackFile.seek(0);
+	_eventsSize = 0;
+	return true;
+}
+
+bool PlaybackFile::readKeyframe(uint32 size, RandomSeedsDictionary &randomStates) {
+	// Time and slot are already known from the index
+	_readStream->skip(8);
+	const uint32 rawSize = _readStream->readUint32LE();
+	byte *files = (byte *)malloc(rawSize);
+	if (!files || !readCompressedBuffer(*_readStream, size - 12, files, rawSize)) {
+		free(files);
+		return false;
+	}
+
+	MemoryReadStream filesStream(files, rawSize, DisposeAfterUse::YES);
+	const uint32 count = filesStream.readUint32LE();
+	for (uint32 i = 0; i < count; ++i) {
+		const uint32 nameLen = filesStream.readUint32LE();
+		if (filesStream.eos() || nameLen > rawSize - filesStream.pos()) {
+			return false;
+		}
+		String fileName((const char *)files + filesStream.pos(), nameLen);
+		filesStream.skip(nameLen);
+		SaveFileBuffer buf;
+		buf.size = filesStream.readUint32LE();
+		if (filesStream.eos() || buf.size > rawSize - filesStream.pos()) {
+			return false;
+		}
+		buf.buffer = (byte *)malloc(buf.size);
+		filesStream.read(buf.buffer, buf.size);
+
+		HashMap<String, SaveFileBuffer>::iterator old = _header.saveFiles.find(fileName);
+		if (old != _header.saveFiles.end()) {
+			free(old->_value.buffer);
+		}
+		_header.saveFiles[fileName] = buf;
+		debugC(1, kDebugLevelEventRec, "playback:action=\"Load keyframe save file\" filename=%s len=%d", fileName.c_str(), buf.size);
+	}
+
+	randomStates.clear();
+	const uint32 randomCount = filesStream.readUint32LE();
+	for (uint32 i = 0; i < randomCount; ++i) {
+		const uint32 nameLen = filesStream.readUint32LE();
+		if (filesStream.eos() || nameLen > rawSize - filesStream.pos()) {
+			return false;
+		}
+		String name((const char *)files + filesStream.pos(), nameLen);
+		filesStream.skip(nameLen);
+		randomStates[name] = filesStream.readUint32LE();
+	}
+	return !filesStream.eos();
+}
+
 void PlaybackFile::writeSaveFilesSection() {
 	uint size = 0;
 	for (HashMap<String, SaveFileBuffer>::iterator  i = _header.saveFiles.begin(); i != _header.saveFiles.end(); ++i) {
@@ -692,17 +957,30 @@ void PlaybackFile::writeSaveFilesSection() {
 }
 
 
+bool PlaybackFile::grabScreenAndComputeMD5(Graphics::Surface &screen, uint8 md5[16]) {
+	if (!createScreenShot(screen)) {
+		warning("Can't save screenshot");
+		return false;
+	}
+	MemoryReadStream bitmapStream((const byte*)screen.getPixels(), screen.w * screen.h * screen.format.bytesPerPixel);
+	computeStreamMD5(bitmapStream, md5);
+	return true;
+}
+
 void PlaybackFile::checkRecordedMD5() {
 	uint8 currentMD5[16];
 	uint8 savedMD5[16];
 	Graphics::Surface screen;
 	_readStream->read(savedMD5, 16);
-	if (!g_eventRec.grabScreenAndComputeMD5(screen, currentMD5)) {
+	if (!grabScreenAndComputeMD5(screen, currentMD5)) {
 		return;
 	}
-	uint32 seconds = g_system->getMillis(true) / 1000;
+	const uint32 millis = g_system->getMillis(true);
+	uint32 seconds = millis / 1000;
 	String screenTime = String::format("%.2d:%.2d:%.2d", seconds / 3600 % 24, seconds / 60 % 60, seconds % 60);
+	_screenshotsChecked++;
 	if (memcmp(savedMD5, currentMD5, 16) != 0) {
+		_screenshotMismatches.push_back(millis);
 		debugC(1, kDebugLevelEventRec, "playback:action=\"Check screenshot\" time=%s result = fail", screenTime.c_str());
 		warning("Recorded and current screenshots are different");
 	} else {
@@ -24,6 +24,7 @@
 #define COMMON_RECORDERFILE_H
 
 #include "common/scummsys.h"
+#include "common/array.h"
 #include "common/events.h"
 #include "common/mutex.h"
 #include "common/memstream.h"
@@ -49,7 +50,9 @@ struct RecorderEvent : Event {
 
 
 class PlaybackFile {
+public:
 	typedef HashMap<String, uint32, IgnoreCase_Hash, IgnoreCase_EqualTo> RandomSeedsDictionary;
+private:
 	enum fileMode {
 		kRead = 0,
 		kWrite = 1,
@@ -74,6 +77,8 @@ class PlaybackFile {
 		kHashSectionTag = MKTAG('H','A','S','H'),
 		kRandomSectionTag = MKTAG('R','A','N','D'),
 		kEventTag = MKTAG('E','V','N','T'),
+		kPackedEventTag = MKTAG('E','V','N','Z'),
+		kKeyframeTag = MKTAG('K','E','Y','F'),
 		kScreenShotTag = MKTAG('B','M','H','T'),
 		kSettingsSectionTag = MKTAG('S','E','T','T'),
 		kAuthorTag = MKTAG('H','A','U','T'),
@@ -99,6 +104,17 @@ public:
 		byte *buffer;
 		uint32 size;
 	};
+	/**
+	 * A point of the recording from which playback can be resumed: the
+	 * game was saved to the given slot at the given time, and the events
+	 * following the keyframe in the file start right after that. The
+	 * keyframe also stores the state of all random sources at that time.
+	 */
+	struct Keyframe {
+		uint32 time;
+		int slot;
+		uint32 offset;	///< file offset of the keyframe chunk
+	};
 	struct PlaybackFileHeader {
 		String fileName;
 		String author;
@@ -128,6 +144,28 @@ public:
 	PlaybackFileHeader &getHeader() {return _header;}
 	void updateHeader();
 	void addSaveFile(const String &fileName, InSaveFile *saveStream);
+
+	/**
+	 * Store a keyframe. All events written so far are flushed first, so
+	 * the events after the keyframe start in a new chunk.
+	 */
+	void writeKeyframe(uint32 time, int slot, const HashMap<String, SaveFileBuffer> &saveFiles, const RandomSeedsDictionary &randomStates);
+	const Array<Keyframe> &getKeyframes() const { return _keyframes; }
+	/**
+	 * Continue reading events after the given keyframe. Its save files
+	 * replace the ones of the same name in the header, so that loading
+	 * the keyframe slot restores the state of the game at that time.
+	 * The states of the random sources are returned in randomStates.
+	 */
+	bool seekToKeyframe(uint index, RandomSeedsDictionary &randomStates);
+
+	/** Retrieve game screenshot and compute its checksum for comparison */
+	static bool grabScreenAndComputeMD5(Graphics::Surface &screen, uint8 md5[16]);
+
+	/** Number of screenshots compared against the recording so far */
+	uint32 getScreenshotsChecked() const { return _screenshotsChecked; }
+	/** Times (in milliseconds) of the screenshots which did not match */
+	const Array<uint32> &getScreenshotMismatches() const { return _screenshotMismatches; }
 private:
 	WriteStream *_recordFile;
 	WriteStream *_writeStream;
@@ -140,6 +178,13 @@ private:
 	bool _headerDumped;
 	int _recordCount;
 	uint32 _eventsSize;
+	bool _packedEvents;	///< whether the events buffer holds delta-encoded events
+	uint32 _lastEventTime;	///< delta encoding state, reset for every events chunk
+	int16 _lastMouseX;
+	int16 _lastMouseY;
+	Array<Keyframe> _keyframes;
+	uint32 _screenshotsChecked;
+	Array<uint32> _screenshotMismatches;
 	byte _tmpBuffer[kRecordBuffSize];
 	PlaybackFileHeader _header;
 	PlaybackFileState _playbackParseState;
@@ -172,7 +217,12 @@ private:
 	bool skipToNextScreenshot();
 	void readEvent(RecorderEvent& event);
 	void readEventsToBuffer(uint32 size);
-	bool grabScreenAndComputeMD5(Graphics::Surface &screen, uint8 md5[16]);
+	void readPackedEventsToBuffer(uint32 size);
+	void readPackedEvent(RecorderEvent &event);
+	void writePackedEvent(const RecorderEvent &event);
+	void resetDeltaState();
+	void buildKeyframeIndex();
+	bool readKeyframe(uint32 size, RandomSeedsDictionary &randomStates);
 };
 
 } // End of namespace Common
@@ -103,9 +103,13 @@ typedef struct {
 
 #endif  // !USE_ZLIB
 
+#include "common/bufferedstream.h"
 #include "common/fs.h"
 #include "common/unzip.h"
-#include "common/memstream.h"
+#include "common/mutex.h"
+#include "common/ptr.h"
+#include "common/substream.h"
+#include "common/zlib.h"
 
 #include "common/hashmap.h"
 #include "common/hash-str.h"
@@ -382,6 +386,10 @@ typedef Common::HashMap<Common::String, cached_file_in_zip, Common::IgnoreCase_H
 */
 typedef struct {
 	Common::SeekableReadStream *_stream;				/* io structore of the zipfile */
+	Common::SharedPtr<Common::SeekableReadStream> _sharedStream;	/* owner of _stream, shared
+													with the member streams */
+	Common::SharedPtr<Common::Mutex> _sharedMutex;	/* serializes the access to _stream
+													by the archive and the member streams */
 	unz_global_info gi;				/* public global information */
 	uLong byte_before_the_zipfile;	/* byte before the zipfile, (>0 for sfx)*/
 	uLong num_file;					/* number of the current file in the zipfile*/
@@ -544,6 +552,8 @@ unzFile unzOpen(Common::SeekableReadStream *stream) {
 	int err=UNZ_OK;
 
 	us->_stream = stream;
+	us->_sharedStream = Common::SharedPtr<Common::SeekableReadStream>(stream);
+	us->_sharedMutex = Common::SharedPtr<Common::Mutex>(new Common::Mutex());
 
 	central_pos = unzlocal_SearchCentralDir(*us->_stream);
 	if (central_pos==0)
@@ -595,7 +605,6 @@ unzFile unzOpen(Common::SeekableReadStream *stream) {
 		err=UNZ_BADZIPFILE;
 
 	if (err != UNZ_OK) {
-		delete us->_stream;
 		delete us;
 		return NULL;
 	}
@@ -644,7 +653,6 @@ int unzClose(unzFile file) {
 	if (s->pfile_in_zip_read != NULL)
 		unzCloseCurrentFile(file);
 
-	delete s->_stream;
 	delete s;
 	return UNZ_OK;
 }
@@ -1432,9 +1440,38 @@ public:
 	virtual bool hasFile(const String &name) const;
 	virtual int listMembers(ArchiveMemberList &list) const;
 	virtual const ArchiveMemberPtr getMember(const String &name) const;
+	virtual bool getMemberStamp(const String &name, uint32 &stamp, uint32 &size) const;
 	virtual SeekableReadStream *createReadStreamForMember(const String &name) const;
 };
 
+/**
+ * Read stream for the data of a ZIP archive member. It shares ownership of
+ * the ZIP file stream with the archive, so it stays valid after the archive
+ * has been deleted, and it seeks the ZIP file stream before each read, so
+ * that several members can be read at the same time. Since they may be read
+ * from different threads, e.g. by the mixer, all accesses to the ZIP file
+ * stream are serialized with a mutex shared with the archive.
+ */
+class ZipMemberReadStream : public SafeSeekableSubReadStream {
+	SharedPtr<SeekableReadStream> _zipStream;
+	SharedPtr<Mutex> _zipMutex;
+
+public:
+	ZipMemberReadStream(const SharedPtr<SeekableReadStream> &zipStream, const SharedPtr<Mutex> &zipMutex, uint32 begin, uint32 end)
+		: SafeSeekableSubReadStream(zipStream.get(), begin, end, DisposeAfterUse::NO), _zipStream(zipStream), _zipMutex(zipMutex) {
+	}
+
+	virtual uint32 read(void *dataPtr, uint32 dataSize) {
+		StackLock lock(*_zipMutex);
+		return SafeSeekableSubReadStream::read(dataPtr, dataSize);
+	}
+
+	virtual bool seek(int32 offset, int whence = SEEK_SET) {
+		StackLock lock(*_zipMutex);
+		return SafeSeekableSubReadStream::seek(offset, whence);
+	}
+};
+
 /*
 class ZipArchiveMember : public ArchiveMember {
 	unzFile _zipFile;
@@ -1485,7 +1522,23 @@ const ArchiveMemberPtr ZipArchive::getMember(const String &name) const {
 	return ArchiveMemberPtr(new GenericArchiveMember(name, this));
 }
 
+bool ZipArchive::getMemberStamp(const String &name, uint32 &stamp, uint32 &size) const {
+	// The central directory, which has been read when opening the archive,
+	// holds the CRC-32 of every member
+	const unz_s *const archive = (const unz_s *)_zipFile;
+	ZipHash::const_iterator i = archive->_hash.find(name);
+	if (i == archive->_hash.end())
+		return false;
+
+	stamp = i->_value.cur_file_info.crc;
+	size = i->_value.cur_file_info.uncompressed_size;
+	return true;
+}
+
 SeekableReadStream *ZipArchive::createReadStreamForMember(const String &name) const {
+	const unz_s *const archive = (const unz_s *)_zipFile;
+	StackLock lock(*archive->_sharedMutex);
+
 	if (unzLocateFile(_zipFile, name.c_str(), 2) != UNZ_OK)
 		return 0;
 
@@ -1493,28 +1546,30 @@ SeekableReadStream *ZipArchive::createReadStreamForMember(const String &name) co
 	if (unzOpenCurrentFile(_zipFile) != UNZ_OK)
 		return 0;
 
-	if (unzGetCurrentFileInfo(_zipFile, &fileInfo, NULL, 0, NULL, 0, NULL, 0) != UNZ_OK)
+	if (unzGetCurrentFileInfo(_zipFile, &fileInfo, NULL, 0, NULL, 0, NULL, 0) != UNZ_OK) {
+		unzCloseCurrentFile(_zipFile);
 		return 0;
+	}
 
-	byte *buffer = (byte *)malloc(fileInfo.uncompressed_size);
-	assert(buffer);
+	// unzOpenCurrentFile() has located the member data for us
+	const file_in_zip_read_info_s *const fileData = archive->pfile_in_zip_read;
+	const uint32 begin = fileData->pos_in_zipfile + fileData->byte_before_the_zipfile;
+	const uint32 end = begin + fileInfo.compressed_size;
 
-	if (unzReadCurrentFile(_zipFile, buffer, fileInfo.uncompressed_size) != (int)fileInfo.uncompressed_size) {
-		free(buffer);
-		return 0;
-	}
+	unzCloseCurrentFile(_zipFile);
 
-	if (unzCloseCurrentFile(_zipFile) != UNZ_OK) {
-		free(buffer);
+	if (end > (uint32)archive->_stream->size())
 		return 0;
-	}
 
-	return new MemoryReadStream(buffer, fileInfo.uncompressed_size, DisposeAfterUse::YES);
+	// Instead of extracting the whole member into memory, stored members
+	// are read directly from the ZIP file and deflated ones are
+	// decompressed on the fly. Both are buffered, since many users read
+	// in small pieces.
+	SeekableReadStream *stream = new ZipMemberReadStream(archive->_sharedStream, archive->_sharedMutex, begin, end);
+	if (fileInfo.compression_method != 0)
+		stream = wrapDeflateReadStream(stream, fileInfo.uncompressed_size);
 
-	// FIXME: instead of reading all into a memory stream, we could
-	// instead create a new ZipStream class. But then we have to be
-	// careful to handle the case where the client code opens multiple
-	// files in the archive and tries to use them independently.
+	return wrapBufferedSeekableReadStream(stream, 4096, DisposeAfterUse::YES);
 }
 
 Archive *makeZipArchive(const String &name) {
@@ -32,6 +32,9 @@ XMLParser::~XMLParser() {
 	while (!_activeKey.empty())
 		freeNode(_activeKey.pop());
 
+	while (!_freeNodes.empty())
+		delete _freeNodes.pop();
+
 	delete _XMLkeys;
 	delete _stream;
 
@@ -77,58 +80,49 @@ void XMLParser::close() {
 	_stream = 0;
 }
 
+XMLParser::ParserNode *XMLParser::allocNode() {
+	if (_freeNodes.empty())
+		return new ParserNode;
+
+	return _freeNodes.pop();
+}
+
+void XMLParser::freeNode(ParserNode *node) {
+	// Keep the storage and node pages of the value map around for the
+	// next node
+	node->values.clear(false, true);
+	_freeNodes.push(node);
+}
+
 bool XMLParser::parserError(const String &errStr) {
 	_state = kParserError;
 
-	const int startPosition = _stream->pos();
-	int currentPosition = startPosition;
+	const char *text = _text.begin();
 	int lineCount = 1;
-	char c = 0;
 
-	_stream->seek(0, SEEK_SET);
-
-	while (currentPosition--) {
-		c = _stream->readByte();
-
-		if (c == '\n' || c == '\r')
+	for (uint32 i = 0; i < _pos; ++i) {
+		if (text[i] == '\n' || text[i] == '\r')
 			lineCount++;
 	}
 
-	assert(_stream->pos() == startPosition);
-	currentPosition = startPosition;
-
 	Common::String errorMessage = Common::String::format("\n  File <%s>, line %d:\n", _fileName.c_str(), lineCount);
 
-	if (startPosition > 1) {
-		int keyOpening = 0;
-		int keyClosing = 0;
+	if (_pos > 1) {
+		// Show the key the error happened in
+		uint32 keyOpening = _pos - 1;
+		while (keyOpening > 0 && text[keyOpening] != '<')
+			keyOpening--;
 
-		while (currentPosition-- && keyOpening == 0) {
-			_stream->seek(-2, SEEK_CUR);
-			c = _stream->readByte();
+		uint32 keyClosing = keyOpening;
+		while (text[keyClosing] && text[keyClosing] != '>')
+			keyClosing++;
 
-			if (c == '<')
-				keyOpening = currentPosition - 1;
-			else if (c == '>')
-				keyClosing = currentPosition;
-		}
+		if (text[keyClosing])
+			keyClosing++;
 
-		_stream->seek(startPosition, SEEK_SET);
-		currentPosition = startPosition;
-		while (keyClosing == 0 && c && currentPosition++) {
-			c = _stream->readByte();
-
-			if (c == '>')
-				keyClosing = currentPosition;
-		}
-
-		currentPosition = (keyClosing - keyOpening);
-		_stream->seek(keyOpening, SEEK_SET);
-
-		while (currentPosition--)
-			errorMessage += (char)_stream->readByte();
+		errorMessage += Common::String(text + keyOpening, text + keyClosing);
 	}
-	
+
 	errorMessage += "\n\nParser error: ";
 	errorMessage += errStr;
 	errorMessage += "\n\n";
@@ -164,26 +158,13 @@ bool XMLParser::parseActiveKey(bool closed) {
 		return parseXMLHeader(key) && closeKey();
 	}
 
-	XMLKeyLayout *layout = (_activeKey.size() == 1) ? _XMLkeys : getParentNode(key)->layout;
-
-	if (layout->children.contains(key->name)) {
-		key->layout = layout->children[key->name];
-
-		StringMap localMap = key->values;
-		int keyCount = localMap.size();
-
-		for (List<XMLKeyLayout::XMLKeyProperty>::const_iterator i = key->layout->properties.begin(); i != key->layout->properties.end(); ++i) {
-			if (i->required && !localMap.contains(i->name))
-				return parserError("Missing required property '" + i->name + "' inside key '" + key->name + "'");
-			else if (localMap.contains(i->name))
-				keyCount--;
-		}
-
-		if (keyCount > 0)
-			return parserError("Unhandled property inside key '" + key->name + "'.");
+	// The layout of the key has been looked up together with its name, and
+	// undeclared properties have been rejected while parsing them.
+	assert(key->layout);
 
-	} else {
-		return parserError("Unexpected key in the active scope ('" + key->name + "').");
+	for (List<XMLKeyLayout::XMLKeyProperty>::const_iterator i = key->layout->properties.begin(); i != key->layout->properties.end(); ++i) {
+		if (i->required && !key->values.contains(i->name))
+			return parserError("Missing required property '" + i->name + "' inside key '" + key->name + "'");
 	}
 
 	// check if any of the parents must be ignored.
@@ -209,37 +190,51 @@ bool XMLParser::parseActiveKey(bool closed) {
 	return true;
 }
 
-bool XMLParser::parseKeyValue(String keyName) {
+bool XMLParser::parseKeyValue(const String &keyName) {
 	assert(_activeKey.empty() == false);
 
 	if (_activeKey.top()->values.contains(keyName))
 		return false;
 
-	_token.clear();
-	char stringStart;
-
 	if (_char == '"' || _char == '\'') {
-		stringStart = _char;
-		_char = _stream->readByte();
+		const char stringStart = _char;
+		const uint32 valueStart = _pos + 1;
 
-		while (_char && _char != stringStart) {
-			_token += _char;
-			_char = _stream->readByte();
-		}
+		while (nextChar() && _char != stringStart)
+			;
 
 		if (_char == 0)
 			return false;
 
-		_char = _stream->readByte();
+		_token = String(_text.begin() + valueStart, _text.begin() + _pos);
+		nextChar();
 
 	} else if (!parseToken()) {
 		return false;
 	}
 
-	_activeKey.top()->values[keyName] = _token;
+	_activeKey.top()->values.setVal(keyName, _token);
 	return true;
 }
 
+bool XMLParser::findProperty(ParserNode *node) {
+	if (node->layout == 0) {
+		assert(node->header);
+		_headerProperty = _token;
+		_property = &_headerProperty;
+		return true;
+	}
+
+	for (List<XMLKeyLayout::XMLKeyProperty>::const_iterator i = node->layout->properties.begin(); i != node->layout->properties.end(); ++i) {
+		if (i->name.equalsIgnoreCase(_token)) {
+			_property = &i->name;
+			return true;
+		}
+	}
+
+	return false;
+}
+
 bool XMLParser::parseIntegerKey(const char *key, int count, ...) {
 	bool result;
 	va_list args;
@@ -302,8 +297,17 @@ bool XMLParser::parse() {
 	if (_stream == 0)
 		return false;
 
-	// Make sure we are at the start of the stream.
+	// Read the whole stream, so that the parser can work on plain memory.
+	// The buffer is kept around for the next file.
 	_stream->seek(0, SEEK_SET);
+	const int32 size = _stream->size();
+	if (size < 0)
+		return false;
+
+	_text.resize(size + 1);
+	const uint32 textSize = _stream->read(_text.begin(), size);
+	_text[textSize] = 0;
+	_pos = 0;
 
 	if (_XMLkeys == 0)
 		buildLayout();
@@ -320,7 +324,7 @@ bool XMLParser::parse() {
 	_state = kParserNeedHeader;
 	_activeKey.clear();
 
-	_char = _stream->readByte();
+	_char = _text[0];
 
 	while (_char && _state != kParserError) {
 		if (skipSpaces())
@@ -337,7 +341,7 @@ bool XMLParser::parse() {
 				break;
 			}
 
-			if ((_char = _stream->readByte()) == 0) {
+			if (nextChar() == 0) {
 				parserError("Unexpected end of file.");
 				break;
 			}
@@ -348,10 +352,10 @@ bool XMLParser::parse() {
 					break;
 				}
 
-				_char = _stream->readByte();
+				nextChar();
 				activeHeader = true;
 			} else if (_char == '/') {
-				_char = _stream->readByte();
+				nextChar();
 				activeClosure = true;
 			} else if (_char == '?') {
 				parserError("Unexpected header. There may only be one XML header per file.");
@@ -373,13 +377,25 @@ bool XMLParser::parse() {
 					break;
 				}
 			} else {
-				ParserNode *node = allocNode(); //new ParserNode;
+				ParserNode *node = allocNode();
 				node->name = _token;
 				node->ignore = false;
 				node->header = activeHeader;
 				node->depth = _activeKey.size();
 				node->layout = 0;
 				_activeKey.push(node);
+
+				if (!activeHeader || _token != "xml") {
+					XMLKeyLayout *layout = (node->depth == 0) ? _XMLkeys : getParentNode(node)->layout;
+					ChildMap::const_iterator child = layout->children.find(_token);
+
+					if (child == layout->children.end()) {
+						parserError("Unexpected key in the active scope ('" + _token + "').");
+						break;
+					}
+
+					node->layout = child->_value;
+				}
 			}
 
 			_state = kParserNeedPropertyName;
@@ -399,7 +415,7 @@ bool XMLParser::parse() {
 				else
 					_state = kParserNeedKey;
 
-				_char = _stream->readByte();
+				nextChar();
 				break;
 			}
 
@@ -407,14 +423,14 @@ bool XMLParser::parse() {
 
 			if (_char == '/' || (_char == '?' && activeHeader)) {
 				selfClosure = true;
-				_char = _stream->readByte();
+				nextChar();
 			}
 
 			if (_char == '>') {
 				if (activeHeader && !selfClosure) {
 					parserError("XML Header must be self-closed.");
 				} else if (parseActiveKey(selfClosure)) {
-					_char = _stream->readByte();
+					nextChar();
 					_state = kParserNeedKey;
 				}
 
@@ -426,6 +442,8 @@ bool XMLParser::parse() {
 				parserError("Expecting key closure after '/' symbol.");
 			else if (!parseToken())
 				parserError("Error when parsing key value.");
+			else if (!findProperty(_activeKey.top()))
+				parserError("Unhandled property inside key '" + _activeKey.top()->name + "'.");
 			else
 				_state = kParserNeedPropertyOperator;
 
@@ -437,11 +455,11 @@ bool XMLParser::parse() {
 			else
 				_state = kParserNeedPropertyValue;
 
-			_char = _stream->readByte();
+			nextChar();
 			break;
 
 		case kParserNeedPropertyValue:
-			if (!parseKeyValue(_token))
+			if (!parseKeyValue(*_property))
 				parserError("Invalid key value.");
 			else
 				_state = kParserNeedPropertyName;
@@ -467,39 +485,36 @@ bool XMLParser::skipSpaces() {
 		return false;
 
 	while (_char && isSpace(_char))
-		_char = _stream->readByte();
+		nextChar();
 
 	return true;
 }
 
 bool XMLParser::skipComments() {
 	if (_char == '<') {
-		_char = _stream->readByte();
-
-		if (_char != '!') {
-			_stream->seek(-1, SEEK_CUR);
-			_char = '<';
+		if (_text[_pos + 1] != '!')
 			return false;
-		}
 
-		if (_stream->readByte() != '-' || _stream->readByte() != '-')
+		nextChar();
+
+		if (nextChar() != '-' || nextChar() != '-')
 			return parserError("Malformed comment syntax.");
 
-		_char = _stream->readByte();
+		nextChar();
 
 		while (_char) {
 			if (_char == '-') {
-				if (_stream->readByte() == '-') {
+				if (nextChar() == '-') {
 
-					if (_stream->readByte() != '>')
+					if (nextChar() != '>')
 						return parserError("Malformed comment (double-hyphen inside comment body).");
 
-					_char = _stream->readByte();
+					nextChar();
 					return true;
 				}
 			}
 
-			_char = _stream->readByte();
+			nextChar();
 		}
 
 		return parserError("Comment has no closure.");
@@ -509,12 +524,12 @@ bool XMLParser::skipComments() {
 }
 
 bool XMLParser::parseToken() {
-	_token.clear();
+	const uint32 tokenStart = _pos;
 
-	while (isValidNameChar(_char)) {
-		_token += _char;
-		_char = _stream->readByte();
-	}
+	while (isValidNameChar(_char))
+		nextChar();
+
+	_token = String(_text.begin() + tokenStart, _text.begin() + _pos);
 
 	return isSpace(_char) != 0 || _char == '>' || _char == '=' || _char == '/';
 }
@@ -26,6 +26,7 @@
 #include "common/scummsys.h"
 #include "common/types.h"
 
+#include "common/array.h"
 #include "common/fs.h"
 #include "common/list.h"
 #include "common/hashmap.h"
@@ -92,7 +93,7 @@ public:
 	/**
 	 * Parser constructor.
 	 */
-	XMLParser() : _XMLkeys(0), _stream(0) {}
+	XMLParser() : _XMLkeys(0), _stream(0), _pos(0), _property(0) {}
 
 	virtual ~XMLParser();
 
@@ -143,15 +144,14 @@ public:
 		XMLKeyLayout *layout;
 	};
 
-	ObjectPool<ParserNode, MAX_XML_DEPTH> _nodePool;
-
-	ParserNode *allocNode() {
-		return new (_nodePool) ParserNode;
-	}
+	/**
+	 * Nodes are recycled instead of being destroyed when a key is closed,
+	 * so their value maps keep their storage from one key to the next.
+	 */
+	Stack<ParserNode *> _freeNodes;
 
-	void freeNode(ParserNode *node) {
-		_nodePool.deleteChunk(node);
-	}
+	ParserNode *allocNode();
+	void freeNode(ParserNode *node);
 
 	/**
 	 * Loads a file into the parser.
@@ -262,7 +262,17 @@ protected:
 	/**
 	 * Parses the value of a given key. There's no reason to overload this.
 	 */
-	bool parseKeyValue(String keyName);
+	bool parseKeyValue(const String &keyName);
+
+	/**
+	 * Looks up the property named by the current token in the layout of
+	 * the given node, and points _property to the name stored there. This
+	 * way all nodes share the property names of the layout as keys of their
+	 * value maps. The XML header accepts any property.
+	 *
+	 * @return false if the key does not declare such a property.
+	 */
+	bool findProperty(ParserNode *node);
 
 	/**
 	 * Called once a key has been parsed. It handles the closing/cleanup of the
@@ -337,10 +347,30 @@ protected:
 	List<XMLKeyLayout *> _layoutList;
 
 private:
+	/**
+	 * Moves on to the next character of the text. The text is terminated
+	 * by a zero, which is never moved past.
+	 */
+	char nextChar() {
+		if (_text[_pos])
+			++_pos;
+		return _char = _text[_pos];
+	}
+
 	char _char;
 	SeekableReadStream *_stream;
 	String _fileName;
 
+	/**
+	 * The contents of the stream being parsed, read in one go when parsing
+	 * starts. Tokens and values are copied straight out of it.
+	 */
+	Array<char> _text;
+	uint32 _pos; /** Position of _char in _text */
+
+	const String *_property; /** Name of the property being parsed */
+	String _headerProperty;
+
 	ParserState _state; /** Internal state of the parser */
 
 	String _error; /** Current error message */
@@ -24,6 +24,7 @@
 #define FORBIDDEN_SYMBOL_ALLOW_ALL
 
 #include "common/zlib.h"
+#include "common/array.h"
 #include "common/ptr.h"
 #include "common/util.h"
 #include "common/stream.h"
@@ -141,69 +142,130 @@ bool inflateZlibInstallShield(byte *dst, uint dstLen, const byte *src, uint srcL
 	return true;
 }
 
-#ifndef RELEASE_BUILD
-static bool _shownBackwardSeekingWarning = false;
-#endif
-
 /**
- * A simple wrapper class which can be used to wrap around an arbitrary
- * other SeekableReadStream and will then provide on-the-fly decompression support.
- * Assumes the compressed data to be in gzip format.
+ * A wrapper class which decompresses deflate data from an arbitrary
+ * SeekableReadStream on the fly. The windowBits parameter selects the
+ * header format like for inflateInit2(); by default there is no header.
+ *
+ * To make seeking cheap, the decompressor state is saved at block boundaries
+ * about every CHECKPOINT_SPAN bytes of output. A checkpoint consists of the
+ * position in the compressed and uncompressed data and the last 32 KB of
+ * output, which is all inflate needs to resume from there. Seeks then only
+ * need to decompress the data from the closest preceding checkpoint.
  */
-class GZipReadStream : public SeekableReadStream {
+class InflateReadStream : public SeekableReadStream {
 protected:
 	enum {
-		BUFSIZE = 16384		// 1 << MAX_WBITS
+		BUFSIZE = 16384,
+		WINSIZE = 32768,		// 1 << MAX_WBITS
+		CHECKPOINT_SPAN = 1024 * 1024
 	};
 
-	byte	_buf[BUFSIZE];
+	struct Checkpoint {
+		uint32 outPos;
+		uint32 inPos;
+		int bits;
+		Array<byte> window;
+	};
 
 	ScopedPtr<SeekableReadStream> _wrapped;
 	z_stream _stream;
+	int _windowBits;
 	int _zlibErr;
 	uint32 _pos;
-	uint32 _origSize;
+	uint32 _size;
 	bool _eos;
 
-public:
+	byte _buf[BUFSIZE];
+	/** Position in the wrapped stream the input buffer was filled from. */
+	uint32 _bufPos;
 
-	GZipReadStream(SeekableReadStream *w, uint32 knownSize = 0) : _wrapped(w), _stream() {
-		assert(w != 0);
+	/** The last WINSIZE bytes of output, used as a ring buffer. */
+	byte _window[WINSIZE];
+	uint32 _windowPos;
+	bool _windowFull;
 
-		// Verify file header is correct
-		w->seek(0, SEEK_SET);
-		uint16 header = w->readUint16BE();
-		assert(header == 0x1F8B ||
-		       ((header & 0x0F00) == 0x0800 && header % 31 == 0));
+	Array<Checkpoint> _checkpoints;
 
-		if (header == 0x1F8B) {
-			// Retrieve the original file size
-			w->seek(-4, SEEK_END);
-			_origSize = w->readUint32LE();
-		} else {
-			// Original size not available in zlib format
-			// use an otherwise known size if supplied.
-			_origSize = knownSize;
+	/**
+	 * Restart decompression at the given checkpoint, or at the start of the
+	 * data if checkpoint is 0.
+	 */
+	bool restart(const Checkpoint *checkpoint) {
+		// Only the start of the data may have a header. Checkpoints are
+		// always in the middle of the raw deflate data.
+		inflateEnd(&_stream);
+		_zlibErr = inflateInit2(&_stream, checkpoint ? -MAX_WBITS : _windowBits);
+		if (_zlibErr != Z_OK)
+			return false;
+
+		_stream.next_in = _buf;
+		_stream.avail_in = 0;
+		_windowPos = 0;
+		_windowFull = false;
+
+		if (!checkpoint) {
+			_pos = 0;
+			_bufPos = 0;
+			_wrapped->seek(0, SEEK_SET);
+			return true;
 		}
-		_pos = 0;
-		w->seek(0, SEEK_SET);
-		_eos = false;
 
-		// Adding 32 to windowBits indicates to zlib that it is supposed to
-		// automatically detect whether gzip or zlib headers are used for
-		// the compressed file. This feature was added in zlib 1.2.0.4,
-		// released 10 August 2003.
-		// Note: This is *crucial* for savegame compatibility, do *not* remove!
-		_zlibErr = inflateInit2(&_stream, MAX_WBITS + 32);
+		// If the block boundary is not at a byte boundary, feed the
+		// remaining bits of the previous byte first.
+		_bufPos = checkpoint->inPos - (checkpoint->bits ? 1 : 0);
+		_wrapped->seek(_bufPos, SEEK_SET);
+		if (checkpoint->bits) {
+			const byte b = _wrapped->readByte();
+			++_bufPos;
+			_zlibErr = inflatePrime(&_stream, checkpoint->bits, b >> (8 - checkpoint->bits));
+			if (_zlibErr != Z_OK)
+				return false;
+		}
+
+		const uint32 windowSize = checkpoint->window.size();
+		_zlibErr = inflateSetDictionary(&_stream, &checkpoint->window[0], windowSize);
+		if (_zlibErr != Z_OK)
+			return false;
+
+		memcpy(_window, &checkpoint->window[0], windowSize);
+		_windowPos = windowSize % WINSIZE;
+		_windowFull = (windowSize == WINSIZE);
+		_pos = checkpoint->outPos;
+		return true;
+	}
+
+	void addCheckpoint() {
+		Checkpoint checkpoint;
+		checkpoint.outPos = _pos;
+		checkpoint.inPos = _bufPos + (_stream.next_in - _buf);
+		checkpoint.bits = _stream.data_type & 7;
+		// Store the window in chronological order. Checkpoints are at
+		// least CHECKPOINT_SPAN bytes apart, so it is always full.
+		assert(_windowFull);
+		checkpoint.window.resize(WINSIZE);
+		memcpy(&checkpoint.window[0], _window + _windowPos, WINSIZE - _windowPos);
+		memcpy(&checkpoint.window[WINSIZE - _windowPos], _window, _windowPos);
+
+		_checkpoints.push_back(checkpoint);
+	}
+
+public:
+	// Negative MAX_WBITS tells zlib there's no zlib header
+	InflateReadStream(SeekableReadStream *w, uint32 size, int windowBits = -MAX_WBITS) : _wrapped(w), _stream(),
+		_windowBits(windowBits), _pos(0), _size(size), _eos(false), _bufPos(0), _windowPos(0), _windowFull(false) {
+		assert(w != 0);
+
+		_zlibErr = inflateInit2(&_stream, _windowBits);
 		if (_zlibErr != Z_OK)
 			return;
 
-		// Setup input buffer
+		_wrapped->seek(0, SEEK_SET);
 		_stream.next_in = _buf;
 		_stream.avail_in = 0;
 	}
 
-	~GZipReadStream() {
+	~InflateReadStream() {
 		inflateEnd(&_stream);
 	}
 
@@ -214,26 +276,55 @@ public:
 	}
 
 	uint32 read(void *dataPtr, uint32 dataSize) {
-		_stream.next_out = (byte *)dataPtr;
-		_stream.avail_out = dataSize;
+		byte *dst = (byte *)dataPtr;
+		uint32 total = 0;
 
-		// Keep going while we get no error
-		while (_zlibErr == Z_OK && _stream.avail_out) {
+		while (_zlibErr == Z_OK && total < dataSize) {
 			if (_stream.avail_in == 0 && !_wrapped->eos()) {
 				// If we are out of input data: Read more data, if available.
+				_bufPos = _wrapped->pos();
 				_stream.next_in = _buf;
 				_stream.avail_in = _wrapped->read(_buf, BUFSIZE);
 			}
-			_zlibErr = inflate(&_stream, Z_NO_FLUSH);
-		}
 
-		// Update the position counter
-		_pos += dataSize - _stream.avail_out;
+			// Decompress into the window, so it always holds the data a
+			// checkpoint needs, and copy the result from there.
+			const uint32 chunk = MIN<uint32>(dataSize - total, WINSIZE - _windowPos);
+			_stream.next_out = _window + _windowPos;
+			_stream.avail_out = chunk;
+
+			_zlibErr = inflate(&_stream, Z_BLOCK);
+			if (_zlibErr == Z_BUF_ERROR && _stream.avail_in == 0 && !_wrapped->eos())
+				_zlibErr = Z_OK;
+
+			const uint32 produced = chunk - _stream.avail_out;
+			memcpy(dst + total, _window + _windowPos, produced);
+			total += produced;
+			_pos += produced;
+
+			_windowPos += produced;
+			if (_windowPos == WINSIZE) {
+				_windowPos = 0;
+				_windowFull = true;
+			}
+
+			// Remember the state at the end of a block (but not after
+			// the last one) once we are far enough past the last
+			// checkpoint.
+			if (_zlibErr == Z_OK && (_stream.data_type & 128) && !(_stream.data_type & 64)) {
+				const uint32 lastPos = _checkpoints.empty() ? 0 : _checkpoints.back().outPos;
+				if (_pos >= lastPos + CHECKPOINT_SPAN)
+					addCheckpoint();
+			}
+
+			if (produced == 0 && _stream.avail_in == 0 && _wrapped->eos())
+				break;
+		}
 
-		if (_zlibErr == Z_STREAM_END && _stream.avail_out > 0)
+		if (total < dataSize)
 			_eos = true;
 
-		return dataSize - _stream.avail_out;
+		return total;
 	}
 
 	bool eos() const {
@@ -243,7 +334,7 @@ public:
 		return _pos;
 	}
 	int32 size() const {
-		return _origSize;
+		return _size;
 	}
 	bool seek(int32 offset, int whence = SEEK_SET) {
 		int32 newPos = 0;
@@ -255,49 +346,74 @@ public:
 			newPos = _pos + offset;
 			break;
 		case SEEK_END:
-			// NOTE: This can be an expensive operation (see below).
 			newPos = size() + offset;
 			break;
 		}
 
-		assert(newPos >= 0);
-
-		if ((uint32)newPos < _pos) {
-			// To search backward, we have to restart the whole decompression
-			// from the start of the file. A rather wasteful operation, best
-			// to avoid it. :/
-
-#ifndef RELEASE_BUILD
-			if (!_shownBackwardSeekingWarning) {
-				// We only throw this warning once per stream, to avoid
-				// getting the console swarmed with warnings when consecutive
-				// seeks are made.
-				debug(1, "Backward seeking in GZipReadStream detected");
-				_shownBackwardSeekingWarning = true;
-			}
-#endif
+		// The size is not known for all zlib streams, so seeks past the
+		// end are only detected when decompressing.
+		if (newPos < 0)
+			return false;
 
-			_pos = 0;
-			_wrapped->seek(0, SEEK_SET);
-			_zlibErr = inflateReset(&_stream);
-			if (_zlibErr != Z_OK)
-				return false;	// FIXME: STREAM REWRITE
-			_stream.next_in = _buf;
-			_stream.avail_in = 0;
+		// Find the closest checkpoint before the new position
+		const Checkpoint *checkpoint = 0;
+		for (uint i = 0; i < _checkpoints.size() && _checkpoints[i].outPos <= (uint32)newPos; ++i)
+			checkpoint = &_checkpoints[i];
+
+		// Restart from there, unless we can just keep going from the
+		// current position.
+		const uint32 checkpointPos = checkpoint ? checkpoint->outPos : 0;
+		if ((uint32)newPos < _pos || checkpointPos > _pos || (_zlibErr != Z_OK && _zlibErr != Z_STREAM_END)) {
+			if (!restart(checkpoint))
+				return false;
 		}
 
-		offset = newPos - _pos;
-
-		// Skip the given amount of data (very inefficient if one tries to skip
-		// huge amounts of data, but usually client code will only skip a few
-		// bytes, so this should be fine.
+		// Skip the remaining data
 		byte tmpBuf[1024];
-		while (!err() && offset > 0) {
-			offset -= read(tmpBuf, MIN((int32)sizeof(tmpBuf), offset));
+		while (!err() && _pos < (uint32)newPos) {
+			if (read(tmpBuf, MIN<uint32>(sizeof(tmpBuf), newPos - _pos)) == 0)
+				break;
 		}
 
 		_eos = false;
-		return true;	// FIXME: STREAM REWRITE
+		return _pos == (uint32)newPos;
+	}
+};
+
+/**
+ * A simple wrapper class which can be used to wrap around an arbitrary
+ * other SeekableReadStream and will then provide on-the-fly decompression support.
+ * Assumes the compressed data to be in gzip format.
+ */
+class GZipReadStream : public InflateReadStream {
+public:
+	// Adding 32 to windowBits indicates to zlib that it is supposed to
+	// automatically detect whether gzip or zlib headers are used for
+	// the compressed file. This feature was added in zlib 1.2.0.4,
+	// released 10 August 2003.
+	// Note: This is *crucial* for savegame compatibility, do *not* remove!
+	GZipReadStream(SeekableReadStream *w, uint32 knownSize = 0) : InflateReadStream(w, getOriginalSize(w, knownSize), MAX_WBITS + 32) {
+	}
+
+private:
+	static uint32 getOriginalSize(SeekableReadStream *w, uint32 knownSize) {
+		assert(w != 0);
+
+		// Verify file header is correct
+		w->seek(0, SEEK_SET);
+		uint16 header = w->readUint16BE();
+		assert(header == 0x1F8B ||
+		       ((header & 0x0F00) == 0x0800 && header % 31 == 0));
+
+		if (header == 0x1F8B) {
+			// Retrieve the original file size
+			w->seek(-4, SEEK_END);
+			return w->readUint32LE();
+		}
+
+		// Original size not available in zlib format
+		// use an otherwise known size if supplied.
+		return knownSize;
 	}
 };
 
@@ -428,6 +544,17 @@ SeekableReadStream *wrapCompressedReadStream(SeekableReadStream *toBeWrapped, ui
 	return toBeWrapped;
 }
 
+SeekableReadStream *wrapDeflateReadStream(SeekableReadStream *toBeWrapped, uint32 uncompressedSize) {
+	if (toBeWrapped) {
+#if defined(USE_ZLIB)
+		return new InflateReadStream(toBeWrapped, uncompressedSize);
+#else
+		delete toBeWrapped;
+#endif
+	}
+	return NULL;
+}
+
 WriteStream *wrapCompressedWriteStream(WriteStream *toBeWrapped) {
 #if defined(USE_ZLIB)
 	if (toBeWrapped)
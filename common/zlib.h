@@ -120,6 +120,22 @@ bool inflateZlibInstallShield(byte *dst, uint dstLen, const byte *src, uint srcL
  */
 SeekableReadStream *wrapCompressedReadStream(SeekableReadStream *toBeWrapped, uint32 knownSize = 0);
 
+/**
+ * Take an arbitrary SeekableReadStream containing raw deflate data, i.e.
+ * without zlib or gzip header (as used e.g. in ZIP archives), and wrap it in
+ * a custom stream which decompresses it on the fly. Seeking is supported,
+ * and backward seeks only need to decompress the data from the closest of
+ * the checkpoints the stream sets while decompressing.
+ *
+ * If there is no ZLIB support, NULL is returned and the stream is destroyed.
+ * It is safe to call this with a NULL parameter (in this case, NULL is
+ * returned).
+ *
+ * @param toBeWrapped		the stream to be wrapped
+ * @param uncompressedSize	the size of the decompressed data
+ */
+SeekableReadStream *wrapDeflateReadStream(SeekableReadStream *toBeWrapped, uint32 uncompressedSize);
+
 /**
  * Take an arbitrary WriteStream and wrap it in a custom stream which provides
  * transparent on-the-fly compression. The compressed data is written in the
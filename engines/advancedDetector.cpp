@@ -33,6 +33,13 @@
 #include "engines/advancedDetector.h"
 #include "engines/obsolete.h"
 
+/**
+ * File properties computed during the current detection pass, keyed by the
+ * path of the file and the number of bytes hashed. Only allocated while
+ * the cache is enabled.
+ */
+static Common::HashMap<Common::String, ADFileProperties> *s_filePropertiesCache = 0;
+
 static GameDescriptor toGameDescriptor(const ADGameDescription &g, const PlainGameDescriptor *sg) {
 	const char *title = 0;
 	const char *extra;
@@ -368,11 +375,26 @@ void AdvancedMetaEngine::composeFileHashMap(FileMap &allFiles, const Common::FSL
 	}
 }
 
+void AdvancedMetaEngine::setFilePropertiesCacheEnabled(bool enable) {
+	delete s_filePropertiesCache;
+	s_filePropertiesCache = enable ? new Common::HashMap<Common::String, ADFileProperties>() : 0;
+}
+
 bool AdvancedMetaEngine::getFileProperties(const Common::FSNode &parent, const FileMap &allFiles, const ADGameDescription &game, const Common::String fname, ADFileProperties &fileProps) const {
 	// FIXME/TODO: We don't handle the case that a file is listed as a regular
 	// file and as one with resource fork.
 
+	Common::String cacheKey;
+
 	if (game.flags & ADGF_MACRESFORK) {
+		if (s_filePropertiesCache) {
+			cacheKey = Common::String::format("%s/%s:%u:resfork", parent.getPath().c_str(), fname.c_str(), _md5Bytes);
+			if (s_filePropertiesCache->contains(cacheKey)) {
+				fileProps = s_filePropertiesCache->getVal(cacheKey);
+				return true;
+			}
+		}
+
 		Common::MacResManager macResMan;
 
 		if (!macResMan.open(parent, fname))
@@ -380,19 +402,31 @@ bool AdvancedMetaEngine::getFileProperties(const Common::FSNode &parent, const F
 
 		fileProps.md5 = macResMan.computeResForkMD5AsString(_md5Bytes);
 		fileProps.size = macResMan.getResForkDataSize();
-		return true;
-	}
+	} else {
+		if (!allFiles.contains(fname))
+			return false;
 
-	if (!allFiles.contains(fname))
-		return false;
+		const Common::FSNode &node = allFiles[fname];
 
-	Common::File testFile;
+		if (s_filePropertiesCache) {
+			cacheKey = Common::String::format("%s:%u", node.getPath().c_str(), _md5Bytes);
+			if (s_filePropertiesCache->contains(cacheKey)) {
+				fileProps = s_filePropertiesCache->getVal(cacheKey);
+				return true;
+			}
+		}
 
-	if (!testFile.open(allFiles[fname]))
-		return false;
+		Common::File testFile;
+
+		if (!testFile.open(node))
+			return false;
+
+		fileProps.size = (int32)testFile.size();
+		fileProps.md5 = Common::computeStreamMD5AsString(testFile, _md5Bytes);
+	}
 
-	fileProps.size = (int32)testFile.size();
-	fileProps.md5 = Common::computeStreamMD5AsString(testFile, _md5Bytes);
+	if (s_filePropertiesCache)
+		(*s_filePropertiesCache)[cacheKey] = fileProps;
 	return true;
 }
 
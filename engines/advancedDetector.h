@@ -267,6 +267,15 @@ public:
 
 	virtual const ExtraGuiOptions getExtraGuiOptions(const Common::String &target) const;
 
+	/**
+	 * Enable or disable caching of the file properties computed during
+	 * detection. While the cache is enabled, the size and MD5 of each file
+	 * are computed only once, even if several engines look at the same file.
+	 * Disabling the cache discards its contents, so that changes to the files
+	 * are noticed by the next detection.
+	 */
+	static void setFilePropertiesCacheEnabled(bool enable);
+
 protected:
 	// To be implemented by subclasses
 	virtual bool createInstance(OSystem *syst, Engine **engine, const ADGameDescription *desc) const = 0;
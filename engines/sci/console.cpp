@@ -156,6 +156,7 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	registerCmd("gc_reachable",		WRAP_METHOD(Console, cmdGCShowReachable));
 	registerCmd("gc_freeable",		WRAP_METHOD(Console, cmdGCShowFreeable));
 	registerCmd("gc_normalize",		WRAP_METHOD(Console, cmdGCNormalize));
+	registerCmd("gc_stats",			WRAP_METHOD(Console, cmdGCStats));
 	// Music/SFX
 	registerCmd("songlib",			WRAP_METHOD(Console, cmdSongLib));
 	registerCmd("songinfo",			WRAP_METHOD(Console, cmdSongInfo));
@@ -212,6 +213,7 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	registerCmd("bpe",				WRAP_METHOD(Console, cmdBreakpointFunction));		// alias
 	// VM
 	registerCmd("script_steps",		WRAP_METHOD(Console, cmdScriptSteps));
+	registerCmd("script_opcodes",		WRAP_METHOD(Console, cmdScriptOpcodes));
 	registerCmd("script_objects",   WRAP_METHOD(Console, cmdScriptObjects));
 	registerCmd("scro",             WRAP_METHOD(Console, cmdScriptObjects));
 	registerCmd("script_strings",   WRAP_METHOD(Console, cmdScriptStrings));
@@ -250,6 +252,10 @@ void Console::preEnter() {
 	_engine->pauseEngine(true);
 }
 
+#ifndef REDUCE_MEMORY_USAGE
+extern const char *opcodeNames[]; // from scriptdebug.cpp
+#endif
+
 extern void playVideo(Video::VideoDecoder *videoDecoder, VideoState videoState);
 
 void Console::postEnter() {
@@ -400,6 +406,7 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	debugPrintf(" gc_reachable - Lists all addresses directly reachable from a given memory object\n");
 	debugPrintf(" gc_freeable - Lists all addresses freeable in a given segment\n");
 	debugPrintf(" gc_normalize - Prints the \"normal\" address of a given address\n");
+	debugPrintf(" gc_stats - Shows how often and how long the garbage collector ran\n");
 	debugPrintf("\n");
 	debugPrintf("Music/SFX:\n");
 	debugPrintf(" songlib - Shows the song library\n");
@@ -441,6 +448,7 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	debugPrintf("\n");
 	debugPrintf("VM:\n");
 	debugPrintf(" script_steps - Shows the number of executed SCI operations\n");
+	debugPrintf(" script_opcodes - Shows the number of executed SCI operations per opcode\n");
 	debugPrintf(" vm_varlist / vmvarlist / vl - Shows the addresses of variables in the VM\n");
 	debugPrintf(" vm_vars / vmvars / vv - Displays or changes variables in the VM\n");
 	debugPrintf(" stack - Lists the specified number of stack elements\n");
@@ -2457,6 +2465,17 @@ bool Console::cmdGCShowFreeable(int argc, const char **argv) {
 	return true;
 }
 
+bool Console::cmdGCStats(int argc, const char **argv) {
+	const GCStatistics &stats = _engine->_gamestate->gcStatistics;
+
+	debugPrintf("Collections: %d, skipped as nothing was allocated: %d\n", stats.runs, stats.skipped);
+	debugPrintf("Objects freed: %d\n", stats.freed);
+	debugPrintf("Pause time: last %d ms, average %d ms, max %d ms, total %d ms\n",
+		stats.lastPause, stats.runs ? stats.totalPause / stats.runs : 0, stats.maxPause, stats.totalPause);
+	debugPrintf("Allocations since the last collection: %d\n", _engine->_gamestate->_segMan->getAllocationCounter());
+	return true;
+}
+
 bool Console::cmdGCNormalize(int argc, const char **argv) {
 	if (argc != 2) {
 		debugPrintf("Prints the \"normal\" address of a given address,\n");
@@ -2854,6 +2873,48 @@ bool Console::cmdScriptSteps(int argc, const char **argv) {
 	return true;
 }
 
+bool Console::cmdScriptOpcodes(int argc, const char **argv) {
+	EngineState *s = _engine->_gamestate;
+
+	if (argc > 1) {
+		if (!scumm_stricmp(argv[1], "clear")) {
+			memset(s->opcodeCounters, 0, sizeof(s->opcodeCounters));
+			debugPrintf("Opcode counters cleared\n");
+		} else {
+			debugPrintf("Shows how often each opcode has been executed, most frequent first.\n");
+			debugPrintf("Usage: %s [clear]\n", argv[0]);
+			debugPrintf("clear: resets the counters\n");
+		}
+		return true;
+	}
+
+	double total = 0;
+	Common::Array<uint> opcodes;
+	for (uint i = 0; i < ARRAYSIZE(s->opcodeCounters); i++) {
+		if (s->opcodeCounters[i]) {
+			total += s->opcodeCounters[i];
+			opcodes.push_back(i);
+		}
+	}
+
+	// Sort by count, most frequent first
+	for (uint i = 1; i < opcodes.size(); i++) {
+		for (uint j = i; j > 0 && s->opcodeCounters[opcodes[j]] > s->opcodeCounters[opcodes[j - 1]]; j--)
+			SWAP(opcodes[j], opcodes[j - 1]);
+	}
+
+	for (uint i = 0; i < opcodes.size(); i++) {
+		const uint32 count = s->opcodeCounters[opcodes[i]];
+#ifndef REDUCE_MEMORY_USAGE
+		debugPrintf("%02x %-10s %10u %5.1f%%\n", opcodes[i], opcodeNames[opcodes[i]], count, count * 100.0 / total);
+#else
+		debugPrintf("%02x %10u %5.1f%%\n", opcodes[i], count, count * 100.0 / total);
+#endif
+	}
+
+	return true;
+}
+
 bool Console::cmdScriptObjects(int argc, const char **argv) {
 	int curScriptNr = -1;
 
@@ -22,6 +22,7 @@
 
 #include "sci/engine/gc.h"
 #include "common/array.h"
+#include "common/system.h"
 #include "sci/graphics/ports.h"
 
 namespace Sci {
@@ -165,6 +166,8 @@ void run_gc(EngineState *s) {
 
 	// Some debug stuff
 	debugC(kDebugLevelGC, "[GC] Running...");
+	const uint32 startTime = g_system->getMillis(true);
+	uint32 freed = 0;
 #ifdef GC_DEBUG_CODE
 	const char *segnames[SEG_TYPE_MAX + 1];
 	int segcount[SEG_TYPE_MAX + 1];
@@ -195,6 +198,7 @@ void run_gc(EngineState *s) {
 				if (!activeRefs->contains(addr)) {
 					// Not found -> we can free it
 					mobj->freeAtAddress(segMan, addr);
+					freed++;
 					debugC(kDebugLevelGC, "[GC] Deallocating %04x:%04x", PRINT_REG(addr));
 #ifdef GC_DEBUG_CODE
 					segcount[type]++;
@@ -206,6 +210,15 @@ void run_gc(EngineState *s) {
 	}
 
 	delete activeRefs;
+	segMan->resetAllocationCounter();
+
+	GCStatistics &stats = s->gcStatistics;
+	stats.runs++;
+	stats.freed += freed;
+	stats.lastPause = g_system->getMillis(true) - startTime;
+	stats.maxPause = MAX(stats.maxPause, stats.lastPause);
+	stats.totalPause += stats.lastPause;
+	debugC(kDebugLevelGC, "[GC] Freed %d objects in %d ms", freed, stats.lastPause);
 
 #ifdef GC_DEBUG_CODE
 	// Output debug summary of garbage collection
@@ -50,7 +50,8 @@ typedef Common::HashMap<reg_t, bool, reg_t_Hash> AddrSet;
 AddrSet *findAllActiveReferences(EngineState *s);
 
 /**
- * Runs garbage collection on the current system state
+ * Runs garbage collection on the current system state, and updates the
+ * statistics in s->gcStatistics
  * @param s The state in which we should gc
  */
 void run_gc(EngineState *s);
@@ -70,6 +70,17 @@ enum {
 	PF_FATAL = -2
 };
 
+// Visibility graph entries
+enum {
+	VIS_UNKNOWN = 0,
+	VIS_HIDDEN = 1,
+	VIS_VISIBLE = 2
+};
+
+// Maximum number of cached visibility graphs, and of vertices in each
+#define VISIBILITY_GRAPHS 4
+#define VISIBILITY_GRAPH_VERTICES 512
+
 // Floating point struct
 struct FloatPoint {
 	FloatPoint() : x(0), y(0) {}
@@ -111,21 +122,21 @@ struct Vertex {
 	// Previous vertex in shortest path
 	Vertex *path_prev;
 
+	// Order in which the vertex entered the A* open set (0 if it didn't),
+	// and whether its shortest path is known
+	uint32 open_order;
+	bool closed;
+
+	// Index in the visibility graph, -1 for single-vertex polygons
+	int graph_index;
+
 public:
 	Vertex(const Common::Point &p) : v(p) {
 		costG = HUGE_DISTANCE;
 		path_prev = NULL;
-	}
-};
-
-class VertexList: public Common::List<Vertex *> {
-public:
-	bool contains(Vertex *v) {
-		for (iterator it = begin(); it != end(); ++it) {
-			if (v == *it)
-				return true;
-		}
-		return false;
+		open_order = 0;
+		closed = false;
+		graph_index = -1;
 	}
 };
 
@@ -236,6 +247,259 @@ public:
 
 typedef Common::List<Polygon *> PolygonList;
 
+/**
+ * Uniform grid over the polygon edges, used to find the edges that a line
+ * segment may touch without testing all of them. Each edge is stored in the
+ * cells it passes through. A segment and an edge can only share a point in a
+ * cell that both pass through.
+ */
+class EdgeGrid {
+public:
+	EdgeGrid() : _left(0), _top(0), _columns(0), _rows(0), _query(0) {}
+
+	/**
+	 * Builds the grid from the vertices with edges, which must have their
+	 * graph_index set to 0 .. edgeCount - 1.
+	 */
+	void build(Vertex **vertices, int count, int edgeCount);
+
+	/**
+	 * Collects the edges that may share a point with the segment (a, b).
+	 * Each edge is returned once.
+	 */
+	void findEdges(const Common::Point &a, const Common::Point &b, Common::Array<Vertex *> &edges);
+
+private:
+	enum {
+		kCellShift = 5
+	};
+
+	int column(int x) const {
+		return x <= _left ? 0 : MIN((x - _left) >> kCellShift, _columns - 1);
+	}
+
+	int row(int y) const {
+		return y <= _top ? 0 : MIN((y - _top) >> kCellShift, _rows - 1);
+	}
+
+	void coverSegment(const Common::Point &a, const Common::Point &b);
+
+	int _left, _top;
+	int _columns, _rows;
+
+	// Edges of cell i are _cellEdges[_cellStart[i] .. _cellStart[i + 1] - 1]
+	Common::Array<uint32> _cellStart;
+	Common::Array<Vertex *> _cellEdges;
+
+	// Cells covered by the last segment passed to coverSegment()
+	Common::Array<uint> _cover;
+
+	// Last query in which each edge was returned
+	Common::Array<uint32> _stamps;
+	uint32 _query;
+};
+
+void EdgeGrid::coverSegment(const Common::Point &a, const Common::Point &b) {
+	int top = MIN(a.y, b.y);
+	int bottom = MAX(a.y, b.y);
+	int lastRow = row(bottom);
+
+	_cover.clear();
+
+	for (int r = row(top); r <= lastRow; r++) {
+		int lo, hi;
+
+		if (a.y == b.y) {
+			lo = MIN(a.x, b.x);
+			hi = MAX(a.x, b.x);
+		} else {
+			// Part of the segment within this row, widened by half a
+			// pixel to be safe from rounding errors
+			int y1 = MAX(top, _top + (r << kCellShift));
+			int y2 = MIN(bottom, _top + ((r + 1) << kCellShift));
+			float slope = (float)(b.x - a.x) / (b.y - a.y);
+			float x1 = a.x + (y1 - a.y) * slope;
+			float x2 = a.x + (y2 - a.y) * slope;
+
+			lo = (int)floor(MIN(x1, x2) - 0.5f);
+			hi = (int)ceil(MAX(x1, x2) + 0.5f);
+		}
+
+		int lastColumn = column(hi);
+		for (int c = column(lo); c <= lastColumn; c++)
+			_cover.push_back(r * _columns + c);
+	}
+}
+
+void EdgeGrid::build(Vertex **vertices, int count, int edgeCount) {
+	int right = 0, bottom = 0;
+	bool first = true;
+
+	for (int i = 0; i < count; i++) {
+		const Common::Point &p = vertices[i]->v;
+
+		if (!VERTEX_HAS_EDGES(vertices[i]))
+			continue;
+
+		if (first) {
+			_left = right = p.x;
+			_top = bottom = p.y;
+			first = false;
+		} else {
+			_left = MIN<int>(_left, p.x);
+			right = MAX<int>(right, p.x);
+			_top = MIN<int>(_top, p.y);
+			bottom = MAX<int>(bottom, p.y);
+		}
+	}
+
+	_cellStart.clear();
+	_cellEdges.clear();
+	_stamps.clear();
+	_query = 0;
+
+	if (first) {
+		_columns = _rows = 0;
+		return;
+	}
+
+	_columns = ((right - _left) >> kCellShift) + 1;
+	_rows = ((bottom - _top) >> kCellShift) + 1;
+
+	// Count the edges of each cell, then put each edge in place
+	_cellStart.resize(_columns * _rows + 1);
+
+	for (int i = 0; i < count; i++) {
+		Vertex *edge = vertices[i];
+
+		if (VERTEX_HAS_EDGES(edge)) {
+			coverSegment(edge->v, CLIST_NEXT(edge)->v);
+			for (uint j = 0; j < _cover.size(); j++)
+				_cellStart[_cover[j] + 1]++;
+		}
+	}
+
+	for (uint i = 1; i < _cellStart.size(); i++)
+		_cellStart[i] += _cellStart[i - 1];
+
+	Common::Array<uint32> next(_cellStart.begin(), _cellStart.size() - 1);
+	_cellEdges.resize(_cellStart.back());
+
+	for (int i = 0; i < count; i++) {
+		Vertex *edge = vertices[i];
+
+		if (VERTEX_HAS_EDGES(edge)) {
+			coverSegment(edge->v, CLIST_NEXT(edge)->v);
+			for (uint j = 0; j < _cover.size(); j++)
+				_cellEdges[next[_cover[j]]++] = edge;
+		}
+	}
+
+	_stamps.resize(edgeCount);
+}
+
+void EdgeGrid::findEdges(const Common::Point &a, const Common::Point &b, Common::Array<Vertex *> &edges) {
+	edges.clear();
+
+	if (!_columns)
+		return;
+
+	_query++;
+	coverSegment(a, b);
+
+	for (uint i = 0; i < _cover.size(); i++) {
+		uint cell = _cover[i];
+
+		for (uint32 j = _cellStart[cell]; j < _cellStart[cell + 1]; j++) {
+			Vertex *edge = _cellEdges[j];
+
+			if (_stamps[edge->graph_index] != _query) {
+				_stamps[edge->graph_index] = _query;
+				edges.push_back(edge);
+			}
+		}
+	}
+}
+
+/**
+ * The A* open set, a binary heap ordered by F cost. Among vertices of equal
+ * cost, the one that entered the open set last comes first. A vertex is
+ * pushed again when its cost drops; the outdated entries are skipped by
+ * pop().
+ */
+class OpenSet {
+public:
+	OpenSet() : _order(0) {}
+
+	void push(Vertex *vertex) {
+		if (!vertex->open_order)
+			vertex->open_order = ++_order;
+
+		Entry entry;
+		entry.costF = vertex->costF;
+		entry.vertex = vertex;
+		_heap.push_back(entry);
+
+		// Sift up
+		uint i = _heap.size() - 1;
+		while (i > 0 && before(entry, _heap[(i - 1) / 2])) {
+			_heap[i] = _heap[(i - 1) / 2];
+			i = (i - 1) / 2;
+		}
+		_heap[i] = entry;
+	}
+
+	/**
+	 * Removes the open vertex with the lowest F cost
+	 * @return the vertex, or NULL if the open set is empty
+	 */
+	Vertex *pop() {
+		while (!_heap.empty()) {
+			Entry top = _heap[0];
+			Entry last = _heap.back();
+			_heap.pop_back();
+
+			// Sift down
+			uint size = _heap.size();
+			uint i = 0;
+			if (size) {
+				for (;;) {
+					uint child = 2 * i + 1;
+					if (child >= size)
+						break;
+					if (child + 1 < size && before(_heap[child + 1], _heap[child]))
+						child++;
+					if (!before(_heap[child], last))
+						break;
+					_heap[i] = _heap[child];
+					i = child;
+				}
+				_heap[i] = last;
+			}
+
+			if (!top.vertex->closed && top.costF == top.vertex->costF)
+				return top.vertex;
+		}
+
+		return NULL;
+	}
+
+private:
+	struct Entry {
+		uint32 costF;
+		Vertex *vertex;
+	};
+
+	static bool before(const Entry &a, const Entry &b) {
+		if (a.costF != b.costF)
+			return a.costF < b.costF;
+		return a.vertex->open_order > b.vertex->open_order;
+	}
+
+	Common::Array<Entry> _heap;
+	uint32 _order;
+};
+
 // Pathfinding state
 struct PathfindingState {
 	// List of all polygons
@@ -250,6 +514,16 @@ struct PathfindingState {
 	// Total number of vertices
 	int vertices;
 
+	// Cached visibility between the vertices with edges, or NULL
+	VisibilityGraph *graph;
+
+	// Number of vertices with edges
+	int graph_vertices;
+
+	// Grid of all edges, and space for the results of its queries
+	EdgeGrid grid;
+	Common::Array<Vertex *> edges;
+
 	// Point to prepend and append to final path
 	Common::Point *_prependPoint;
 	Common::Point *_appendPoint;
@@ -264,6 +538,8 @@ struct PathfindingState {
 		_prependPoint = NULL;
 		_appendPoint = NULL;
 		vertices = 0;
+		graph = NULL;
+		graph_vertices = 0;
 	}
 
 	~PathfindingState() {
@@ -660,45 +936,76 @@ static int inside(const Common::Point &p, Vertex *vertex) {
 }
 
 /**
- * Returns a list of all vertices that are visible from a particular vertex.
+ * Determines whether or not two vertices can see each other, i.e. whether the
+ * line between them neither enters a polygon locally at the vertices nor
+ * crosses an edge
+ * @param s				the pathfinding state
+ * @param vertex_cur	the first vertex
+ * @param vertex		the second vertex
+ * @return true if the vertices are visible from each other
+ */
+static bool visible(PathfindingState *s, Vertex *vertex_cur, Vertex *vertex) {
+	// Make sure we don't intersect a polygon locally at the vertices
+	if ((inside(vertex->v, vertex_cur)) || (inside(vertex_cur->v, vertex)))
+		return false;
+
+	// Check for intersecting edges
+	s->grid.findEdges(vertex_cur->v, vertex->v, s->edges);
+
+	for (uint j = 0; j < s->edges.size(); j++) {
+		Vertex *edge = s->edges[j];
+
+		if (between(vertex_cur->v, vertex->v, edge->v)) {
+			// If we hit a vertex, make sure we can pass through it without intersecting its polygon
+			if ((inside(vertex_cur->v, edge)) || (inside(vertex->v, edge)))
+				return false;
+
+			// This edge won't properly intersect, so we continue
+			continue;
+		}
+
+		if (intersect_proper(vertex_cur->v, vertex->v, edge->v, CLIST_NEXT(edge)->v))
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ * Returns all vertices that are visible from a particular vertex, in reverse
+ * order of the vertex index. A* relies on this order to break ties.
  * @param s				the pathfinding state
  * @param vertex_cur	the vertex
- * @return list of vertices that are visible from vert
+ * @param visVerts		the array that receives the visible vertices
  */
-static VertexList *visible_vertices(PathfindingState *s, Vertex *vertex_cur) {
-	VertexList *visVerts = new VertexList();
+static void visible_vertices(PathfindingState *s, Vertex *vertex_cur, Common::Array<Vertex *> &visVerts) {
+	visVerts.clear();
 
-	for (int i = 0; i < s->vertices; i++) {
+	for (int i = s->vertices - 1; i >= 0; i--) {
 		Vertex *vertex = s->vertex_index[i];
+		bool isVisible;
 
-		// Make sure we don't intersect a polygon locally at the vertices
-		if ((vertex == vertex_cur) || (inside(vertex->v, vertex_cur)) || (inside(vertex_cur->v, vertex)))
+		if (vertex == vertex_cur)
 			continue;
 
-		// Check for intersecting edges
-		int j;
-		for (j = 0; j < s->vertices; j++) {
-			Vertex *edge = s->vertex_index[j];
-			if (VERTEX_HAS_EDGES(edge)) {
-				if (between(vertex_cur->v, vertex->v, edge->v)) {
-					// If we hit a vertex, make sure we can pass through it without intersecting its polygon
-					if ((inside(vertex_cur->v, edge)) || (inside(vertex->v, edge)))
-						break;
-
-					// This edge won't properly intersect, so we continue
-					continue;
-				}
+		if (s->graph && vertex_cur->graph_index >= 0 && vertex->graph_index >= 0) {
+			// Both vertices belong to polygons with edges, so their
+			// visibility only depends on the polygons
+			byte &entry = s->graph->visible[vertex_cur->graph_index * s->graph_vertices + vertex->graph_index];
 
-				if (intersect_proper(vertex_cur->v, vertex->v, edge->v, CLIST_NEXT(edge)->v))
-					break;
+			if (entry == VIS_UNKNOWN) {
+				entry = visible(s, vertex_cur, vertex) ? VIS_VISIBLE : VIS_HIDDEN;
+				s->graph->visible[vertex->graph_index * s->graph_vertices + vertex_cur->graph_index] = entry;
 			}
+
+			isVisible = (entry == VIS_VISIBLE);
+		} else {
+			isVisible = visible(s, vertex_cur, vertex);
 		}
 
-		if (j == s->vertices)
-			visVerts->push_front(vertex);
+		if (isVisible)
+			visVerts.push_back(vertex);
 	}
-
-	return visVerts;
 }
 
 /**
@@ -1185,6 +1492,60 @@ static void change_polygons_opt_0(PathfindingState *s) {
 	}
 }
 
+/**
+ * Looks up the cached visibility graph for the polygons, or adds an empty one.
+ * Only vertices of polygons with edges are part of the graph, so the graph
+ * doesn't depend on the start and end points, unless they split an edge.
+ * Parameters: (EngineState *) s: The game state
+ *             (PathfindingState *) p: The pathfinding state
+ * Returns   : (VisibilityGraph *) The visibility graph, or NULL if there are
+ *                                 too many vertices to cache it
+ */
+static VisibilityGraph *find_visibility_graph(EngineState *s, PathfindingState *p) {
+	Common::Array<int16> polygons;
+	uint32 hash = 0;
+
+	if (p->graph_vertices > VISIBILITY_GRAPH_VERTICES)
+		return NULL;
+
+	for (PolygonList::iterator it = p->polygons.begin(); it != p->polygons.end(); ++it) {
+		Polygon *polygon = *it;
+		Vertex *vertex;
+
+		if (!VERTEX_HAS_EDGES(polygon->vertices.first()))
+			continue;
+
+		polygons.push_back(polygon->vertices.size());
+
+		CLIST_FOREACH(vertex, &polygon->vertices) {
+			polygons.push_back(vertex->v.x);
+			polygons.push_back(vertex->v.y);
+		}
+	}
+
+	for (uint i = 0; i < polygons.size(); i++)
+		hash = hash * 31 + (uint16)polygons[i];
+
+	Common::List<VisibilityGraph> &graphs = s->_visibilityGraphs;
+
+	for (Common::List<VisibilityGraph>::iterator it = graphs.begin(); it != graphs.end(); ++it) {
+		if (it->hash == hash && it->polygons == polygons)
+			return &*it;
+	}
+
+	if (graphs.size() >= VISIBILITY_GRAPHS)
+		graphs.pop_back();
+
+	graphs.push_front(VisibilityGraph());
+
+	VisibilityGraph &graph = graphs.front();
+	graph.hash = hash;
+	graph.polygons = polygons;
+	graph.visible.resize(p->graph_vertices * p->graph_vertices);
+
+	return &graph;
+}
+
 /**
  * Converts the SCI input data for pathfinding
  * Parameters: (EngineState *) s: The game state
@@ -1299,6 +1660,17 @@ static PathfindingState *convert_polygon_set(EngineState *s, reg_t poly_list, Co
 
 	pf_s->vertices = count;
 
+	count = 0;
+
+	for (int i = 0; i < pf_s->vertices; i++) {
+		if (VERTEX_HAS_EDGES(pf_s->vertex_index[i]))
+			pf_s->vertex_index[i]->graph_index = count++;
+	}
+
+	pf_s->graph_vertices = count;
+	pf_s->grid.build(pf_s->vertex_index, pf_s->vertices, pf_s->graph_vertices);
+	pf_s->graph = find_visibility_graph(s, pf_s);
+
 	return pf_s;
 }
 
@@ -1310,53 +1682,44 @@ static PathfindingState *convert_polygon_set(EngineState *s, reg_t poly_list, Co
  * Parameters: (PathfindingState *) s: The pathfinding state
  */
 static void AStar(PathfindingState *s) {
-	// Vertices of which the shortest path is known
-	VertexList closedSet;
+	// The vertices of which the shortest path isn't known yet
+	OpenSet openSet;
+
+	// Vertices visible from the current vertex
+	Common::Array<Vertex *> visVerts;
 
-	// The remaining vertices
-	VertexList openSet;
+	// WORKAROUND: The screen edge penalty below fails in QFG1VGA, room 81
+	// (bug report #3568452). However, it is needed in other SCI1.1 games,
+	// such as LB2. Therefore, we add this workaround for that scene in
+	// QFG1VGA, until our algorithm matches better what SSCI is doing. With
+	// this workaround, QFG1VGA no longer freezes in that scene.
+	bool qfg1VgaWorkaround = (g_sci->getGameId() == GID_QFG1VGA &&
+							  g_sci->getEngineState()->currentRoomNumber() == 81);
 
-	openSet.push_front(s->vertex_start);
 	s->vertex_start->costG = 0;
 	s->vertex_start->costF = (uint32)sqrt((float)s->vertex_start->v.sqrDist(s->vertex_end->v));
+	openSet.push(s->vertex_start);
 
-	while (!openSet.empty()) {
-		// Find vertex in open set with lowest F cost
-		VertexList::iterator vertex_min_it = openSet.end();
-		Vertex *vertex_min = 0;
-		uint32 min = HUGE_DISTANCE;
-
-		for (VertexList::iterator it = openSet.begin(); it != openSet.end(); ++it) {
-			Vertex *vertex = *it;
-			if (vertex->costF < min) {
-				vertex_min_it = it;
-				vertex_min = *vertex_min_it;
-				min = vertex->costF;
-			}
-		}
-
-		assert(vertex_min != 0);	// the vertex cost should never be bigger than HUGE_DISTANCE
+	Vertex *vertex_min;
 
+	// Take the vertex in the open set with lowest F cost
+	while ((vertex_min = openSet.pop())) {
 		// Check if we are done
 		if (vertex_min == s->vertex_end)
 			break;
 
 		// Move vertex from set open to set closed
-		closedSet.push_front(vertex_min);
-		openSet.erase(vertex_min_it);
+		vertex_min->closed = true;
 
-		VertexList *visVerts = visible_vertices(s, vertex_min);
+		visible_vertices(s, vertex_min, visVerts);
 
-		for (VertexList::iterator it = visVerts->begin(); it != visVerts->end(); ++it) {
+		for (uint i = 0; i < visVerts.size(); i++) {
 			uint32 new_dist;
-			Vertex *vertex = *it;
+			Vertex *vertex = visVerts[i];
 
-			if (closedSet.contains(vertex))
+			if (vertex->closed)
 				continue;
 
-			if (!openSet.contains(vertex))
-				openSet.push_front(vertex);
-
 			new_dist = vertex_min->costG + (uint32)sqrt((float)vertex_min->v.sqrDist(vertex->v));
 
 			// When travelling to a vertex on the screen edge, we
@@ -1366,15 +1729,6 @@ static void AStar(PathfindingState *s) {
 			// other, while we apply a penalty to paths traversing it.
 			// This difference might lead to problems, but none are
 			// known at the time of writing.
-
-			// WORKAROUND: This check fails in QFG1VGA, room 81 (bug report #3568452).
-			// However, it is needed in other SCI1.1 games, such as LB2. Therefore, we
-			// add this workaround for that scene in QFG1VGA, until our algorithm matches
-			// better what SSCI is doing. With this workaround, QFG1VGA no longer freezes
-			// in that scene.
-			bool qfg1VgaWorkaround = (g_sci->getGameId() == GID_QFG1VGA &&
-									  g_sci->getEngineState()->currentRoomNumber() == 81);
-
 			if (s->pointOnScreenBorder(vertex->v) && !qfg1VgaWorkaround)
 				new_dist += 10000;
 
@@ -1382,13 +1736,14 @@ static void AStar(PathfindingState *s) {
 				vertex->costG = new_dist;
 				vertex->costF = vertex->costG + (uint32)sqrt((float)vertex->v.sqrDist(s->vertex_end->v));
 				vertex->path_prev = vertex_min;
+				openSet.push(vertex);
+			} else if (!vertex->open_order) {
+				openSet.push(vertex);
 			}
 		}
-
-		delete visVerts;
 	}
 
-	if (openSet.empty())
+	if (!vertex_min)
 		debugC(kDebugLevelAvoidPath, "AvoidPath: End point (%i, %i) is unreachable", s->vertex_end->v.x, s->vertex_end->v.y);
 }
 
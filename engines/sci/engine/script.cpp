@@ -70,6 +70,34 @@ void Script::freeScript() {
 	_offsetLookupObjectCount = 0;
 	_offsetLookupStringCount = 0;
 	_offsetLookupSaidCount = 0;
+
+	invalidateInstructions();
+}
+
+void Script::invalidateInstructions() {
+	_instructions.clear();
+	_instructionIndex.clear();
+}
+
+const PMachineInstruction &Script::decodeInstruction(uint32 offset) {
+	// The index is allocated on first use, as most scripts only contain data
+	// or are never executed
+	if (_instructionIndex.empty())
+		_instructionIndex.resize(_bufSize);
+
+	PMachineInstruction instruction;
+	instruction.size = readPMachineInstruction(_buf + offset, instruction.extOpcode, instruction.opparams);
+
+	// The indices are 16-bit, so stop caching once they run out. Scripts
+	// have a lot less instructions than that in practice.
+	if (offset >= _instructionIndex.size() || _instructions.size() >= 0xFFFF) {
+		_uncachedInstruction = instruction;
+		return _uncachedInstruction;
+	}
+
+	_instructions.push_back(instruction);
+	_instructionIndex[offset] = _instructions.size();
+	return _instructions.back();
 }
 
 void Script::load(int script_nr, ResourceManager *resMan, ScriptPatcher *scriptPatcher) {
@@ -861,6 +889,7 @@ void Script::mcpyInOut(int dst, const void *src, size_t n) {
 	if (_buf) {
 		assert(dst + n <= _bufSize);
 		memcpy(_buf + dst, src, n);
+		invalidateInstructions();
 	}
 }
 
@@ -90,6 +90,10 @@ private:
 
 	ObjMap _objects;	/**< Table for objects, contains property variables */
 
+	Common::Array<PMachineInstruction> _instructions; /**< Instructions decoded by getInstruction() */
+	Common::Array<uint16> _instructionIndex; /**< 1-based indices into _instructions by offset, 0 if not decoded yet */
+	PMachineInstruction _uncachedInstruction; /**< Returned by getInstruction() once _instructions is full */
+
 protected:
 	offsetLookupArrayType _offsetLookupArray; // Table of all elements of currently loaded script, that may get pointed to
 
@@ -115,6 +119,22 @@ public:
 	const ObjMap &getObjectMap() const { return _objects; }
 	bool offsetIsObject(uint16 offset) const;
 
+	/**
+	 * Returns the decoded instruction at the given offset. Instructions are
+	 * decoded only once, when they are first executed, and kept until the
+	 * script is reloaded or its data is changed through mcpyInOut().
+	 * @param offset	offset of the instruction
+	 * @returns			the decoded instruction. The reference is only valid
+	 * 					until the next call.
+	 */
+	const PMachineInstruction &getInstruction(uint32 offset) {
+		const uint16 index = offset < _instructionIndex.size() ? _instructionIndex[offset] : 0;
+		return index ? _instructions[index - 1] : decodeInstruction(offset);
+	}
+
+	/** Drops all instructions decoded by getInstruction(). */
+	void invalidateInstructions();
+
 public:
 	Script();
 	~Script();
@@ -326,6 +346,9 @@ private:
 
 	LocalVariables *allocLocalsSegment(SegManager *segMan);
 
+	/** Decodes an instruction that is not known to getInstruction() yet. */
+	const PMachineInstruction &decodeInstruction(uint32 offset);
+
 	/**
 	 * Identifies certain offsets within script data and set up lookup-table
 	 */
@@ -40,6 +40,8 @@ SegManager::SegManager(ResourceManager *resMan, ScriptPatcher *scriptPatcher)
 	_saveDirPtr = NULL_REG;
 	_parserPtr = NULL_REG;
 
+	_allocationCounter = 0;
+
 #ifdef ENABLE_SCI32
 	_arraysSegId = 0;
 	_stringSegId = 0;
@@ -123,6 +125,7 @@ SegmentObj *SegManager::allocSegment(SegmentObj *mem, SegmentId *segid) {
 		_heap.push_back(0);
 	}
 	_heap[id] = mem;
+	_allocationCounter++;
 
 	return mem;
 }
@@ -402,6 +405,7 @@ reg_t SegManager::allocateHunkEntry(const char *hunk_type, int size) {
 	table = (HunkTable *)_heap[_hunksSegId];
 
 	offset = table->allocEntry();
+	_allocationCounter++;
 
 	reg_t addr = make_reg(_hunksSegId, offset);
 	Hunk *h = &(table->_table[offset]);
@@ -437,6 +441,7 @@ Clone *SegManager::allocateClone(reg_t *addr) {
 		table = (CloneTable *)_heap[_clonesSegId];
 
 	offset = table->allocEntry();
+	_allocationCounter++;
 
 	*addr = make_reg(_clonesSegId, offset);
 	return &(table->_table[offset]);
@@ -451,6 +456,7 @@ List *SegManager::allocateList(reg_t *addr) {
 	table = (ListTable *)_heap[_listsSegId];
 
 	offset = table->allocEntry();
+	_allocationCounter++;
 
 	*addr = make_reg(_listsSegId, offset);
 	return &(table->_table[offset]);
@@ -465,6 +471,7 @@ Node *SegManager::allocateNode(reg_t *addr) {
 	table = (NodeTable *)_heap[_nodesSegId];
 
 	offset = table->allocEntry();
+	_allocationCounter++;
 
 	*addr = make_reg(_nodesSegId, offset);
 	return &(table->_table[offset]);
@@ -871,6 +878,7 @@ SciArray<reg_t> *SegManager::allocateArray(reg_t *addr) {
 		table = (ArrayTable *)_heap[_arraysSegId];
 
 	offset = table->allocEntry();
+	_allocationCounter++;
 
 	*addr = make_reg(_arraysSegId, offset);
 	return &(table->_table[offset]);
@@ -911,6 +919,7 @@ SciString *SegManager::allocateString(reg_t *addr) {
 		table = (StringTable *)_heap[_stringSegId];
 
 	offset = table->allocEntry();
+	_allocationCounter++;
 
 	*addr = make_reg(_stringSegId, offset);
 	return &(table->_table[offset]);
@@ -1035,6 +1044,7 @@ void SegManager::uninstantiateScript(int script_nr) {
 	if (!scr->getLockers()) {
 		// The actual script deletion seems to be done by SCI scripts themselves
 		scr->markDeleted();
+		_allocationCounter++;
 		debugC(kDebugLevelScripts, "Unloaded script 0x%x.", script_nr);
 	}
 }
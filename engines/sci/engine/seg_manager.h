@@ -441,6 +441,15 @@ public:
 
 	const Common::Array<SegmentObj *> &getSegments() const { return _heap; }
 
+	/**
+	 * Returns the number of objects and segments allocated, and of scripts
+	 * marked as deleted, since the last call to resetAllocationCounter().
+	 * As long as this is 0, there is nothing new for the garbage collector
+	 * to free, and the memory use cannot have grown.
+	 */
+	uint getAllocationCounter() const { return _allocationCounter; }
+	void resetAllocationCounter() { _allocationCounter = 0; }
+
 private:
 	Common::Array<SegmentObj *> _heap;
 	Common::Array<Class> _classTable; /**< Table of all classes */
@@ -450,6 +459,8 @@ private:
 	ResourceManager *_resMan;
 	ScriptPatcher *_scriptPatcher;
 
+	uint _allocationCounter; ///< See getAllocationCounter()
+
 	SegmentId _clonesSegId; ///< ID of the (a) clones segment
 	SegmentId _listsSegId; ///< ID of the (a) list segment
 	SegmentId _nodesSegId; ///< ID of the (a) node segment
@@ -25,6 +25,7 @@
 #include "sci/sci.h"	// for INCLUDE_OLDGFX
 #include "sci/debug.h"	// for g_debug_sleeptime_factor
 #include "sci/event.h"
+#include "sci/resource.h"
 
 #include "sci/engine/file.h"
 #include "sci/engine/kernel.h"
@@ -109,6 +110,7 @@ void EngineState::reset(bool isRestoring) {
 	lastWaitTime = 0;
 
 	gcCountDown = 0;
+	memset(&gcStatistics, 0, sizeof(gcStatistics));
 
 	_throttleCounter = 0;
 	_throttleLastTime = 0;
@@ -123,6 +125,7 @@ void EngineState::reset(bool isRestoring) {
 	_cursorWorkaroundActive = false;
 
 	scriptStepCounter = 0;
+	memset(opcodeCounters, 0, sizeof(opcodeCounters));
 	scriptGCInterval = GC_INTERVAL;
 
 	_videoState.reset();
@@ -133,6 +136,9 @@ void EngineState::reset(bool isRestoring) {
 }
 
 void EngineState::speedThrottler(uint32 neededSleep) {
+	// Let the resource manager learn which rooms follow each other
+	g_sci->getResMan()->enterRoom(currentRoomNumber());
+
 	if (_throttleTrigger) {
 		uint32 curTime = g_system->getMillis();
 		uint32 duration = curTime - _throttleLastTime;
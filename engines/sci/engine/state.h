@@ -25,6 +25,7 @@
 
 #include "common/scummsys.h"
 #include "common/array.h"
+#include "common/list.h"
 #include "common/serializer.h"
 #include "common/str-array.h"
 
@@ -99,6 +100,27 @@ struct VideoState {
 	}
 };
 
+/** Statistics about the garbage collector, see run_gc() */
+struct GCStatistics {
+	uint32 runs; ///< Number of collections
+	uint32 skipped; ///< Number of periodic collections skipped, as nothing was allocated
+	uint32 freed; ///< Number of objects and segments freed
+	uint32 lastPause; ///< Duration of the last collection, in ms
+	uint32 maxPause; ///< Duration of the longest collection, in ms
+	uint32 totalPause; ///< Duration of all collections, in ms
+};
+
+/**
+ * Visibility between the polygon vertices of a kAvoidPath polygon set. Games
+ * usually ask for many paths through the same polygons, so the pathfinder
+ * keeps these for the last few polygon sets.
+ */
+struct VisibilityGraph {
+	uint32 hash; ///< Hash of the polygons
+	Common::Array<int16> polygons; ///< Vertex count and points of each polygon with edges
+	Common::Array<byte> visible; ///< Visibility of each vertex pair, 0 if not computed yet
+};
+
 struct EngineState : public Common::Serializable {
 public:
 	EngineState(SegManager *segMan);
@@ -176,6 +198,7 @@ public:
 	int16 gameIsRestarting; // is set when restarting (=1) or restoring the game (=2)
 
 	int scriptStepCounter; // Counts the number of steps executed
+	uint32 opcodeCounters[128]; // Counts the number of steps executed per opcode
 	int scriptGCInterval; // Number of steps in between gcs
 
 	uint16 currentRoomNumber() const;
@@ -193,6 +216,9 @@ public:
 	void shrinkStackToBase();
 
 	int gcCountDown; /**< Number of kernel calls until next gc */
+	GCStatistics gcStatistics;
+
+	Common::List<VisibilityGraph> _visibilityGraphs; ///< Pathfinding cache, most recently created first
 
 	MessageState *_msgState;
 
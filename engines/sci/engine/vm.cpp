@@ -551,7 +551,6 @@ void run_vm(EngineState *s) {
 	int temp;
 	reg_t r_temp; // Temporary register
 	StackPtr s_temp; // Temporary stack pointer
-	int16 opparams[4]; // opcode parameters
 
 	s->r_rest = 0;	// &rest adjusts the parameter count by this value
 	// Current execution data:
@@ -631,10 +630,14 @@ void run_vm(EngineState *s) {
 			error("run_vm(): program counter gone astray, addr: %d, code buffer size: %d",
 			s->xs->addr.pc.getOffset(), scr->getBufSize());
 
-		// Get opcode
-		byte extOpcode;
-		s->xs->addr.pc.incOffset(readPMachineInstruction(scr->getBuf(s->xs->addr.pc.getOffset()), extOpcode, opparams));
+		// Get opcode. The instruction is copied, as kernel calls may run
+		// scripts and decode further instructions.
+		const PMachineInstruction instruction = scr->getInstruction(s->xs->addr.pc.getOffset());
+		const int16 *opparams = instruction.opparams;
+		s->xs->addr.pc.incOffset(instruction.size);
+		const byte extOpcode = instruction.extOpcode;
 		const byte opcode = extOpcode >> 1;
+		++s->opcodeCounters[opcode];
 		//debug("%s: %d, %d, %d, %d, acc = %04x:%04x, script %d, local script %d", opcodeNames[opcode], opparams[0], opparams[1], opparams[2], opparams[3], PRINT_REG(s->r_acc), scr->getScriptNumber(), local_script->getScriptNumber());
 
 #ifdef ABORT_ON_INFINITE_LOOP
@@ -855,10 +858,15 @@ void run_vm(EngineState *s) {
 		}
 
 		case op_callk: { // 0x21 (33)
-			// Run the garbage collector, if needed
+			// Run the garbage collector, if needed. Without any allocations
+			// since the last run, the memory use cannot have grown, so the
+			// collection is put off until there is something new to collect.
 			if (s->gcCountDown-- <= 0) {
 				s->gcCountDown = s->scriptGCInterval;
-				run_gc(s);
+				if (s->_segMan->getAllocationCounter())
+					run_gc(s);
+				else
+					s->gcStatistics.skipped++;
 			}
 
 			// Call kernel function
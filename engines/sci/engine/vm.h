@@ -366,6 +366,17 @@ SelectorType lookupSelector(SegManager *segMan, reg_t obj, Selector selectorid,
  */
 int readPMachineInstruction(const byte *src, byte &extOpcode, int16 opparams[4]);
 
+/**
+ * A PMachine instruction, as decoded by readPMachineInstruction(). Scripts
+ * keep the instructions that have been executed in this form, so that the
+ * VM does not have to decode them again. See Script::getInstruction().
+ */
+struct PMachineInstruction {
+	int16 opparams[4];	///< Parameters of the instruction
+	byte extOpcode;		///< "Extended" opcode of the instruction
+	uint16 size;		///< Length in bytes of the instruction
+};
+
 } // End of namespace Sci
 
 #endif // SCI_ENGINE_VM_H
@@ -27,6 +27,7 @@
 #include "sci/sci.h"
 #include "sci/event.h"
 #include "sci/console.h"
+#include "sci/resource.h"
 #include "sci/engine/state.h"
 #include "sci/engine/kernel.h"
 #include "sci/graphics/screen.h"
@@ -362,16 +363,28 @@ SciEvent EventManager::getSciEvent(uint32 mask) {
 	return event;
 }
 
+// Milliseconds before the end of a sleep in which no more resources are
+// prefetched, to leave time for decompressing the last one
+static const uint32 kPrefetchMargin = 20;
+
 void SciEngine::sleep(uint32 msecs) {
 	uint32 time;
 	const uint32 wakeUpTime = g_system->getMillis() + msecs;
+	// Prefetching does not change the game state, so it is timed without
+	// the event recorder
+	const uint32 prefetchEndTime = g_system->getMillis(true) + msecs;
 
 	while (true) {
 		// let backend process events and update the screen
 		_eventMan->getSciEvent(SCI_EVENT_PEEK);
 		time = g_system->getMillis();
 		if (time + 10 < wakeUpTime) {
-			g_system->delayMillis(10);
+			// Use the spare time to prefetch the resources of the next room.
+			// Decompressing a resource can take a while, so stop early
+			// enough not to oversleep.
+			const bool canPrefetch = g_system->getMillis(true) + kPrefetchMargin < prefetchEndTime;
+			if (!canPrefetch || !_resMan->prefetchResource())
+				g_system->delayMillis(10);
 		} else {
 			if (time < wakeUpTime)
 				g_system->delayMillis(wakeUpTime - time);
@@ -589,6 +589,90 @@ struct RENDERER {
 	}
 };
 
+// Unscaled cels which are not mirrored read each row from contiguous
+// memory, so the common cases of drawing them copy whole rows instead of
+// going through the mapper pixel by pixel.
+
+template <typename READER>
+struct RENDERER<MAPPER_NoMDNoSkip, SCALER_NoScale<false, READER> > {
+	SCALER_NoScale<false, READER> &_scaler;
+
+	RENDERER(MAPPER_NoMDNoSkip &, SCALER_NoScale<false, READER> &scaler, const uint8) :
+	_scaler(scaler) {}
+
+	inline void draw(Buffer &target, const Common::Rect &targetRect, const Common::Point &scaledPosition) const {
+		const int16 sourceX = targetRect.left - scaledPosition.x;
+		const int16 sourceY = targetRect.top - scaledPosition.y;
+
+		byte *targetPixel = (byte *)target.getPixels() + target.screenWidth * targetRect.top + targetRect.left;
+
+		const int16 targetWidth = targetRect.width();
+		const int16 targetHeight = targetRect.height();
+		for (int y = 0; y < targetHeight; ++y) {
+			_scaler.setSource(sourceX, sourceY + y);
+			memcpy(targetPixel, _scaler._row, targetWidth);
+			targetPixel += target.screenWidth;
+		}
+	}
+};
+
+template <typename READER>
+struct RENDERER<MAPPER_NoMD, SCALER_NoScale<false, READER> > {
+	SCALER_NoScale<false, READER> &_scaler;
+	const uint8 _skipColor;
+
+	RENDERER(MAPPER_NoMD &, SCALER_NoScale<false, READER> &scaler, const uint8 skipColor) :
+	_scaler(scaler),
+	_skipColor(skipColor) {}
+
+	inline void draw(Buffer &target, const Common::Rect &targetRect, const Common::Point &scaledPosition) const {
+		const int16 sourceX = targetRect.left - scaledPosition.x;
+		const int16 sourceY = targetRect.top - scaledPosition.y;
+
+		byte *targetPixel = (byte *)target.getPixels() + target.screenWidth * targetRect.top + targetRect.left;
+
+		// The skip color in each byte, to test four pixels at once
+		const uint32 skipPattern = _skipColor * 0x01010101;
+
+		const int16 targetWidth = targetRect.width();
+		const int16 targetHeight = targetRect.height();
+		for (int y = 0; y < targetHeight; ++y) {
+			_scaler.setSource(sourceX, sourceY + y);
+			const byte *sourcePixel = _scaler._row;
+
+			int x = 0;
+			for (; x + 4 <= targetWidth; x += 4) {
+				const uint32 pixels = READ_UINT32(sourcePixel + x);
+				const uint32 diff = pixels ^ skipPattern;
+
+				if (diff == 0) {
+					// All four pixels are transparent
+					continue;
+				}
+
+				if (((diff - 0x01010101) & ~diff & 0x80808080) == 0) {
+					// None of the four pixels is transparent
+					WRITE_UINT32(targetPixel + x, pixels);
+				} else {
+					for (int i = x; i < x + 4; ++i) {
+						if (sourcePixel[i] != _skipColor) {
+							targetPixel[i] = sourcePixel[i];
+						}
+					}
+				}
+			}
+
+			for (; x < targetWidth; ++x) {
+				if (sourcePixel[x] != _skipColor) {
+					targetPixel[x] = sourcePixel[x];
+				}
+			}
+
+			targetPixel += target.screenWidth;
+		}
+	}
+};
+
 template <typename MAPPER, typename SCALER>
 void CelObj::render(Buffer &target, const Common::Rect &targetRect, const Common::Point &scaledPosition) const {
 
@@ -22,6 +22,8 @@
 
 // Resource library
 
+#include "common/algorithm.h"
+#include "common/config-manager.h"
 #include "common/file.h"
 #include "common/fs.h"
 #include "common/macresman.h"
@@ -870,6 +872,9 @@ void ResourceManager::init() {
 	_LRU.clear();
 	_resMap.clear();
 	_audioMapSCI1 = NULL;
+	_currentRoom = -1;
+	_roomHistory.clear();
+	_prefetchQueue.clear();
 
 	// FIXME: put this in an Init() function, so that we can error out if detection fails completely
 
@@ -922,9 +927,24 @@ void ResourceManager::init() {
 	// games and can cause immediate exhaustion of the LRU resource
 	// cache, leading to constant decompression of picture resources
 	// and making the renderer very slow.
+#ifdef REDUCE_MEMORY_USAGE
 	if (getSciVersion() >= SCI_VERSION_2) {
 		_maxMemoryLRU = 2048 * 1024; // 2MiB
 	}
+#else
+	// Where memory is not scarce, keep the resources of several rooms
+	// around, instead of loading them again on every room change.
+	if (getSciVersion() >= SCI_VERSION_2) {
+		_maxMemoryLRU = 32 * 1024 * 1024; // 32MiB
+	} else {
+		_maxMemoryLRU = 4 * 1024 * 1024; // 4MiB
+	}
+#endif
+
+	// The limit can also be set in KiB by the user
+	if (ConfMan.hasKey("resource_cache_size"))
+		_maxMemoryLRU = MAX(ConfMan.getInt("resource_cache_size"), 256) * 1024;
+	debugC(1, kDebugLevelResMan, "resMan: Keeping up to %d KiB of unlocked resources", _maxMemoryLRU / 1024);
 
 	switch (_viewType) {
 	case kViewEga:
@@ -1040,10 +1060,15 @@ Resource *ResourceManager::findResource(ResourceId id, bool lock) {
 	if (!retval)
 		return NULL;
 
-	if (retval->_status == kResStatusNoMalloc)
+	if (retval->_status == kResStatusNoMalloc) {
 		loadResource(retval);
-	else if (retval->_status == kResStatusEnqueued)
+		addRoomResource(id);
+	} else if (retval->_status == kResStatusEnqueued) {
+		// Resources that are still cached from an earlier room are part of
+		// this room, too, so that they get prefetched on the next visit
 		removeFromLRU(retval);
+		addRoomResource(id);
+	}
 	// Unless an error occurred, the resource is now either
 	// locked or allocated, but never queued or freed.
 
@@ -1086,6 +1111,138 @@ void ResourceManager::unlockResource(Resource *res) {
 	freeOldResources();
 }
 
+void ResourceManager::addRoomResource(ResourceId id) {
+	if (_currentRoom == -1)
+		return;
+
+	switch (id.getType()) {
+	case kResourceTypeView:
+	case kResourceTypePic:
+	case kResourceTypeScript:
+	case kResourceTypeHeap:
+	case kResourceTypePalette:
+		break;
+	default:
+		// Sounds and audio are streamed or cached elsewhere
+		return;
+	}
+
+	Common::Array<ResourceId> &resources = _roomHistory[_currentRoom].resources;
+	if (Common::find(resources.begin(), resources.end(), id) == resources.end())
+		resources.push_back(id);
+}
+
+void ResourceManager::enterRoom(int room) {
+	if (room == _currentRoom)
+		return;
+
+	if (_currentRoom != -1) {
+		Common::Array<int> &exits = _roomHistory[_currentRoom].exits;
+		if (Common::find(exits.begin(), exits.end(), room) == exits.end())
+			exits.push_back(room);
+	}
+
+	_currentRoom = room;
+
+	// Queue the resources of the rooms that were entered from this room
+	// before, as the game will most likely go to one of them next
+	_prefetchQueue.clear();
+
+	RoomHistoryMap::const_iterator history = _roomHistory.find(room);
+	if (history == _roomHistory.end())
+		return;
+
+	for (uint i = 0; i < history->_value.exits.size(); i++) {
+		RoomHistoryMap::const_iterator next = _roomHistory.find(history->_value.exits[i]);
+		if (next == _roomHistory.end())
+			continue;
+
+		for (uint j = 0; j < next->_value.resources.size(); j++)
+			_prefetchQueue.push_back(next->_value.resources[j]);
+	}
+
+	debugC(2, kDebugLevelResMan, "resMan: Entered room %d, %d resources queued for prefetching", room, _prefetchQueue.size());
+}
+
+bool ResourceManager::prefetchResource() {
+	while (!_prefetchQueue.empty()) {
+		// Stop once the cache is getting full, so that prefetching does not
+		// push out resources that are still in use
+		if (_memoryLRU >= _maxMemoryLRU / 4 * 3) {
+			_prefetchQueue.clear();
+			return false;
+		}
+
+		Resource *res = testResource(_prefetchQueue.front());
+		_prefetchQueue.pop_front();
+
+		if (!res || res->_status != kResStatusNoMalloc)
+			continue; // Already in memory
+
+		loadResource(res);
+		if (res->_status != kResStatusAllocated)
+			continue;
+
+		debugC(2, kDebugLevelResMan, "resMan: Prefetched %s", res->_id.toString().c_str());
+		addToLRU(res);
+		freeOldResources();
+		return true;
+	}
+
+	return false;
+}
+
+void ResourceManager::loadRoomHistory(Common::SeekableReadStream *stream) {
+	_roomHistory.clear();
+
+	if (stream->readUint32BE() != MKTAG('R', 'O', 'O', 'M') || stream->readByte() != 1)
+		return;
+
+	uint16 rooms = stream->readUint16LE();
+	while (rooms-- && !stream->eos()) {
+		RoomHistory &history = _roomHistory[stream->readUint16LE()];
+
+		uint16 count = stream->readUint16LE();
+		while (count-- && !stream->eos())
+			history.exits.push_back(stream->readUint16LE());
+
+		count = stream->readUint16LE();
+		while (count-- && !stream->eos()) {
+			const ResourceType type = (ResourceType)stream->readByte();
+			const uint16 number = stream->readUint16LE();
+			const uint32 tuple = stream->readUint32LE();
+			history.resources.push_back(ResourceId(type, number, tuple));
+		}
+	}
+
+	if (stream->eos()) {
+		warning("resMan: Room history is truncated, ignoring it");
+		_roomHistory.clear();
+	}
+}
+
+void ResourceManager::saveRoomHistory(Common::WriteStream *stream) {
+	stream->writeUint32BE(MKTAG('R', 'O', 'O', 'M'));
+	stream->writeByte(1); // version
+
+	stream->writeUint16LE(_roomHistory.size());
+	for (RoomHistoryMap::const_iterator i = _roomHistory.begin(); i != _roomHistory.end(); ++i) {
+		const RoomHistory &history = i->_value;
+		stream->writeUint16LE(i->_key);
+
+		stream->writeUint16LE(history.exits.size());
+		for (uint j = 0; j < history.exits.size(); j++)
+			stream->writeUint16LE(history.exits[j]);
+
+		stream->writeUint16LE(history.resources.size());
+		for (uint j = 0; j < history.resources.size(); j++) {
+			stream->writeByte(history.resources[j].getType());
+			stream->writeUint16LE(history.resources[j].getNumber());
+			stream->writeUint32LE(history.resources[j].getTuple());
+		}
+	}
+}
+
 const char *ResourceManager::versionDescription(ResVersion version) const {
 	switch (version) {
 	case kResVersionUnknown:
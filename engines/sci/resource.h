@@ -340,6 +340,33 @@ public:
 	 */
 	void unlockResource(Resource *res);
 
+	/**
+	 * Tells the resource manager that the game has entered a room. The views,
+	 * pics and scripts loaded from now on are remembered for this room. The
+	 * ones remembered for the rooms that were entered from this room before
+	 * are queued for prefetchResource().
+	 * @param room	The number of the room
+	 */
+	void enterRoom(int room);
+
+	/**
+	 * Loads the next resource queued by enterRoom(), as long as this does
+	 * not push other resources out of memory.
+	 * @return true if a resource was loaded
+	 */
+	bool prefetchResource();
+
+	/**
+	 * Reads the rooms and resources remembered by enterRoom() during earlier
+	 * runs of the game, as written by saveRoomHistory().
+	 */
+	void loadRoomHistory(Common::SeekableReadStream *stream);
+
+	/**
+	 * Writes the rooms and resources remembered by enterRoom().
+	 */
+	void saveRoomHistory(Common::WriteStream *stream);
+
 	/**
 	 * Tests whether a resource exists.
 	 *
@@ -434,6 +461,17 @@ protected:
 	ResVersion _volVersion; ///< resource.0xx version
 	ResVersion _mapVersion; ///< resource.map version
 
+	/** Rooms that were entered from a room, and the resources loaded in a room */
+	struct RoomHistory {
+		Common::Array<int> exits;
+		Common::Array<ResourceId> resources;
+	};
+	typedef Common::HashMap<int, RoomHistory> RoomHistoryMap;
+
+	int _currentRoom; ///< Room passed to enterRoom(), -1 if none
+	RoomHistoryMap _roomHistory;
+	Common::List<ResourceId> _prefetchQueue; ///< Resources to load in prefetchResource()
+
 	/**
 	 * Add a path to the resource manager's list of sources.
 	 * @return a pointer to the added source structure, or NULL if an error occurred.
@@ -548,6 +586,9 @@ protected:
 	void addToLRU(Resource *res);
 	void removeFromLRU(Resource *res);
 
+	/** Remembers a resource loaded in the current room, see enterRoom() */
+	void addRoomResource(ResourceId id);
+
 	ResourceCompression getViewCompression();
 	ViewType detectViewType();
 	bool hasSci0Voc999();
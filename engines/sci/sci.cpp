@@ -23,6 +23,7 @@
 #include "common/system.h"
 #include "common/config-manager.h"
 #include "common/debug-channels.h"
+#include "common/savefile.h"
 
 #include "engines/advancedDetector.h"
 #include "engines/util.h"
@@ -205,6 +206,13 @@ Common::Error SciEngine::run() {
 	_resMan->addAppropriateSources();
 	_resMan->init();
 
+	// Rooms and resources remembered during earlier runs, for prefetching
+	Common::InSaveFile *roomHistory = _saveFileMan->openForLoading(_targetName + ".rooms");
+	if (roomHistory) {
+		_resMan->loadRoomHistory(roomHistory);
+		delete roomHistory;
+	}
+
 	// TODO: Add error handling. Check return values of addAppropriateSources
 	// and init. We first have to *add* sensible return values, though ;).
 /*
@@ -386,6 +394,13 @@ Common::Error SciEngine::run() {
 
 	runGame();
 
+	Common::OutSaveFile *roomHistoryOut = _saveFileMan->openForSaving(_targetName + ".rooms", false);
+	if (roomHistoryOut) {
+		_resMan->saveRoomHistory(roomHistoryOut);
+		roomHistoryOut->finalize();
+		delete roomHistoryOut;
+	}
+
 	ConfMan.flushToDisk();
 
 	return Common::kNoError;
@@ -26,6 +26,12 @@
 #include "common/system.h"
 #include "common/textconsole.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 int gBitFormat = 565;
 
 #ifdef USE_HQ_SCALERS
@@ -209,7 +215,30 @@ void Normal2x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPit
 	assert(IS_ALIGNED(dstPtr, 4));
 	while (height--) {
 		r = dstPtr;
-		for (int i = 0; i < width; ++i, r += 4) {
+		int i = 0;
+#if defined(__SSE2__)
+		for (; i + 8 <= width; i += 8, r += 32) {
+			const __m128i color = _mm_loadu_si128((const __m128i *)((const uint16 *)srcPtr + i));
+			const __m128i lo = _mm_unpacklo_epi16(color, color);
+			const __m128i hi = _mm_unpackhi_epi16(color, color);
+
+			_mm_storeu_si128((__m128i *)r, lo);
+			_mm_storeu_si128((__m128i *)(r + 16), hi);
+			_mm_storeu_si128((__m128i *)(r + dstPitch), lo);
+			_mm_storeu_si128((__m128i *)(r + dstPitch + 16), hi);
+		}
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+		for (; i + 8 <= width; i += 8, r += 32) {
+			const uint16x8_t color = vld1q_u16((const uint16 *)srcPtr + i);
+			uint16x8x2_t doubled;
+			doubled.val[0] = color;
+			doubled.val[1] = color;
+
+			vst2q_u16((uint16 *)r, doubled);
+			vst2q_u16((uint16 *)(r + dstPitch), doubled);
+		}
+#endif
+		for (; i < width; ++i, r += 4) {
 			uint32 color = *(((const uint16 *)srcPtr) + i);
 
 			color |= color << 16;
@@ -241,13 +270,12 @@ void Normal3x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPit
 			*(uint16 *)(r + 0) = color;
 			*(uint16 *)(r + 2) = color;
 			*(uint16 *)(r + 4) = color;
-			*(uint16 *)(r + 0 + dstPitch) = color;
-			*(uint16 *)(r + 2 + dstPitch) = color;
-			*(uint16 *)(r + 4 + dstPitch) = color;
-			*(uint16 *)(r + 0 + dstPitch2) = color;
-			*(uint16 *)(r + 2 + dstPitch2) = color;
-			*(uint16 *)(r + 4 + dstPitch2) = color;
 		}
+
+		// The other two rows are identical, so copy them in one go
+		memcpy(dstPtr + dstPitch, dstPtr, width * 6);
+		memcpy(dstPtr + dstPitch2, dstPtr, width * 6);
+
 		srcPtr += srcPitch;
 		dstPtr += dstPitch3;
 	}
@@ -220,3 +220,183 @@ void scale3x_32_def(scale3x_uint32* dst0, scale3x_uint32* dst1, scale3x_uint32*
 	scale3x_32_def_center(dst1, src0, src1, src2, count);
 	scale3x_32_def_border(dst2, src2, src1, src0, count);
 }
+
+/***************************************************************************/
+/* Scale3x SSE2/NEON implementation */
+
+#if defined(__SSE2__)
+
+#include <emmintrin.h>
+
+static inline __m128i scale3x_sse2_select(__m128i mask, __m128i a, __m128i b) {
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static inline void scale3x_sse2_store(scale3x_uint16* dst, __m128i p0, __m128i p1, __m128i p2) {
+	/* SSE2 has no three way interleave, so go through memory */
+	scale3x_uint16 out[3][8];
+	unsigned i;
+
+	_mm_storeu_si128((__m128i *)out[0], p0);
+	_mm_storeu_si128((__m128i *)out[1], p1);
+	_mm_storeu_si128((__m128i *)out[2], p2);
+
+	for (i = 0; i < 8; ++i) {
+		dst[0] = out[0][i];
+		dst[1] = out[1][i];
+		dst[2] = out[2][i];
+		dst += 3;
+	}
+}
+
+/* Eight pixels at a time; identical results to scale3x_16_def_border */
+static inline void scale3x_16_sse2_border(scale3x_uint16* __restrict__ dst, const scale3x_uint16* __restrict__ src0, const scale3x_uint16* __restrict__ src1, const scale3x_uint16* __restrict__ src2, unsigned count) {
+	while (count >= 8) {
+		const __m128i A = _mm_loadu_si128((const __m128i *)(src0 - 1));
+		const __m128i B = _mm_loadu_si128((const __m128i *)(src0));
+		const __m128i C = _mm_loadu_si128((const __m128i *)(src0 + 1));
+		const __m128i D = _mm_loadu_si128((const __m128i *)(src1 - 1));
+		const __m128i E = _mm_loadu_si128((const __m128i *)(src1));
+		const __m128i F = _mm_loadu_si128((const __m128i *)(src1 + 1));
+		const __m128i H = _mm_loadu_si128((const __m128i *)(src2));
+
+		const __m128i active = _mm_andnot_si128(_mm_or_si128(_mm_cmpeq_epi16(B, H), _mm_cmpeq_epi16(D, F)), _mm_cmpeq_epi16(E, E));
+		const __m128i DB = _mm_and_si128(active, _mm_cmpeq_epi16(D, B));
+		const __m128i FB = _mm_and_si128(active, _mm_cmpeq_epi16(F, B));
+		const __m128i mid = _mm_or_si128(_mm_andnot_si128(_mm_cmpeq_epi16(E, C), DB), _mm_andnot_si128(_mm_cmpeq_epi16(E, A), FB));
+
+		scale3x_sse2_store(dst, scale3x_sse2_select(DB, D, E), scale3x_sse2_select(mid, B, E), scale3x_sse2_select(FB, F, E));
+
+		src0 += 8;
+		src1 += 8;
+		src2 += 8;
+		dst += 24;
+		count -= 8;
+	}
+
+	scale3x_16_def_border(dst, src0, src1, src2, count);
+}
+
+/* Eight pixels at a time; identical results to scale3x_16_def_center */
+static inline void scale3x_16_sse2_center(scale3x_uint16* __restrict__ dst, const scale3x_uint16* __restrict__ src0, const scale3x_uint16* __restrict__ src1, const scale3x_uint16* __restrict__ src2, unsigned count) {
+	while (count >= 8) {
+		const __m128i A = _mm_loadu_si128((const __m128i *)(src0 - 1));
+		const __m128i B = _mm_loadu_si128((const __m128i *)(src0));
+		const __m128i C = _mm_loadu_si128((const __m128i *)(src0 + 1));
+		const __m128i D = _mm_loadu_si128((const __m128i *)(src1 - 1));
+		const __m128i E = _mm_loadu_si128((const __m128i *)(src1));
+		const __m128i F = _mm_loadu_si128((const __m128i *)(src1 + 1));
+		const __m128i G = _mm_loadu_si128((const __m128i *)(src2 - 1));
+		const __m128i H = _mm_loadu_si128((const __m128i *)(src2));
+		const __m128i I = _mm_loadu_si128((const __m128i *)(src2 + 1));
+
+		const __m128i active = _mm_andnot_si128(_mm_or_si128(_mm_cmpeq_epi16(B, H), _mm_cmpeq_epi16(D, F)), _mm_cmpeq_epi16(E, E));
+		const __m128i left = _mm_or_si128(
+			_mm_andnot_si128(_mm_cmpeq_epi16(E, G), _mm_cmpeq_epi16(D, B)),
+			_mm_andnot_si128(_mm_cmpeq_epi16(E, A), _mm_cmpeq_epi16(D, H)));
+		const __m128i right = _mm_or_si128(
+			_mm_andnot_si128(_mm_cmpeq_epi16(E, I), _mm_cmpeq_epi16(F, B)),
+			_mm_andnot_si128(_mm_cmpeq_epi16(E, C), _mm_cmpeq_epi16(F, H)));
+
+		scale3x_sse2_store(dst, scale3x_sse2_select(_mm_and_si128(active, left), D, E), E, scale3x_sse2_select(_mm_and_si128(active, right), F, E));
+
+		src0 += 8;
+		src1 += 8;
+		src2 += 8;
+		dst += 24;
+		count -= 8;
+	}
+
+	scale3x_16_def_center(dst, src0, src1, src2, count);
+}
+
+/**
+ * Scale by a factor of 3 a row of pixels of 16 bits.
+ * This function operates like scale3x_16_def() but uses SSE2 instructions.
+ */
+void scale3x_16_sse2(scale3x_uint16* dst0, scale3x_uint16* dst1, scale3x_uint16* dst2, const scale3x_uint16* src0, const scale3x_uint16* src1, const scale3x_uint16* src2, unsigned count) {
+	scale3x_16_sse2_border(dst0, src0, src1, src2, count);
+	scale3x_16_sse2_center(dst1, src0, src1, src2, count);
+	scale3x_16_sse2_border(dst2, src2, src1, src0, count);
+}
+
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+
+#include <arm_neon.h>
+
+/* Eight pixels at a time; identical results to scale3x_16_def_border */
+static inline void scale3x_16_neon_border(scale3x_uint16* __restrict__ dst, const scale3x_uint16* __restrict__ src0, const scale3x_uint16* __restrict__ src1, const scale3x_uint16* __restrict__ src2, unsigned count) {
+	while (count >= 8) {
+		const uint16x8_t A = vld1q_u16(src0 - 1);
+		const uint16x8_t B = vld1q_u16(src0);
+		const uint16x8_t C = vld1q_u16(src0 + 1);
+		const uint16x8_t D = vld1q_u16(src1 - 1);
+		const uint16x8_t E = vld1q_u16(src1);
+		const uint16x8_t F = vld1q_u16(src1 + 1);
+		const uint16x8_t H = vld1q_u16(src2);
+
+		const uint16x8_t active = vmvnq_u16(vorrq_u16(vceqq_u16(B, H), vceqq_u16(D, F)));
+		const uint16x8_t DB = vandq_u16(active, vceqq_u16(D, B));
+		const uint16x8_t FB = vandq_u16(active, vceqq_u16(F, B));
+		const uint16x8_t mid = vorrq_u16(vbicq_u16(DB, vceqq_u16(E, C)), vbicq_u16(FB, vceqq_u16(E, A)));
+
+		uint16x8x3_t out;
+		out.val[0] = vbslq_u16(DB, D, E);
+		out.val[1] = vbslq_u16(mid, B, E);
+		out.val[2] = vbslq_u16(FB, F, E);
+		vst3q_u16(dst, out);
+
+		src0 += 8;
+		src1 += 8;
+		src2 += 8;
+		dst += 24;
+		count -= 8;
+	}
+
+	scale3x_16_def_border(dst, src0, src1, src2, count);
+}
+
+/* Eight pixels at a time; identical results to scale3x_16_def_center */
+static inline void scale3x_16_neon_center(scale3x_uint16* __restrict__ dst, const scale3x_uint16* __restrict__ src0, const scale3x_uint16* __restrict__ src1, const scale3x_uint16* __restrict__ src2, unsigned count) {
+	while (count >= 8) {
+		const uint16x8_t A = vld1q_u16(src0 - 1);
+		const uint16x8_t B = vld1q_u16(src0);
+		const uint16x8_t C = vld1q_u16(src0 + 1);
+		const uint16x8_t D = vld1q_u16(src1 - 1);
+		const uint16x8_t E = vld1q_u16(src1);
+		const uint16x8_t F = vld1q_u16(src1 + 1);
+		const uint16x8_t G = vld1q_u16(src2 - 1);
+		const uint16x8_t H = vld1q_u16(src2);
+		const uint16x8_t I = vld1q_u16(src2 + 1);
+
+		const uint16x8_t active = vmvnq_u16(vorrq_u16(vceqq_u16(B, H), vceqq_u16(D, F)));
+		const uint16x8_t left = vorrq_u16(vbicq_u16(vceqq_u16(D, B), vceqq_u16(E, G)), vbicq_u16(vceqq_u16(D, H), vceqq_u16(E, A)));
+		const uint16x8_t right = vorrq_u16(vbicq_u16(vceqq_u16(F, B), vceqq_u16(E, I)), vbicq_u16(vceqq_u16(F, H), vceqq_u16(E, C)));
+
+		uint16x8x3_t out;
+		out.val[0] = vbslq_u16(vandq_u16(active, left), D, E);
+		out.val[1] = E;
+		out.val[2] = vbslq_u16(vandq_u16(active, right), F, E);
+		vst3q_u16(dst, out);
+
+		src0 += 8;
+		src1 += 8;
+		src2 += 8;
+		dst += 24;
+		count -= 8;
+	}
+
+	scale3x_16_def_center(dst, src0, src1, src2, count);
+}
+
+/**
+ * Scale by a factor of 3 a row of pixels of 16 bits.
+ * This function operates like scale3x_16_def() but uses NEON instructions.
+ */
+void scale3x_16_neon(scale3x_uint16* dst0, scale3x_uint16* dst1, scale3x_uint16* dst2, const scale3x_uint16* src0, const scale3x_uint16* src1, const scale3x_uint16* src2, unsigned count) {
+	scale3x_16_neon_border(dst0, src0, src1, src2, count);
+	scale3x_16_neon_center(dst1, src0, src1, src2, count);
+	scale3x_16_neon_border(dst2, src2, src1, src0, count);
+}
+
+#endif
@@ -69,6 +69,42 @@ void writeTime(Common::WriteStream *outFile, uint32 d) {
 	}
 }
 
+/**
+ * Return the number at the end of a save file name, which is the save slot
+ * for almost all engines, or -1 if there is none.
+ */
+static int getSaveSlotFromFileName(const Common::String &fileName) {
+	int start = fileName.size();
+	while ((start > 0) && Common::isDigit(fileName[start - 1])) {
+		start--;
+	}
+	if (start == (int)fileName.size()) {
+		return -1;
+	}
+	return atoi(fileName.c_str() + start);
+}
+
+/**
+ * Keeps a savegame written for a keyframe in memory, and hands it to the
+ * recorder once the engine is done with it.
+ */
+class KeyframeSaveStream : public Common::MemoryWriteStreamDynamic {
+	typedef Common::HashMap<Common::String, Common::PlaybackFile::SaveFileBuffer> SaveFileMap;
+
+	Common::String _fileName;
+	SaveFileMap &_saveFiles;
+public:
+	KeyframeSaveStream(const Common::String &fileName, SaveFileMap &saveFiles)
+		: Common::MemoryWriteStreamDynamic(DisposeAfterUse::NO), _fileName(fileName), _saveFiles(saveFiles) {}
+
+	~KeyframeSaveStream() {
+		Common::PlaybackFile::SaveFileBuffer &buf = _saveFiles[_fileName];
+		free(buf.buffer);
+		buf.buffer = getData();
+		buf.size = size();
+	}
+};
+
 EventRecorder::EventRecorder() {
 	_timerManager = NULL;
 	_recordMode = kPassthrough;
@@ -76,6 +112,8 @@ EventRecorder::EventRecorder() {
 	_initialized = false;
 	_needRedraw = false;
 	_fastPlayback = false;
+	_turboPlayback = false;
+	_turboPlaybackDone = false;
 
 	_fakeTimer = 0;
 	_savedState = false;
@@ -87,6 +125,12 @@ EventRecorder::EventRecorder() {
 	_lastMillis = 0;
 	_lastScreenshotTime = 0;
 	_screenshotPeriod = 0;
+	_lastKeyframeTime = 0;
+	_keyframePeriod = 0;
+	_seekTime = 0;
+	_inKeyframe = false;
+	_keyframesSupported = true;
+	_discardSaveSlot = -1;
 	_playbackFile = 0;
 
 	DebugMan.addDebugChannel(kDebugLevelEventRec, "EventRec", "Event recorder debug level");
@@ -103,6 +147,7 @@ void EventRecorder::deinit() {
 		return;
 	}
 	setFileHeader();
+	const bool playbackFailed = (_recordMode == kRecorderPlayback) && !reportPlaybackResult();
 	_needRedraw = false;
 	_initialized = false;
 	_recordMode = kPassthrough;
@@ -118,13 +163,31 @@ void EventRecorder::deinit() {
 	switchMixer();
 	switchTimerManagers();
 	DebugMan.disableDebugChannel("EventRec");
+	if (playbackFailed && _turboPlayback) {
+		// Let scripts running regression replays see the failure
+		error("playback:action=error reason=\"screenshot mismatch\"");
+	}
+}
+
+/**
+ * Print how many of the screenshots of the recording matched the current
+ * screen. Returns false if any of them did not.
+ */
+bool EventRecorder::reportPlaybackResult() {
+	const Common::Array<uint32> &mismatches = _playbackFile->getScreenshotMismatches();
+	debug("playback:action=result screenshots=%d mismatches=%d", _playbackFile->getScreenshotsChecked(), mismatches.size());
+	for (uint i = 0; i < mismatches.size(); ++i) {
+		uint32 seconds = mismatches[i] / 1000;
+		debug("playback:action=result mismatch time=%.2d:%.2d:%.2d", seconds / 3600 % 24, seconds / 60 % 60, seconds % 60);
+	}
+	return mismatches.empty();
 }
 
 void EventRecorder::processMillis(uint32 &millis, bool skipRecord) {
 	if (!_initialized) {
 		return;
 	}
-	if (skipRecord) {
+	if (skipRecord || _inKeyframe) {
 		millis = _fakeTimer;
 		return;
 	}
@@ -154,7 +217,18 @@ void EventRecorder::processMillis(uint32 &millis, bool skipRecord) {
 			_timerManager->handler();
 		} else {
 			if (_nextEvent.type == Common::EVENT_RTL) {
-				error("playback:action=stopplayback");
+				if (!_turboPlayback) {
+					error("playback:action=stopplayback");
+				}
+				// Quit through the event queue rather than directly, so that
+				// deinit() still finalizes the files and reports the result
+				if (!_turboPlaybackDone) {
+					Common::Event quitEvent;
+					quitEvent.type = Common::EVENT_QUIT;
+					quitEvent.synthetic = true;
+					g_system->getEventManager()->pushEvent(quitEvent);
+					_turboPlaybackDone = true;
+				}
 			} else {
 				uint32 seconds = _fakeTimer / 1000;
 				Common::String screenTime = Common::String::format("%.2d:%.2d:%.2d", seconds / 3600 % 24, seconds / 60 % 60, seconds % 60);
@@ -163,6 +237,11 @@ void EventRecorder::processMillis(uint32 &millis, bool skipRecord) {
 		}
 		millis = _fakeTimer;
 		_controlPanel->setReplayedTime(_fakeTimer);
+		if ((_seekTime != 0) && (_fakeTimer >= _seekTime)) {
+			debugC(1, kDebugLevelEventRec, "playback:action=\"Seek\" result=done time=%d", _fakeTimer);
+			_seekTime = 0;
+			_fastPlayback = _turboPlayback;
+		}
 		break;
 	case kRecorderPlaybackPause:
 		millis = _fakeTimer;
@@ -183,9 +262,20 @@ void EventRecorder::checkForKeyCode(const Common::Event &event) {
 }
 
 bool EventRecorder::pollEvent(Common::Event &ev) {
-	if ((_recordMode != kRecorderPlayback) || !_initialized)
+	// Keyframes are saved and loaded here, since this is where the engine
+	// also handles the save and load requests of the main menu.
+	if (!_initialized || _inKeyframe)
+		return false;
+
+	if (_recordMode == kRecorderRecord)
+		takeKeyframe();
+
+	if (_recordMode != kRecorderPlayback || _turboPlaybackDone)
 		return false;
 
+	if (_seekTime > _fakeTimer)
+		jumpToKeyframe();
+
 	if ((_nextEvent.recordedtype == Common::kRecorderEventTypeTimer) || (_nextEvent.type ==  Common::EVENT_INVALID)) {
 		return false;
 	}
@@ -247,6 +337,19 @@ uint32 EventRecorder::getRandomSeed(const Common::String &name) {
 	return result;
 }
 
+void EventRecorder::registerRandomSource(const Common::String &name, Common::RandomSource *rnd) {
+	_randomSources[name] = rnd;
+}
+
+void EventRecorder::unregisterRandomSource(Common::RandomSource *rnd) {
+	for (RandomSourceMap::iterator i = _randomSources.begin(); i != _randomSources.end(); ++i) {
+		if (i->_value == rnd) {
+			_randomSources.erase(i);
+			return;
+		}
+	}
+}
+
 Common::String EventRecorder::generateRecordFileName(const Common::String &target) {
 	Common::String pattern(target+".r??");
 	Common::StringArray files = g_system->getSavefileManager()->listSavefiles(pattern);
@@ -283,6 +386,23 @@ void EventRecorder::init(Common::String recordFileName, RecordMode mode) {
 	if (_screenshotPeriod == 0) {
 		_screenshotPeriod = kDefaultScreenshotPeriod;
 	}
+	_lastKeyframeTime = 0;
+	_keyframesSupported = true;
+	_discardSaveSlot = -1;
+	// Keyframes are off by default: playback does not repeat the saves,
+	// which could make the game behave differently than when recording.
+	_keyframePeriod = ConfMan.getInt("record_keyframes") * 1000;
+	_seekTime = 0;
+	_turboPlayback = false;
+	_turboPlaybackDone = false;
+	if (_recordMode == kRecorderPlayback) {
+		// In turbo mode, getMillis(), the timers and the null mixer only
+		// advance with the recorded timer events, so skipping all delays
+		// keeps playback deterministic.
+		_turboPlayback = ConfMan.getBool("record_turbo");
+		_seekTime = ConfMan.getInt("record_seek") * 1000;
+		_fastPlayback = _turboPlayback || (_seekTime != 0);
+	}
 	if (!openRecordFile(recordFileName)) {
 		deinit();
 		error("playback:action=error reason=\"Record file loading error\"");
@@ -510,7 +630,7 @@ void EventRecorder::takeScreenshot() {
 	if ((_fakeTimer - _lastScreenshotTime) > _screenshotPeriod) {
 		Graphics::Surface screen;
 		uint8 md5[16];
-		if (grabScreenAndComputeMD5(screen, md5)) {
+		if (Common::PlaybackFile::grabScreenAndComputeMD5(screen, md5)) {
 			_lastScreenshotTime = _fakeTimer;
 			_playbackFile->saveScreenShot(screen, md5);
 			screen.free();
@@ -518,14 +638,83 @@ void EventRecorder::takeScreenshot() {
 	}
 }
 
-bool EventRecorder::grabScreenAndComputeMD5(Graphics::Surface &screen, uint8 md5[16]) {
-	if (!createScreenShot(screen)) {
-		warning("Can't save screenshot");
-		return false;
+void EventRecorder::takeKeyframe() {
+	if ((_keyframePeriod == 0) || !_keyframesSupported || ((_fakeTimer - _lastKeyframeTime) <= _keyframePeriod)) {
+		return;
 	}
-	Common::MemoryReadStream bitmapStream((const byte*)screen.getPixels(), screen.w * screen.h * screen.format.bytesPerPixel);
-	computeStreamMD5(bitmapStream, md5);
-	return true;
+	if (!g_engine || !g_engine->canSaveGameStateCurrently()) {
+		return;
+	}
+	_lastKeyframeTime = _fakeTimer;
+
+	const EnginePlugin *plugin = 0;
+	EngineMan.findGame(ConfMan.get("gameid"), &plugin);
+	if (!plugin) {
+		return;
+	}
+	const int slot = (*plugin)->getMaximumSaveSlot();
+
+	// The save files end up in _keyframeSaves, see processSaveOutStream().
+	// The time does not advance while saving, and no timer events are
+	// recorded, since playback does not repeat the save.
+	_inKeyframe = true;
+	Common::Error status = g_engine->saveGameState(slot, "Event recorder keyframe");
+	_inKeyframe = false;
+
+	if ((status.getCode() == Common::kNoError) && !_keyframeSaves.empty()) {
+		Common::PlaybackFile::RandomSeedsDictionary randomStates;
+		for (RandomSourceMap::iterator i = _randomSources.begin(); i != _randomSources.end(); ++i) {
+			randomStates[i->_key] = i->_value->getSeed();
+		}
+		_playbackFile->writeKeyframe(_fakeTimer, slot, _keyframeSaves, randomStates);
+	} else if (status.getCode() == Common::kNoError) {
+		// Some engines, like SCUMM, only request the save here and write
+		// it during one of the next frames. That save must not overwrite
+		// the real save slot, and the engine probably loads asynchronously
+		// as well, so there are no keyframes for it.
+		warning("The engine saves asynchronously, no keyframes are recorded");
+		_keyframesSupported = false;
+		_discardSaveSlot = slot;
+	}
+	for (Common::HashMap<Common::String, Common::PlaybackFile::SaveFileBuffer>::iterator i = _keyframeSaves.begin(); i != _keyframeSaves.end(); ++i) {
+		free(i->_value.buffer);
+	}
+	_keyframeSaves.clear();
+}
+
+void EventRecorder::jumpToKeyframe() {
+	if (!g_engine || !g_engine->canLoadGameStateCurrently()) {
+		return;
+	}
+
+	// Only jump forward, to the last keyframe before the seek target
+	const Common::Array<Common::PlaybackFile::Keyframe> &keyframes = _playbackFile->getKeyframes();
+	int index = -1;
+	for (uint i = 0; i < keyframes.size(); ++i) {
+		if ((keyframes[i].time > _fakeTimer) && (keyframes[i].time <= _seekTime)) {
+			index = i;
+		}
+	}
+	Common::PlaybackFile::RandomSeedsDictionary randomStates;
+	if ((index < 0) || !_playbackFile->seekToKeyframe(index, randomStates)) {
+		return;
+	}
+
+	_fakeTimer = keyframes[index].time;
+	_inKeyframe = true;
+	Common::Error status = g_engine->loadGameState(keyframes[index].slot);
+	_inKeyframe = false;
+	if (status.getCode() != Common::kNoError) {
+		error("playback:action=error reason=\"keyframe loading failed\"");
+	}
+	for (Common::PlaybackFile::RandomSeedsDictionary::iterator i = randomStates.begin(); i != randomStates.end(); ++i) {
+		RandomSourceMap::iterator rnd = _randomSources.find(i->_key);
+		if (rnd != _randomSources.end()) {
+			rnd->_value->setSeed(i->_value);
+		}
+	}
+	debugC(1, kDebugLevelEventRec, "playback:action=\"Seek\" result=keyframe time=%d", _fakeTimer);
+	_nextEvent = _playbackFile->getNextEvent();
 }
 
 Common::SeekableReadStream *EventRecorder::processSaveStream(const Common::String &fileName) {
@@ -547,6 +736,18 @@ Common::SeekableReadStream *EventRecorder::processSaveStream(const Common::Strin
 	}
 }
 
+Common::OutSaveFile *EventRecorder::processSaveOutStream(const Common::String &fileName) {
+	if (_inKeyframe) {
+		return new KeyframeSaveStream(fileName, _keyframeSaves);
+	}
+	if ((_discardSaveSlot >= 0) && (getSaveSlotFromFileName(fileName) == _discardSaveSlot)) {
+		debugC(1, kDebugLevelEventRec, "recorder:action=\"Discard keyframe save file\" filename=%s", fileName.c_str());
+		_discardSaveSlot = -1;
+		return new Common::MemoryWriteStreamDynamic(DisposeAfterUse::YES);
+	}
+	return NULL;
+}
+
 Common::SaveFileManager *EventRecorder::getSaveManager(Common::SaveFileManager *realSaveManager) {
 	_realSaveManager = realSaveManager;
 	if (_recordMode != kPassthrough) {
@@ -557,6 +758,9 @@ Common::SaveFileManager *EventRecorder::getSaveManager(Common::SaveFileManager *
 }
 
 void EventRecorder::preDrawOverlayGui() {
+	if (_turboPlayback && (_recordMode == kRecorderPlayback)) {
+		return;
+	}
     if ((_initialized) || (_needRedraw)) {
 		RecordMode oldMode = _recordMode;
 		_recordMode = kPassthrough;
@@ -571,6 +775,9 @@ void EventRecorder::preDrawOverlayGui() {
 }
 
 void EventRecorder::postDrawOverlayGui() {
+	if (_turboPlayback && (_recordMode == kRecorderPlayback)) {
+		return;
+	}
     if ((_initialized) || (_needRedraw)) {
 		RecordMode oldMode = _recordMode;
 		_recordMode = kPassthrough;
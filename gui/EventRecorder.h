@@ -50,6 +50,10 @@
 
 #define g_eventRec (GUI::EventRecorder::instance())
 
+namespace Common {
+	class RandomSource;
+}
+
 namespace GUI {
 	class OnScreenDialog;
 }
@@ -82,10 +86,14 @@ public:
 	void deinit();
 	bool processDelayMillis();
 	uint32 getRandomSeed(const Common::String &name);
+	/** Keep track of a random source, so that keyframes can store and restore its state */
+	void registerRandomSource(const Common::String &name, Common::RandomSource *rnd);
+	void unregisterRandomSource(Common::RandomSource *rnd);
 	void processMillis(uint32 &millis, bool skipRecord);
 	bool processAudio(uint32 &samples, bool paused);
 	void processGameDescription(const ADGameDescription *desc);
 	Common::SeekableReadStream *processSaveStream(const Common::String & fileName);
+	Common::OutSaveFile *processSaveOutStream(const Common::String &fileName);
 
 	/** Hooks for intercepting into GUI processing, so required events could be shoot
 	 *  or filtered out */
@@ -168,9 +176,6 @@ public:
 	SDL_Surface *getSurface(int width, int height);
 	void RegisterEventSource();
 
-	/** Retrieve game screenshot and compute its checksum for comparison */
-	bool grabScreenAndComputeMD5(Graphics::Surface &screen, uint8 md5[16]);
-
 	void updateSubsystems();
 	bool switchMode();
 	void switchFastMode();
@@ -209,6 +214,9 @@ private:
 	void togglePause();
 
 	void takeScreenshot();
+	void takeKeyframe();
+	bool reportPlaybackResult();
+	void jumpToKeyframe();
 
 	bool openRecordFile(const Common::String &fileName);
 
@@ -220,6 +228,19 @@ private:
 	volatile uint32 _lastMillis;
 	uint32 _lastScreenshotTime;
 	uint32 _screenshotPeriod;
+	uint32 _lastKeyframeTime;
+	uint32 _keyframePeriod;
+	/** Playback fast-forwards until this time, starting from the last keyframe before it */
+	uint32 _seekTime;
+	/** Set while the engine saves or loads a keyframe */
+	bool _inKeyframe;
+	/** Cleared once the engine turns out to save asynchronously */
+	bool _keyframesSupported;
+	/** Slot of a keyframe save the engine still has to write, which is discarded, or -1 */
+	int _discardSaveSlot;
+	Common::HashMap<Common::String, Common::PlaybackFile::SaveFileBuffer> _keyframeSaves;
+	typedef Common::HashMap<Common::String, Common::RandomSource *, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> RandomSourceMap;
+	RandomSourceMap _randomSources;
 	Common::PlaybackFile *_playbackFile;
 
 	void saveScreenShot();
@@ -228,6 +249,10 @@ private:
 	volatile RecordMode _recordMode;
 	Common::String _recordFileName;
 	bool _fastPlayback;
+	/** Play back as fast as possible and without the control panel, see --record-turbo */
+	bool _turboPlayback;
+	/** The end of a turbo playback was reached, and a quit event is pending */
+	bool _turboPlaybackDone;
 	bool _needRedraw;
 };
 
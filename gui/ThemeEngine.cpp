@@ -24,10 +24,16 @@
 #include "common/config-manager.h"
 #include "common/file.h"
 #include "common/fs.h"
+#include "common/md5.h"
+#include "common/memstream.h"
+#include "common/savefile.h"
+#include "common/serializer.h"
 #include "common/unzip.h"
 #include "common/tokenizer.h"
 #include "common/translation.h"
 
+#include "base/version.h"
+
 #include "graphics/cursorman.h"
 #include "graphics/fontman.h"
 #include "graphics/surface.h"
@@ -62,6 +68,11 @@ const char *const ThemeEngine::kImageFastReplaySmallButton = "fastreplay_small.b
 
 struct TextDrawData {
 	const Graphics::Font *_fontPtr;
+
+	/** The font files, as passed to ThemeEngine::addFont(). */
+	Common::String _file;
+	Common::String _scalableFile;
+	int _pointsize;
 };
 
 struct TextColorData {
@@ -284,6 +295,7 @@ ThemeEngine::ThemeEngine(Common::String id, GraphicsMode mode) :
 	_themeEval = new GUI::ThemeEval();
 
 	_useCursor = false;
+	_cursorHotspotX = _cursorHotspotY = 0;
 
 	for (int i = 0; i < kDrawDataMAX; ++i) {
 		_widgets[i] = 0;
@@ -584,6 +596,9 @@ bool ThemeEngine::addFont(TextData textId, const Common::String &file, const Com
 		delete _texts[textId];
 
 	_texts[textId] = new TextDrawData;
+	_texts[textId]->_file = file;
+	_texts[textId]->_scalableFile = scalableFile;
+	_texts[textId]->_pointsize = pointsize;
 
 	if (file == "default") {
 		_texts[textId]->_fontPtr = _font;
@@ -710,9 +725,8 @@ void ThemeEngine::loadTheme(const Common::String &themeId) {
 }
 
 void ThemeEngine::unloadTheme() {
-	if (!_themeOk)
-		return;
-
+	// This is also used to clean up after a failed load, so do not
+	// rely on _themeOk here.
 	for (int i = 0; i < kDrawDataMAX; ++i) {
 		delete _widgets[i];
 		_widgets[i] = 0;
@@ -729,6 +743,7 @@ void ThemeEngine::unloadTheme() {
 	}
 
 	_themeEval->reset();
+	_cursorFile.clear();
 	_themeOk = false;
 }
 
@@ -761,11 +776,22 @@ bool ThemeEngine::loadDefaultXML() {
 	_themeId = "builtin";
 	_themeFile.clear();
 
+	const bool useCache = ConfMan.getBool("gui_theme_cache");
+	const Common::String hash = useCache ? computeThemeHash() : Common::String();
+	if (useCache && loadThemeCache(hash)) {
+		_parser->close();
+		free(tmpXML);
+		return true;
+	}
+
 	bool result = _parser->parse();
 	_parser->close();
 
 	free(tmpXML);
 
+	if (result && useCache)
+		saveThemeCache(hash);
+
 	return result;
 #else
 	warning("The built-in theme is not enabled in the current build. Please load an external theme");
@@ -802,6 +828,12 @@ bool ThemeEngine::loadThemeXML(const Common::String &themeId) {
 		return false;
 	}
 
+	// Skip the parsing if the theme cache is up to date
+	const bool useCache = ConfMan.getBool("gui_theme_cache");
+	const Common::String hash = useCache ? computeThemeHash() : Common::String();
+	if (useCache && loadThemeCache(hash))
+		return true;
+
 	//
 	// Loop over all STX files, load and parse them
 	//
@@ -824,9 +856,424 @@ bool ThemeEngine::loadThemeXML(const Common::String &themeId) {
 	}
 
 	assert(!_themeName.empty());
+
+	if (useCache)
+		saveThemeCache(hash);
+
+	return true;
+}
+
+
+
+/**********************************************************
+ * Theme cache
+ *********************************************************/
+
+/** Version of the theme cache format. Increase it when changing the format. */
+#define THEME_CACHE_VERSION 1
+
+/** The drawing functions, in the order of their indices in theme caches. */
+static const Graphics::DrawingFunctionCallback kCacheDrawingFunctions[] = {
+	&Graphics::VectorRenderer::drawCallback_CIRCLE,
+	&Graphics::VectorRenderer::drawCallback_SQUARE,
+	&Graphics::VectorRenderer::drawCallback_ROUNDSQ,
+	&Graphics::VectorRenderer::drawCallback_BEVELSQ,
+	&Graphics::VectorRenderer::drawCallback_LINE,
+	&Graphics::VectorRenderer::drawCallback_TRIANGLE,
+	&Graphics::VectorRenderer::drawCallback_FILLSURFACE,
+	&Graphics::VectorRenderer::drawCallback_TAB,
+	&Graphics::VectorRenderer::drawCallback_VOID,
+	&Graphics::VectorRenderer::drawCallback_BITMAP,
+	&Graphics::VectorRenderer::drawCallback_CROSS
+};
+
+/** Identifies the theme files and the screen a theme cache was written for. */
+struct ThemeCacheHeader {
+	uint32 tag;
+	uint32 version;
+	Common::String hash;
+	uint16 overlayWidth, overlayHeight;
+	Graphics::PixelFormat format;
+
+	void sync(Common::Serializer &s) {
+		s.syncAsUint32BE(tag);
+		s.syncAsUint32LE(version);
+		s.syncString(hash);
+		s.syncAsUint16LE(overlayWidth);
+		s.syncAsUint16LE(overlayHeight);
+		s.syncAsByte(format.bytesPerPixel);
+		s.syncAsByte(format.rLoss);
+		s.syncAsByte(format.gLoss);
+		s.syncAsByte(format.bLoss);
+		s.syncAsByte(format.aLoss);
+		s.syncAsByte(format.rShift);
+		s.syncAsByte(format.gShift);
+		s.syncAsByte(format.bShift);
+		s.syncAsByte(format.aShift);
+	}
+
+	bool operator==(const ThemeCacheHeader &other) const {
+		return tag == other.tag && version == other.version && hash == other.hash &&
+		       overlayWidth == other.overlayWidth && overlayHeight == other.overlayHeight &&
+		       format == other.format;
+	}
+};
+
+static void syncColor(Common::Serializer &s, Graphics::DrawStep::Color &color) {
+	s.syncAsByte(color.r);
+	s.syncAsByte(color.g);
+	s.syncAsByte(color.b);
+	s.syncAsByte(color.set);
+}
+
+/**
+ * Syncs all members of a draw step, except for the drawing function and
+ * the bitmap, which are stored by their index and name instead.
+ */
+static void syncDrawStep(Common::Serializer &s, Graphics::DrawStep &step) {
+	syncColor(s, step.fgColor);
+	syncColor(s, step.bgColor);
+	syncColor(s, step.gradColor1);
+	syncColor(s, step.gradColor2);
+	syncColor(s, step.bevelColor);
+
+	s.syncAsByte(step.autoWidth);
+	s.syncAsByte(step.autoHeight);
+	s.syncAsSint16LE(step.x);
+	s.syncAsSint16LE(step.y);
+	s.syncAsSint16LE(step.w);
+	s.syncAsSint16LE(step.h);
+
+	s.syncAsSint16LE(step.padding.left);
+	s.syncAsSint16LE(step.padding.top);
+	s.syncAsSint16LE(step.padding.right);
+	s.syncAsSint16LE(step.padding.bottom);
+
+	s.syncAsByte(step.xAlign);
+	s.syncAsByte(step.yAlign);
+
+	s.syncAsByte(step.shadow);
+	s.syncAsByte(step.stroke);
+	s.syncAsByte(step.factor);
+	s.syncAsByte(step.radius);
+	s.syncAsByte(step.bevel);
+	s.syncAsByte(step.fillMode);
+	s.syncAsByte(step.shadowFillMode);
+
+	s.syncAsUint32LE(step.extraData);
+	s.syncAsUint32LE(step.scale);
+}
+
+Common::String ThemeEngine::computeThemeHash() {
+	// The builtin theme is part of the executable, just like the code that
+	// evaluates themes. So caches written by other versions are never used.
+	Common::String contents = gScummVMFullVersion;
+	contents += "\n";
+
+	if (_themeArchive) {
+		// Sort the files, so that the hash does not depend on the order
+		// in which the archive lists them.
+		Common::ArchiveMemberList members;
+		_themeArchive->listMembers(members);
+
+		Common::Array<Common::String> names;
+		for (Common::ArchiveMemberList::const_iterator i = members.begin(); i != members.end(); ++i)
+			names.push_back((*i)->getName());
+		Common::sort(names.begin(), names.end());
+
+		// Every file is part of the hash, not just the STX files: the cache
+		// holds the decoded images, so replacing one has to invalidate it,
+		// too. Reading all files would decompress the whole theme archive
+		// on every load, though, so the hash uses the CRC-32 of ZIP members
+		// and the modification time of plain files, along with their sizes.
+		// Only files without such a stamp are hashed by their contents.
+		for (uint i = 0; i < names.size(); ++i) {
+			uint32 stamp, size;
+			if (_themeArchive->getMemberStamp(names[i], stamp, size)) {
+				contents += Common::String::format("%s:%08x:%u\n", names[i].c_str(), stamp, size);
+				continue;
+			}
+
+			Common::SeekableReadStream *stream = _themeArchive->createReadStreamForMember(names[i]);
+			if (!stream)
+				continue;
+
+			contents += names[i] + ":" + Common::computeStreamMD5AsString(*stream) + "\n";
+			delete stream;
+		}
+	}
+
+	Common::MemoryReadStream stream((const byte *)contents.c_str(), contents.size());
+	return Common::computeStreamMD5AsString(stream);
+}
+
+Common::String ThemeEngine::getThemeCacheName() const {
+	return _themeId + ".themecache";
+}
+
+bool ThemeEngine::loadThemeCache(const Common::String &hash) {
+	Common::InSaveFile *file = _system->getSavefileManager()->openForLoading(getThemeCacheName());
+	if (!file)
+		return false;
+
+	// Read the whole cache at once, and load the theme from memory
+	const int32 size = file->size();
+	byte *data = size > 0 ? (byte *)malloc(size) : 0;
+	const bool readOk = data && file->read(data, size) == (uint32)size;
+	delete file;
+
+	if (!readOk) {
+		free(data);
+		return false;
+	}
+
+	Common::MemoryReadStream stream(data, size, DisposeAfterUse::YES);
+	Common::Serializer s(&stream, 0);
+
+	ThemeCacheHeader expected;
+	expected.tag = MKTAG('T', 'H', 'C', 'H');
+	expected.version = THEME_CACHE_VERSION;
+	expected.hash = hash;
+	expected.overlayWidth = _system->getOverlayWidth();
+	expected.overlayHeight = _system->getOverlayHeight();
+	expected.format = _overlayFormat;
+
+	ThemeCacheHeader header;
+	header.sync(s);
+
+	if (!(header == expected)) {
+		debug(3, "Theme cache '%s' is out of date", getThemeCacheName().c_str());
+		return false;
+	}
+
+	// Bitmaps, already converted to the overlay format. They are loaded
+	// first, since the draw steps and the cursor refer to them.
+	uint32 count = 0;
+	s.syncAsUint32LE(count);
+
+	while (count--) {
+		Common::String name;
+		byte present = 0;
+		s.syncString(name);
+		s.syncAsByte(present);
+
+		Graphics::Surface *surf = 0;
+		if (present) {
+			uint16 w = 0, h = 0;
+			s.syncAsUint16LE(w);
+			s.syncAsUint16LE(h);
+
+			const uint32 bytes = w * h * _overlayFormat.bytesPerPixel;
+			if (bytes > (uint32)(stream.size() - stream.pos())) {
+				unloadTheme();
+				return false;
+			}
+
+			surf = new Graphics::Surface();
+			surf->create(w, h, _overlayFormat);
+			for (uint y = 0; y < h; ++y)
+				s.syncBytes((byte *)surf->getBasePtr(0, y), w * _overlayFormat.bytesPerPixel);
+		}
+
+		if (_bitmaps.contains(name) && _bitmaps[name]) {
+			if (surf) {
+				surf->free();
+				delete surf;
+			}
+		} else {
+			_bitmaps[name] = surf;
+		}
+	}
+
+	for (int i = 0; i < kTextDataMAX; ++i) {
+		byte present = 0;
+		s.syncAsByte(present);
+		if (!present)
+			continue;
+
+		Common::String fontFile, scalableFile;
+		int32 pointsize = 0;
+		s.syncString(fontFile);
+		s.syncString(scalableFile);
+		s.syncAsSint32LE(pointsize);
+
+		addFont((TextData)i, fontFile, scalableFile, pointsize);
+	}
+
+	for (int i = 0; i < kTextColorMAX; ++i) {
+		byte present = 0;
+		s.syncAsByte(present);
+		if (!present)
+			continue;
+
+		byte r = 0, g = 0, b = 0;
+		s.syncAsByte(r);
+		s.syncAsByte(g);
+		s.syncAsByte(b);
+
+		addTextColor((TextColor)i, r, g, b);
+	}
+
+	for (int i = 0; i < kDrawDataMAX; ++i) {
+		byte present = 0;
+		s.syncAsByte(present);
+		if (!present)
+			continue;
+
+		WidgetDrawData *widget = new WidgetDrawData;
+		_widgets[i] = widget;
+
+		s.syncAsSint32LE(widget->_textDataId);
+		s.syncAsSint32LE(widget->_textColorId);
+		s.syncAsSint32LE(widget->_textAlignH);
+		s.syncAsSint32LE(widget->_textAlignV);
+		s.syncAsByte(widget->_buffer);
+
+		s.syncAsUint32LE(count);
+		while (count--) {
+			Graphics::DrawStep step;
+			byte function = 0;
+			Common::String bitmap;
+
+			syncDrawStep(s, step);
+			s.syncAsByte(function);
+			s.syncString(bitmap);
+
+			if (function >= ARRAYSIZE(kCacheDrawingFunctions)) {
+				unloadTheme();
+				return false;
+			}
+
+			step.drawingCall = kCacheDrawingFunctions[function];
+			step.blitSrc = bitmap.empty() ? 0 : getBitmap(bitmap);
+			widget->_steps.push_back(step);
+		}
+	}
+
+	Common::String cursorFile;
+	int32 hotspotX = 0, hotspotY = 0;
+	s.syncString(cursorFile);
+	s.syncAsSint32LE(hotspotX);
+	s.syncAsSint32LE(hotspotY);
+
+	if ((!cursorFile.empty() && !createCursor(cursorFile, hotspotX, hotspotY)) ||
+	    !_themeEval->loadFromCache(s) || stream.eos()) {
+		warning("Invalid theme cache '%s'", getThemeCacheName().c_str());
+		unloadTheme();
+		return false;
+	}
+
+	debug(3, "Loaded theme '%s' from the theme cache", _themeId.c_str());
 	return true;
 }
 
+void ThemeEngine::saveThemeCache(const Common::String &hash) {
+	Common::OutSaveFile *file = _system->getSavefileManager()->openForSaving(getThemeCacheName(), false);
+	if (!file)
+		return;
+
+	Common::Serializer s(0, file);
+
+	ThemeCacheHeader header;
+	header.tag = MKTAG('T', 'H', 'C', 'H');
+	header.version = THEME_CACHE_VERSION;
+	header.hash = hash;
+	header.overlayWidth = _system->getOverlayWidth();
+	header.overlayHeight = _system->getOverlayHeight();
+	header.format = _overlayFormat;
+	header.sync(s);
+
+	uint32 count = _bitmaps.size();
+	s.syncAsUint32LE(count);
+
+	for (ImagesMap::iterator i = _bitmaps.begin(); i != _bitmaps.end(); ++i) {
+		Common::String name = i->_key;
+		Graphics::Surface *surf = i->_value;
+		byte present = (surf != 0);
+		s.syncString(name);
+		s.syncAsByte(present);
+
+		if (surf) {
+			uint16 w = surf->w, h = surf->h;
+			s.syncAsUint16LE(w);
+			s.syncAsUint16LE(h);
+
+			for (uint y = 0; y < h; ++y)
+				s.syncBytes((byte *)surf->getBasePtr(0, y), w * surf->format.bytesPerPixel);
+		}
+	}
+
+	for (int i = 0; i < kTextDataMAX; ++i) {
+		byte present = (_texts[i] != 0);
+		s.syncAsByte(present);
+		if (!present)
+			continue;
+
+		int32 pointsize = _texts[i]->_pointsize;
+		s.syncString(_texts[i]->_file);
+		s.syncString(_texts[i]->_scalableFile);
+		s.syncAsSint32LE(pointsize);
+	}
+
+	for (int i = 0; i < kTextColorMAX; ++i) {
+		byte present = (_textColors[i] != 0);
+		s.syncAsByte(present);
+		if (!present)
+			continue;
+
+		s.syncAsByte(_textColors[i]->r);
+		s.syncAsByte(_textColors[i]->g);
+		s.syncAsByte(_textColors[i]->b);
+	}
+
+	for (int i = 0; i < kDrawDataMAX; ++i) {
+		WidgetDrawData *data = _widgets[i];
+		byte present = (data != 0);
+		s.syncAsByte(present);
+		if (!present)
+			continue;
+
+		s.syncAsSint32LE(data->_textDataId);
+		s.syncAsSint32LE(data->_textColorId);
+		s.syncAsSint32LE(data->_textAlignH);
+		s.syncAsSint32LE(data->_textAlignV);
+		s.syncAsByte(data->_buffer);
+
+		count = data->_steps.size();
+		s.syncAsUint32LE(count);
+
+		for (Common::List<Graphics::DrawStep>::iterator step = data->_steps.begin(); step != data->_steps.end(); ++step) {
+			byte function = 0;
+			while (function < ARRAYSIZE(kCacheDrawingFunctions) && kCacheDrawingFunctions[function] != step->drawingCall)
+				function++;
+
+			Common::String bitmap;
+			for (ImagesMap::iterator b = _bitmaps.begin(); step->blitSrc && b != _bitmaps.end(); ++b) {
+				if (b->_value == step->blitSrc) {
+					bitmap = b->_key;
+					break;
+				}
+			}
+
+			syncDrawStep(s, *step);
+			s.syncAsByte(function);
+			s.syncString(bitmap);
+		}
+	}
+
+	s.syncString(_cursorFile);
+	s.syncAsSint32LE(_cursorHotspotX);
+	s.syncAsSint32LE(_cursorHotspotY);
+
+	_themeEval->saveToCache(s);
+
+	file->finalize();
+	if (file->err())
+		warning("Failed to write theme cache '%s'", getThemeCacheName().c_str());
+
+	delete file;
+}
+
 
 
 /**********************************************************
@@ -1317,6 +1764,11 @@ void ThemeEngine::openDialog(bool doBuffer, ShadingStyle style) {
 }
 
 bool ThemeEngine::createCursor(const Common::String &filename, int hotspotX, int hotspotY) {
+	// Remember the cursor for the theme cache
+	_cursorFile = filename;
+	_cursorHotspotX = hotspotX;
+	_cursorHotspotY = hotspotY;
+
 	if (!_system->hasFeature(OSystem::kFeatureCursorPalette))
 		return true;
 
@@ -1332,9 +1784,6 @@ bool ThemeEngine::createCursor(const Common::String &filename, int hotspotX, int
 #endif
 
 	// Set up the cursor parameters
-	_cursorHotspotX = hotspotX;
-	_cursorHotspotY = hotspotY;
-
 	_cursorWidth = cursor->w;
 	_cursorHeight = cursor->h;
 
@@ -1616,11 +2065,9 @@ bool ThemeEngine::themeConfigUsable(const Common::FSNode &node, Common::String &
 			stream.open("THEMERC", *zipArchive);
 		}
 		// Delete the ZIP archive again. Note: This only works because
-		// stream.open() only uses ZipArchive::createReadStreamForMember,
-		// and that in turn happens to read all the data for a given
-		// archive member into a memory block. So there will be no dangling
-		// reference to zipArchive anywhere. This could change if we
-		// ever modify ZipArchive::createReadStreamForMember.
+		// the streams returned by ZipArchive::createReadStreamForMember
+		// share ownership of the ZIP file with the archive. So there will
+		// be no dangling reference to zipArchive anywhere.
 		delete zipArchive;
 	} else if (node.isDirectory()) {
 		Common::FSNode headerfile = node.getChild("THEMERC");
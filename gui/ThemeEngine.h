@@ -559,6 +559,33 @@ protected:
 	 */
 	void unloadTheme();
 
+	/**
+	 * Computes the hash that identifies the files of the current theme
+	 * archive in the theme cache. Every file is hashed with its size and
+	 * its stamp in the archive (the CRC-32 of ZIP members, the modification
+	 * time of plain files), or with its contents if it has no stamp.
+	 */
+	Common::String computeThemeHash();
+
+	/** Returns the name of the theme cache file of the current theme. */
+	Common::String getThemeCacheName() const;
+
+	/**
+	 * Loads the theme from the theme cache, instead of parsing its STX files.
+	 * The cache is only used if it was written for the given hash and for
+	 * the current overlay size and format.
+	 *
+	 * @param hash Hash of the theme files, which the cache must match.
+	 * @returns true if the theme was successfully loaded from the cache.
+	 */
+	bool loadThemeCache(const Common::String &hash);
+
+	/**
+	 * Writes the currently loaded theme to the theme cache, so that
+	 * the next start can skip parsing it.
+	 */
+	void saveThemeCache(const Common::String &hash);
+
 	const Graphics::Font *loadScalableFont(const Common::String &filename, const Common::String &charset, const int pointsize, Common::String &name);
 	const Graphics::Font *loadFont(const Common::String &filename, Common::String &name);
 	Common::String genCacheFilename(const Common::String &filename) const;
@@ -684,6 +711,7 @@ protected:
 	Common::SearchSet _themeFiles;
 
 	bool _useCursor;
+	Common::String _cursorFile; ///< Bitmap the cursor was created from
 	int _cursorHotspotX, _cursorHotspotY;
 	enum {
 		MAX_CURS_COLORS = 255
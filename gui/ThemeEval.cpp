@@ -24,6 +24,7 @@
 
 #include "graphics/scaler.h"
 
+#include "common/serializer.h"
 #include "common/system.h"
 #include "common/tokenizer.h"
 
@@ -50,6 +51,58 @@ void ThemeEval::reset() {
 	_layouts.clear();
 }
 
+void ThemeEval::saveToCache(Common::Serializer &s) {
+	uint32 count = _vars.size();
+	s.syncAsUint32LE(count);
+
+	for (VariablesMap::iterator i = _vars.begin(); i != _vars.end(); ++i) {
+		Common::String name = i->_key;
+		s.syncString(name);
+		s.syncAsSint32LE(i->_value);
+	}
+
+	count = _layouts.size();
+	s.syncAsUint32LE(count);
+
+	for (LayoutsMap::iterator i = _layouts.begin(); i != _layouts.end(); ++i) {
+		Common::String name = i->_key;
+		s.syncString(name);
+		i->_value->saveToCache(s);
+	}
+}
+
+bool ThemeEval::loadFromCache(Common::Serializer &s) {
+	reset();
+
+	uint32 count = 0;
+	s.syncAsUint32LE(count);
+
+	while (count--) {
+		Common::String name;
+		int value = 0;
+		s.syncString(name);
+		s.syncAsSint32LE(value);
+		_vars[name] = value;
+	}
+
+	s.syncAsUint32LE(count);
+
+	while (count--) {
+		Common::String name;
+		s.syncString(name);
+
+		ThemeLayout *layout = ThemeLayout::loadFromCache(s, 0);
+		if (!layout) {
+			reset();
+			return false;
+		}
+
+		_layouts[name] = layout;
+	}
+
+	return true;
+}
+
 bool ThemeEval::getWidgetData(const Common::String &widget, int16 &x, int16 &y, uint16 &w, uint16 &h) {
 	Common::StringTokenizer tokenizer(widget, ".");
 
@@ -33,6 +33,10 @@
 
 #include "gui/ThemeLayout.h"
 
+namespace Common {
+class Serializer;
+}
+
 namespace GUI {
 
 class ThemeEval {
@@ -97,6 +101,19 @@ public:
 
 	void reset();
 
+	/**
+	 * Saves the variables and the layouts of all dialogs to a theme cache.
+	 */
+	void saveToCache(Common::Serializer &s);
+
+	/**
+	 * Replaces the variables and layouts by the ones saved in a theme
+	 * cache by saveToCache().
+	 *
+	 * @return false if the data is invalid.
+	 */
+	bool loadFromCache(Common::Serializer &s);
+
 private:
 	VariablesMap _vars;
 	VariablesMap _builtin;
@@ -21,6 +21,7 @@
  */
 
 #include "common/util.h"
+#include "common/serializer.h"
 #include "common/system.h"
 
 #include "gui/ThemeLayout.h"
@@ -303,4 +304,93 @@ void ThemeLayoutStacked::reflowLayoutHorizontal() {
 	}
 }
 
+void ThemeLayout::saveToCache(Common::Serializer &s) {
+	byte type = getCacheType();
+	s.syncAsByte(type);
+	syncCache(s);
+
+	uint32 count = _children.size();
+	s.syncAsUint32LE(count);
+
+	for (uint i = 0; i < _children.size(); ++i)
+		_children[i]->saveToCache(s);
+}
+
+ThemeLayout *ThemeLayout::loadFromCache(Common::Serializer &s, ThemeLayout *parent) {
+	byte type = 0;
+	s.syncAsByte(type);
+
+	// The constructor arguments are overwritten by syncCache() below
+	ThemeLayout *layout;
+	switch (type) {
+	case kCacheMain:
+		layout = new ThemeLayoutMain(0, 0, 0, 0);
+		break;
+	case kCacheVertical:
+		layout = new ThemeLayoutStacked(parent, kLayoutVertical, 0, false);
+		break;
+	case kCacheHorizontal:
+		layout = new ThemeLayoutStacked(parent, kLayoutHorizontal, 0, false);
+		break;
+	case kCacheWidget:
+		layout = new ThemeLayoutWidget(parent, Common::String(), 0, 0, Graphics::kTextAlignInvalid);
+		break;
+	case kCacheSpacing:
+		if (!parent)
+			return 0;
+		layout = new ThemeLayoutSpacing(parent, 0);
+		break;
+	default:
+		return 0;
+	}
+
+	layout->syncCache(s);
+
+	uint32 count = 0;
+	s.syncAsUint32LE(count);
+
+	while (count--) {
+		ThemeLayout *child = loadFromCache(s, layout);
+		if (!child) {
+			delete layout;
+			return 0;
+		}
+
+		layout->addChild(child);
+	}
+
+	return layout;
+}
+
+void ThemeLayout::syncCache(Common::Serializer &s) {
+	s.syncAsSint16LE(_x);
+	s.syncAsSint16LE(_y);
+	s.syncAsSint16LE(_w);
+	s.syncAsSint16LE(_h);
+	s.syncAsSint16LE(_padding.left);
+	s.syncAsSint16LE(_padding.top);
+	s.syncAsSint16LE(_padding.right);
+	s.syncAsSint16LE(_padding.bottom);
+	s.syncAsByte(_centered);
+	s.syncAsSint16LE(_defaultW);
+	s.syncAsSint16LE(_defaultH);
+	s.syncAsSint32LE(_textHAlign);
+}
+
+void ThemeLayoutMain::syncCache(Common::Serializer &s) {
+	ThemeLayout::syncCache(s);
+	s.syncAsSint16LE(_defaultX);
+	s.syncAsSint16LE(_defaultY);
+}
+
+void ThemeLayoutStacked::syncCache(Common::Serializer &s) {
+	ThemeLayout::syncCache(s);
+	s.syncAsByte(_spacing);
+}
+
+void ThemeLayoutWidget::syncCache(Common::Serializer &s) {
+	ThemeLayout::syncCache(s);
+	s.syncString(_name);
+}
+
 } // End of namespace GUI
@@ -33,6 +33,10 @@ class Surface;
 }
 #endif
 
+namespace Common {
+class Serializer;
+}
+
 namespace GUI {
 
 class ThemeLayout {
@@ -104,6 +108,18 @@ public:
 
 	Graphics::TextAlign getTextHAlign() { return _textHAlign; }
 
+	/**
+	 * Saves the layout and all of its children to a theme cache.
+	 */
+	void saveToCache(Common::Serializer &s);
+
+	/**
+	 * Loads a layout and its children, as saved by saveToCache().
+	 *
+	 * @return The new layout, or 0 if the data is invalid.
+	 */
+	static ThemeLayout *loadFromCache(Common::Serializer &s, ThemeLayout *parent);
+
 #ifdef LAYOUT_DEBUG_DIALOG
 	void debugDraw(Graphics::Surface *screen, const Graphics::Font *font);
 
@@ -111,6 +127,20 @@ public:
 #endif
 
 protected:
+	/** The layout classes, as stored in theme caches. */
+	enum CacheType {
+		kCacheMain = 1,
+		kCacheVertical,
+		kCacheHorizontal,
+		kCacheWidget,
+		kCacheSpacing
+	};
+
+	virtual CacheType getCacheType() const = 0;
+
+	/** Syncs the members of the layout, but not its children. */
+	virtual void syncCache(Common::Serializer &s);
+
 	ThemeLayout *_parent;
 	int16 _x, _y, _w, _h;
 	Common::Rect _padding;
@@ -144,6 +174,9 @@ protected:
 	LayoutType getLayoutType() { return kLayoutMain; }
 	ThemeLayout *makeClone(ThemeLayout *newParent) { assert(!"Do not copy Main Layouts!"); return 0; }
 
+	CacheType getCacheType() const { return kCacheMain; }
+	void syncCache(Common::Serializer &s);
+
 	int16 _defaultX;
 	int16 _defaultY;
 };
@@ -179,6 +212,9 @@ protected:
 
 	LayoutType getLayoutType() { return _type; }
 
+	CacheType getCacheType() const { return (_type == kLayoutVertical) ? kCacheVertical : kCacheHorizontal; }
+	void syncCache(Common::Serializer &s);
+
 	ThemeLayout *makeClone(ThemeLayout *newParent) {
 		ThemeLayoutStacked *n = new ThemeLayoutStacked(*this);
 		n->_parent = newParent;
@@ -214,6 +250,9 @@ public:
 protected:
 	LayoutType getLayoutType() { return kLayoutWidget; }
 
+	CacheType getCacheType() const { return kCacheWidget; }
+	void syncCache(Common::Serializer &s);
+
 	ThemeLayout *makeClone(ThemeLayout *newParent) {
 		ThemeLayout *n = new ThemeLayoutWidget(*this);
 		n->_parent = newParent;
@@ -244,6 +283,8 @@ public:
 protected:
 	LayoutType getLayoutType() { return kLayoutWidget; }
 
+	CacheType getCacheType() const { return kCacheSpacing; }
+
 	ThemeLayout *makeClone(ThemeLayout *newParent) {
 		ThemeLayout *n = new ThemeLayoutSpacing(*this);
 		n->_parent = newParent;
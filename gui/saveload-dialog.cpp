@@ -23,6 +23,7 @@
 #include "gui/saveload-dialog.h"
 #include "common/translation.h"
 #include "common/config-manager.h"
+#include "common/system.h"
 
 #include "gui/message.h"
 #include "gui/gui-manager.h"
@@ -530,6 +531,12 @@ void SaveLoadChooserSimple::updateSaveList() {
 
 #ifndef DISABLE_SAVELOADCHOOSER_GRID
 
+enum {
+	// Upper bound (in milliseconds) we want to spend loading save meta
+	// infos in handleTickle.
+	kMaxMetaInfoLoadTime = 20
+};
+
 enum {
 	kNextCmd = 'NEXT',
 	kPrevCmd = 'PREV',
@@ -538,7 +545,7 @@ enum {
 
 SaveLoadChooserGrid::SaveLoadChooserGrid(const Common::String &title, bool saveMode)
 	: SaveLoadChooserDialog("SaveLoadChooser", saveMode), _lines(0), _columns(0), _entriesPerPage(0),
-	_curPage(0), _newSaveContainer(0), _nextFreeSaveSlot(0), _buttons() {
+	_curPage(0), _metaInfosPending(false), _newSaveContainer(0), _nextFreeSaveSlot(0), _buttons() {
 	_backgroundType = ThemeEngine::kDialogBackgroundSpecial;
 
 	new StaticTextWidget(this, "SaveLoadChooser.Title", title);
@@ -619,10 +626,18 @@ void SaveLoadChooserGrid::handleMouseWheel(int x, int y, int direction) {
 	}
 }
 
+void SaveLoadChooserGrid::handleTickle() {
+	if (_metaInfosPending && loadPendingMetaInfos())
+		draw();
+
+	SaveLoadChooserDialog::handleTickle();
+}
+
 void SaveLoadChooserGrid::open() {
 	SaveLoadChooserDialog::open();
 
 	_saveList = _metaEngine->listSaves(_target.c_str());
+	_metaInfoCache.clear();
 	_resultString.clear();
 
 	// Load information to restore the last page the user had open.
@@ -798,6 +813,7 @@ void SaveLoadChooserGrid::close() {
 
 	SaveLoadChooserDialog::close();
 	hideButtons();
+	_metaInfoCache.clear();
 }
 
 int SaveLoadChooserGrid::runIntern() {
@@ -860,53 +876,17 @@ void SaveLoadChooserGrid::hideButtons() {
 void SaveLoadChooserGrid::updateSaves() {
 	hideButtons();
 
+	// Show what the save list already tells us right away, the meta infos
+	// which are not cached yet are loaded bit by bit in handleTickle.
+	_metaInfosPending = false;
 	for (uint i = _curPage * _entriesPerPage, curNum = 0; i < _saveList.size() && curNum < _entriesPerPage; ++i, ++curNum) {
-		const uint saveSlot = _saveList[i].getSaveSlot();
-
-		SaveStateDescriptor desc = _metaEngine->querySaveMetaInfos(_target.c_str(), saveSlot);
-		SlotButton &curButton = _buttons[curNum];
-		curButton.setVisible(true);
-		const Graphics::Surface *thumbnail = desc.getThumbnail();
-		if (thumbnail) {
-			curButton.button->setGfx(desc.getThumbnail());
-		} else {
-			curButton.button->setGfx(kThumbnailWidth, kThumbnailHeight2, 0, 0, 0);
-		}
-		curButton.description->setLabel(Common::String::format("%d. %s", saveSlot, desc.getDescription().c_str()));
-
-		Common::String tooltip(_("Name: "));
-		tooltip += desc.getDescription();
-
-		if (_saveDateSupport) {
-			const Common::String &saveDate = desc.getSaveDate();
-			if (!saveDate.empty()) {
-				tooltip += "\n";
-				tooltip +=  _("Date: ") + saveDate;
-			}
-
-			const Common::String &saveTime = desc.getSaveTime();
-			if (!saveTime.empty()) {
-				tooltip += "\n";
-				tooltip += _("Time: ") + saveTime;
-			}
-		}
-
-		if (_playTimeSupport) {
-			const Common::String &playTime = desc.getPlayTime();
-			if (!playTime.empty()) {
-				tooltip += "\n";
-				tooltip += _("Playtime: ") + playTime;
-			}
-		}
-
-		curButton.button->setTooltip(tooltip);
+		const int saveSlot = _saveList[i].getSaveSlot();
 
-		// In save mode we disable the button, when it's write protected.
-		// TODO: Maybe we should not display it at all then?
-		if (_saveMode && desc.getWriteProtectedFlag()) {
-			curButton.button->setEnabled(false);
+		if (_metaInfoCache.contains(saveSlot)) {
+			updateSaveButton(curNum, saveSlot, _metaInfoCache[saveSlot], true);
 		} else {
-			curButton.button->setEnabled(true);
+			updateSaveButton(curNum, saveSlot, _saveList[i], false);
+			_metaInfosPending = true;
 		}
 	}
 
@@ -924,6 +904,79 @@ void SaveLoadChooserGrid::updateSaves() {
 		_nextButton->setEnabled(false);
 }
 
+void SaveLoadChooserGrid::updateSaveButton(uint curNum, int saveSlot, const SaveStateDescriptor &desc, bool complete) {
+	SlotButton &curButton = _buttons[curNum];
+	curButton.setVisible(true);
+	const Graphics::Surface *thumbnail = desc.getThumbnail();
+	if (thumbnail) {
+		curButton.button->setGfx(desc.getThumbnail());
+	} else {
+		curButton.button->setGfx(kThumbnailWidth, kThumbnailHeight2, 0, 0, 0);
+	}
+	curButton.description->setLabel(Common::String::format("%d. %s", saveSlot, desc.getDescription().c_str()));
+
+	Common::String tooltip(_("Name: "));
+	tooltip += desc.getDescription();
+
+	if (_saveDateSupport) {
+		const Common::String &saveDate = desc.getSaveDate();
+		if (!saveDate.empty()) {
+			tooltip += "\n";
+			tooltip +=  _("Date: ") + saveDate;
+		}
+
+		const Common::String &saveTime = desc.getSaveTime();
+		if (!saveTime.empty()) {
+			tooltip += "\n";
+			tooltip += _("Time: ") + saveTime;
+		}
+	}
+
+	if (_playTimeSupport) {
+		const Common::String &playTime = desc.getPlayTime();
+		if (!playTime.empty()) {
+			tooltip += "\n";
+			tooltip += _("Playtime: ") + playTime;
+		}
+	}
+
+	curButton.button->setTooltip(tooltip);
+
+	// In save mode we disable the button, when it's write protected. This
+	// is only known once the meta infos are loaded.
+	// TODO: Maybe we should not display it at all then?
+	if (_saveMode && (!complete || desc.getWriteProtectedFlag())) {
+		curButton.button->setEnabled(false);
+	} else {
+		curButton.button->setEnabled(true);
+	}
+}
+
+bool SaveLoadChooserGrid::loadPendingMetaInfos() {
+	const uint32 startTime = g_system->getMillis();
+	bool updated = false;
+
+	_metaInfosPending = false;
+	for (uint i = _curPage * _entriesPerPage, curNum = 0; i < _saveList.size() && curNum < _entriesPerPage; ++i, ++curNum) {
+		const int saveSlot = _saveList[i].getSaveSlot();
+		if (_metaInfoCache.contains(saveSlot))
+			continue;
+
+		// Leave the rest for the next tickle to keep the GUI responsive
+		if (updated && g_system->getMillis() - startTime >= kMaxMetaInfoLoadTime) {
+			_metaInfosPending = true;
+			break;
+		}
+
+		SaveStateDescriptor desc = _metaEngine->querySaveMetaInfos(_target.c_str(), saveSlot);
+		_metaInfoCache[saveSlot] = desc;
+		updateSaveButton(curNum, saveSlot, desc, true);
+		updated = true;
+	}
+
+	return updated;
+}
+
 SavenameDialog::SavenameDialog()
 	: Dialog("SavenameDialog") {
 	_title = new StaticTextWidget(this, "SavenameDialog.DescriptionText", Common::String());
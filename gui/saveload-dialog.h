@@ -164,6 +164,7 @@ public:
 protected:
 	virtual void handleCommand(CommandSender *sender, uint32 cmd, uint32 data);
 	virtual void handleMouseWheel(int x, int y, int direction);
+	virtual void handleTickle();
 private:
 	virtual int runIntern();
 
@@ -172,6 +173,12 @@ private:
 	uint _curPage;
 	SaveStateList _saveList;
 
+	// Meta infos of the save slots queried so far, so that flipping
+	// through the pages does not load the same save files again.
+	typedef Common::HashMap<int, SaveStateDescriptor> MetaInfoCache;
+	MetaInfoCache _metaInfoCache;
+	bool _metaInfosPending;
+
 	ButtonWidget *_nextButton;
 	ButtonWidget *_prevButton;
 
@@ -201,6 +208,8 @@ private:
 	void destroyButtons();
 	void hideButtons();
 	void updateSaves();
+	void updateSaveButton(uint curNum, int saveSlot, const SaveStateDescriptor &desc, bool complete);
+	bool loadPendingMetaInfos();
 };
 
 #endif // !DISABLE_SAVELOADCHOOSER_GRID
@@ -0,0 +1,130 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/audiostream.h"
+#include "audio/decoders/cache.h"
+
+#include "helper.h"
+#include "../system.h"
+
+class DecodedAudioCacheTestSuite : public CxxTest::TestSuite
+{
+public:
+	void test_hit_and_miss() {
+		TestSystem system;
+		TestSystem::Scope scope(system);
+
+		Audio::DecodedAudioCache cache(1024 * 1024);
+
+		TS_ASSERT(!cache.getStream("sound.dat", 0));
+		TS_ASSERT_EQUALS(cache.getMisses(), 1u);
+
+		int16 *sine;
+		Audio::SeekableAudioStream *s = cache.addStream("sound.dat", 0, createSineStream<int16>(11025, 1, &sine, false, true));
+		TS_ASSERT(s);
+		TS_ASSERT_EQUALS(cache.getMemoryUsage(), 11025u * 2 * sizeof(int16));
+		delete s;
+
+		Audio::SeekableAudioStream *a = cache.getStream("sound.dat", 0);
+		Audio::SeekableAudioStream *b = cache.getStream("sound.dat", 0);
+		TS_ASSERT(a && b);
+		TS_ASSERT_EQUALS(cache.getHits(), 2u);
+		TS_ASSERT(!cache.getStream("sound.dat", 4));
+		TS_ASSERT_EQUALS(cache.getMisses(), 2u);
+
+		TS_ASSERT_EQUALS(a->isStereo(), true);
+		TS_ASSERT_EQUALS(a->getRate(), 11025);
+		TS_ASSERT_EQUALS(a->getLength().totalNumberOfFrames(), 11025);
+
+		// Both views have to be independent of each other
+		int16 buffer[22050];
+		TS_ASSERT_EQUALS(a->readBuffer(buffer, 1000), 1000);
+		TS_ASSERT_EQUALS(memcmp(buffer, sine, 1000 * sizeof(int16)), 0);
+		TS_ASSERT_EQUALS(b->readBuffer(buffer, 22050), 22050);
+		TS_ASSERT_EQUALS(memcmp(buffer, sine, 22050 * sizeof(int16)), 0);
+		TS_ASSERT_EQUALS(b->endOfData(), true);
+		TS_ASSERT_EQUALS(a->endOfData(), false);
+
+		TS_ASSERT(a->seek(Audio::Timestamp(0, 500, 11025)));
+		TS_ASSERT_EQUALS(a->readBuffer(buffer, 10), 10);
+		TS_ASSERT_EQUALS(memcmp(buffer, sine + 1000, 10 * sizeof(int16)), 0);
+
+		delete a;
+		delete b;
+		delete[] sine;
+	}
+
+	void test_eviction() {
+		TestSystem system;
+		TestSystem::Scope scope(system);
+
+		const uint32 entrySize = 11025 * sizeof(int16);
+		Audio::DecodedAudioCache cache(entrySize * 2);
+
+		int16 *sine;
+		delete cache.addStream("a", 0, createSineStream<int16>(11025, 1, &sine, false, false));
+		delete[] sine;
+		delete cache.addStream("b", 0, createSineStream<int16>(11025, 1, &sine, false, false));
+		delete[] sine;
+
+		// A stream created before eviction stays playable
+		Audio::SeekableAudioStream *b = cache.getStream("b", 0);
+
+		// Use "a", so that "b" is the least recently used entry
+		delete cache.getStream("a", 0);
+
+		delete cache.addStream("c", 0, createSineStream<int16>(11025, 1, &sine, false, false));
+		TS_ASSERT_EQUALS(cache.getMemoryUsage(), entrySize * 2);
+
+		Audio::SeekableAudioStream *a = cache.getStream("a", 0);
+		TS_ASSERT(a);
+		delete a;
+		TS_ASSERT(!cache.getStream("b", 0));
+
+		int16 buffer[11025];
+		TS_ASSERT_EQUALS(b->readBuffer(buffer, 11025), 11025);
+		TS_ASSERT_EQUALS(memcmp(buffer, sine, 11025 * sizeof(int16)), 0);
+		delete b;
+		delete[] sine;
+
+		cache.setMemoryBudget(entrySize);
+		TS_ASSERT_EQUALS(cache.getMemoryUsage(), entrySize);
+	}
+
+	void test_stream_outlives_cache() {
+		TestSystem system;
+		TestSystem::Scope scope(system);
+
+		int16 *sine;
+		Audio::SeekableAudioStream *a;
+		{
+			Audio::DecodedAudioCache cache(32 * 1024);
+			delete cache.addStream("a", 0, createSineStream<int16>(11025, 1, &sine, false, false));
+			a = cache.getStream("a", 0);
+			TS_ASSERT(a);
+
+			cache.clear();
+			TS_ASSERT(!cache.getStream("a", 0));
+			TS_ASSERT_EQUALS(cache.getMemoryUsage(), 0u);
+
+			// Data too large for the cache is still played
+			Audio::SeekableAudioStream *b = cache.addStream("b", 0, createSineStream<int16>(11025, 2, 0, false, false));
+			TS_ASSERT(b);
+			TS_ASSERT(!cache.getStream("b", 0));
+			TS_ASSERT_EQUALS(b->getLength().totalNumberOfFrames(), 22050);
+			delete b;
+
+			cache.setMemoryBudget(0);
+		}
+
+		int16 buffer[11025];
+		TS_ASSERT_EQUALS(a->readBuffer(buffer, 11025), 11025);
+		TS_ASSERT_EQUALS(memcmp(buffer, sine, 11025 * sizeof(int16)), 0);
+
+		// Streams are usually deleted by the mixer thread, so releasing the
+		// buffer has to be guarded
+		const uint32 locks = system.getMutexLocks();
+		delete a;
+		TS_ASSERT_LESS_THAN(locks, system.getMutexLocks());
+		delete[] sine;
+	}
+};
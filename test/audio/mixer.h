@@ -0,0 +1,47 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/mixer_intern.h"
+
+#include "helper.h"
+#include "../system.h"
+
+class MixerTestSuite : public CxxTest::TestSuite
+{
+public:
+	void test_default_handle() {
+		TestSystem system;
+		TestSystem::Scope scope(system);
+
+		Audio::MixerImpl mixerImpl(&system, 44100);
+		Audio::Mixer &mixer = mixerImpl;
+		mixerImpl.setReady(true);
+		Audio::SoundHandle handles[256];
+
+		TS_ASSERT(!mixer.isSoundHandleActive(Audio::SoundHandle()));
+
+		// Grow the channel table to its full size, then free the last slot
+		for (int i = 0; i < 256; ++i) {
+			mixer.playStream(Audio::Mixer::kPlainSoundType, &handles[i], createSineStream<int16>(11025, 1, 0, false, false));
+			TS_ASSERT(mixer.isSoundHandleActive(handles[i]));
+		}
+
+		mixer.stopHandle(handles[255]);
+		TS_ASSERT(!mixer.isSoundHandleActive(handles[255]));
+
+		// The default handle maps to the same slot, but must never be active
+		Audio::SoundHandle none;
+		TS_ASSERT(!mixer.isSoundHandleActive(none));
+		mixer.setChannelVolume(none, 10);
+		TS_ASSERT_EQUALS(mixer.getChannelVolume(none), 0);
+
+		// A sound played into the freed slot gets a new, valid handle
+		Audio::SoundHandle handle;
+		mixer.playStream(Audio::Mixer::kPlainSoundType, &handle, createSineStream<int16>(11025, 1, 0, false, false));
+		TS_ASSERT(mixer.isSoundHandleActive(handle));
+		TS_ASSERT(!mixer.isSoundHandleActive(handles[255]));
+		TS_ASSERT(!mixer.isSoundHandleActive(none));
+
+		mixer.stopAll();
+		TS_ASSERT(!mixer.isSoundHandleActive(handles[0]));
+	}
+};
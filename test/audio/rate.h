@@ -0,0 +1,256 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/audiostream.h"
+#include "audio/mixer.h"
+#include "audio/rate.h"
+
+#include "common/config-manager.h"
+
+#include "helper.h"
+
+class RateConverterTestSuite : public CxxTest::TestSuite
+{
+private:
+	static int scaleSample(int sample, int vol) {
+		return (sample * vol) / Audio::Mixer::kMaxMixerVolume;
+	}
+
+	/**
+	 * Fills a stereo output buffer with a pattern that makes clamping
+	 * visible in both directions.
+	 */
+	static void fillOutput(int16 *buffer, int pairs) {
+		for (int i = 0; i < pairs * 2; ++i)
+			buffer[i] = (int16)((i * 7919) % 65536 - 32768);
+	}
+
+	/**
+	 * Computes the output of the copy and integer downsampling converters
+	 * sample by sample. The downsampler skips the very first input frame.
+	 */
+	static void referenceSimple(const int16 *in, int inFrames, int step, bool stereo, bool reverseStereo,
+	                            int16 *out, int outPairs, int volL, int volR, int &produced) {
+		const int channels = stereo ? 2 : 1;
+		const int first = (step == 1) ? 0 : 1;
+		produced = 0;
+		for (int frame = first; frame < inFrames && produced < outPairs; frame += step, ++produced) {
+			const int out0 = in[frame * channels];
+			const int out1 = stereo ? in[frame * channels + 1] : out0;
+			Audio::clampedAdd(out[produced * 2 + (reverseStereo ? 1 : 0)], scaleSample(out0, volL));
+			Audio::clampedAdd(out[produced * 2 + (reverseStereo ? 0 : 1)], scaleSample(out1, volR));
+		}
+	}
+
+	/**
+	 * Computes the output of the linear interpolation converter sample by
+	 * sample, using the same 15 bit fixed point arithmetic.
+	 */
+	static void referenceLinear(const int16 *in, int inFrames, int inRate, int outRate, bool stereo, bool reverseStereo,
+	                            int16 *out, int outPairs, int volL, int volR, int &produced) {
+		const int channels = stereo ? 2 : 1;
+		const long fracOne = 1L << 15;
+		const long inc = ((long)inRate << 15) / outRate;
+		long pos = fracOne;
+		int last0 = 0, last1 = 0, cur0 = 0, cur1 = 0;
+		int frame = 0;
+		produced = 0;
+		while (produced < outPairs) {
+			while (pos >= fracOne) {
+				if (frame >= inFrames)
+					return;
+				last0 = cur0;
+				cur0 = in[frame * channels];
+				if (stereo) {
+					last1 = cur1;
+					cur1 = in[frame * channels + 1];
+				}
+				++frame;
+				pos -= fracOne;
+			}
+
+			const int out0 = (int16)(last0 + (((cur0 - last0) * pos + (fracOne >> 1)) >> 15));
+			const int out1 = stereo ? (int16)(last1 + (((cur1 - last1) * pos + (fracOne >> 1)) >> 15)) : out0;
+			Audio::clampedAdd(out[produced * 2 + (reverseStereo ? 1 : 0)], scaleSample(out0, volL));
+			Audio::clampedAdd(out[produced * 2 + (reverseStereo ? 0 : 1)], scaleSample(out1, volR));
+			++produced;
+			pos += inc;
+		}
+	}
+
+	void runConverter(int inRate, int outRate, bool stereo, bool reverseStereo, int volL, int volR) {
+		const int time = 1;
+		int16 *input;
+		Audio::SeekableAudioStream *s = createSineStream<int16>(inRate, time, &input, false, stereo);
+		const int inFrames = inRate * time;
+		const int outPairs = inFrames * outRate / inRate + 16;
+
+		int16 *expected = new int16[outPairs * 2];
+		int16 *actual = new int16[outPairs * 2];
+		fillOutput(expected, outPairs);
+		fillOutput(actual, outPairs);
+
+		int produced;
+		if (inRate % outRate == 0)
+			referenceSimple(input, inFrames, inRate / outRate, stereo, reverseStereo, expected, outPairs, volL, volR, produced);
+		else
+			referenceLinear(input, inFrames, inRate, outRate, stereo, reverseStereo, expected, outPairs, volL, volR, produced);
+
+		Audio::RateConverter *converter = Audio::makeRateConverter(inRate, outRate, stereo, reverseStereo);
+
+		// Feed the converter in uneven chunks to exercise block boundaries
+		int total = 0;
+		int chunk = 1;
+		while (total < outPairs) {
+			const int request = MIN(chunk, outPairs - total);
+			const int got = converter->flow(*s, actual + total * 2, request, volL, volR);
+			total += got;
+			if (got < request)
+				break;
+			chunk = chunk * 3 + 1;
+		}
+
+		TS_ASSERT_EQUALS(total, produced);
+		TS_ASSERT_EQUALS(memcmp(expected, actual, sizeof(int16) * outPairs * 2), 0);
+
+		delete converter;
+		delete[] expected;
+		delete[] actual;
+		delete[] input;
+		delete s;
+	}
+
+public:
+	void test_copy_mono() {
+		runConverter(22050, 22050, false, false, 256, 256);
+		runConverter(22050, 22050, false, false, 93, 200);
+	}
+
+	void test_copy_stereo() {
+		runConverter(22050, 22050, true, false, 256, 256);
+		runConverter(22050, 22050, true, false, 17, 255);
+	}
+
+	void test_copy_reverse_stereo() {
+		runConverter(22050, 22050, true, true, 256, 0);
+		runConverter(22050, 22050, true, true, 130, 7);
+	}
+
+	void test_simple_mono() {
+		runConverter(44100, 22050, false, false, 256, 256);
+		runConverter(44100, 11025, false, false, 61, 199);
+	}
+
+	void test_simple_stereo() {
+		runConverter(44100, 22050, true, false, 256, 256);
+		runConverter(44100, 11025, true, false, 3, 250);
+	}
+
+	void test_simple_reverse_stereo() {
+		runConverter(44100, 22050, true, true, 256, 128);
+	}
+
+	void test_linear_mono() {
+		runConverter(11025, 22050, false, false, 256, 256);
+		runConverter(11025, 48000, false, false, 255, 31);
+	}
+
+	void test_linear_stereo() {
+		runConverter(22050, 44100, true, false, 256, 256);
+		runConverter(44100, 48000, true, false, 199, 64);
+	}
+
+	void test_linear_reverse_stereo() {
+		runConverter(11025, 44100, true, true, 256, 100);
+	}
+
+	void test_sinc_dc_gain() {
+		// A constant signal has to pass the low pass filter unchanged
+		const int inRate = 11025, outRate = 48000;
+		const int inFrames = inRate / 4;
+		int16 *dc = (int16 *)malloc(inFrames * 2 * sizeof(int16));
+		for (int i = 0; i < inFrames * 2; ++i)
+			dc[i] = (i & 1) ? -12000 : 20000;
+
+		Common::SeekableReadStream *data = new Common::MemoryReadStream((const byte *)dc, inFrames * 2 * sizeof(int16), DisposeAfterUse::YES);
+		Audio::SeekableAudioStream *s = Audio::makeRawStream(data, inRate, Audio::FLAG_16BITS | Audio::FLAG_STEREO
+#ifdef SCUMM_LITTLE_ENDIAN
+		                                                     | Audio::FLAG_LITTLE_ENDIAN
+#endif
+		                                                     );
+
+		ConfMan.set("resampler", "sinc", Common::ConfigManager::kTransientDomain);
+		Audio::RateConverter *converter = Audio::makeRateConverter(inRate, outRate, true, false);
+		ConfMan.removeKey("resampler", Common::ConfigManager::kTransientDomain);
+
+		const int outPairs = inFrames * outRate / inRate;
+		int16 *out = new int16[outPairs * 2];
+		memset(out, 0, outPairs * 2 * sizeof(int16));
+		const int produced = converter->flow(*s, out, outPairs, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume);
+
+		TS_ASSERT_EQUALS(produced, outPairs);
+
+		// Skip the ramps from and to the silence around the input
+		for (int i = 64; i < produced - 64; ++i) {
+			TS_ASSERT_DELTA(out[i * 2], 20000, 2);
+			TS_ASSERT_DELTA(out[i * 2 + 1], -12000, 2);
+		}
+
+		delete[] out;
+		delete converter;
+		delete s;
+	}
+
+	void test_sinc_frame_count() {
+		// The output has to cover the whole input, including the frames the
+		// filter looks ahead at the end, even when downsampling by more
+		// than the converter buffers at once.
+		static const int rates[][2] = {
+			{ 11025, 44100 }, { 22050, 48000 }, { 44100, 22050 }, { 48000, 44100 },
+			{ 8000, 11025 }, { 96000, 4000 }, { 128000, 3000 }
+		};
+
+		for (int r = 0; r < ARRAYSIZE(rates); ++r) {
+			const int inRate = rates[r][0], outRate = rates[r][1];
+			const int inFrames = 5003;
+			const int expected = (int)((2LL * inFrames * outRate + inRate) / (2LL * inRate));
+
+			int16 *in = (int16 *)malloc(inFrames * sizeof(int16));
+			for (int i = 0; i < inFrames; ++i)
+				in[i] = (int16)((i * 7919) % 20000 - 10000);
+
+			Common::SeekableReadStream *data = new Common::MemoryReadStream((const byte *)in, inFrames * sizeof(int16), DisposeAfterUse::YES);
+			Audio::SeekableAudioStream *s = Audio::makeRawStream(data, inRate, Audio::FLAG_16BITS
+#ifdef SCUMM_LITTLE_ENDIAN
+			                                                     | Audio::FLAG_LITTLE_ENDIAN
+#endif
+			                                                     );
+
+			ConfMan.set("resampler", "sinc", Common::ConfigManager::kTransientDomain);
+			Audio::RateConverter *converter = Audio::makeRateConverter(inRate, outRate, false, false);
+			ConfMan.removeKey("resampler", Common::ConfigManager::kTransientDomain);
+
+			// Convert in small pieces, like the mixer does
+			const int chunk = 100;
+			int16 out[chunk * 2];
+			int produced = 0;
+			while (!s->endOfData()) {
+				const int read = converter->flow(*s, out, chunk, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume);
+				produced += read;
+				if (read < chunk)
+					break;
+			}
+
+			// The rest of the output is left for draining
+			int drained;
+			do {
+				drained = converter->drain(out, chunk, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume);
+				produced += drained;
+			} while (drained == chunk);
+
+			TSM_ASSERT_EQUALS(inRate, produced, expected);
+
+			delete converter;
+			delete s;
+		}
+	}
+};
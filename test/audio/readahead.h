@@ -0,0 +1,136 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/readahead.h"
+
+#include "common/timer.h"
+
+#include "helper.h"
+#include "../system.h"
+
+class ReadAheadAudioStreamTestSuite : public CxxTest::TestSuite
+{
+	/** A timer manager for a single callback, which only runs when told to */
+	class FakeTimerManager : public Common::TimerManager {
+	public:
+		FakeTimerManager() : _proc(0), _refCon(0) {}
+
+		virtual bool installTimerProc(TimerProc proc, int32 interval, void *refCon, const Common::String &id) {
+			TS_ASSERT(!_proc);
+			_proc = proc;
+			_refCon = refCon;
+			return true;
+		}
+
+		virtual void removeTimerProc(TimerProc proc) {
+			TS_ASSERT_EQUALS(proc, _proc);
+			_proc = 0;
+		}
+
+		bool isInstalled() const { return _proc != 0; }
+
+		void tick() {
+			if (_proc)
+				_proc(_refCon);
+		}
+
+	private:
+		TimerProc _proc;
+		void *_refCon;
+	};
+
+public:
+	void test_without_timer() {
+		// The test system has no timer manager, so the stream has to decode
+		// on demand instead of playing silence
+		TestSystem system;
+		TestSystem::Scope scope(system);
+
+		int16 *sine;
+		Audio::ReadAheadAudioStream *s = Audio::makeReadAheadAudioStream(createSineStream<int16>(11025, 2, &sine, false, true), 100);
+		TS_ASSERT(s);
+		TS_ASSERT_EQUALS(s->isStereo(), true);
+		TS_ASSERT_EQUALS(s->getRate(), 11025);
+
+		// Read more than the ring buffer holds at once, then the rest in
+		// small pieces
+		const int total = 11025 * 2 * 2;
+		int16 *buffer = new int16[total];
+		int pos = s->readBuffer(buffer, 10000);
+		TS_ASSERT_EQUALS(pos, 10000);
+		while (!s->endOfData()) {
+			const int read = s->readBuffer(buffer + pos, MIN(1000, total - pos));
+			TS_ASSERT_LESS_THAN(0, read);
+			if (read <= 0)
+				break;
+			pos += read;
+		}
+
+		TS_ASSERT_EQUALS(pos, total);
+		TS_ASSERT_EQUALS(memcmp(buffer, sine, total * sizeof(int16)), 0);
+		TS_ASSERT_EQUALS(s->getUnderruns(), 0u);
+
+		// Seeking refills the ring buffer from the new position
+		TS_ASSERT(s->seek(Audio::Timestamp(1000, 11025)));
+		TS_ASSERT_EQUALS(s->endOfData(), false);
+		TS_ASSERT_EQUALS(s->readBuffer(buffer, 100), 100);
+		TS_ASSERT_EQUALS(memcmp(buffer, sine + 11025 * 2, 100 * sizeof(int16)), 0);
+
+		delete[] buffer;
+		delete[] sine;
+		delete s;
+	}
+
+	void test_timer() {
+		TestSystem system;
+		TestSystem::Scope scope(system);
+		FakeTimerManager *timer = new FakeTimerManager();
+		system.setTimerManager(timer);
+
+		int16 *sine;
+		Audio::ReadAheadAudioStream *s = Audio::makeReadAheadAudioStream(createSineStream<int16>(11025, 2, &sine, false, true), 100);
+		TS_ASSERT(s);
+		TS_ASSERT(timer->isInstalled());
+
+		const int total = 11025 * 2 * 2;
+		int16 *buffer = new int16[total];
+
+		// The stream starts with a full ring buffer, but does not decode
+		// on its own once that has been read
+		int pos = s->readBuffer(buffer, total);
+		TS_ASSERT_LESS_THAN(0, pos);
+		TS_ASSERT_LESS_THAN(pos, total);
+		TS_ASSERT_EQUALS(s->readBuffer(buffer + pos, 100), 0);
+		TS_ASSERT_EQUALS(s->getUnderruns(), 2u);
+
+		// Each tick decodes at most 40 ms of audio
+		timer->tick();
+		const int perTick = 11025 * 2 * 40 / 1000;
+		TS_ASSERT_EQUALS(s->readBuffer(buffer + pos, total - pos), perTick);
+		pos += perTick;
+
+		// Keeping up with the ticks plays everything without underruns
+		const uint32 underruns = s->getUnderruns();
+		while (!s->endOfData() && pos < total) {
+			timer->tick();
+			const int read = s->readBuffer(buffer + pos, MIN(11025 * 2 * 10 / 1000, total - pos));
+			TS_ASSERT_LESS_THAN(0, read);
+			if (read <= 0)
+				break;
+			pos += read;
+		}
+
+		TS_ASSERT_EQUALS(pos, total);
+		TS_ASSERT(s->endOfData());
+		TS_ASSERT_EQUALS(s->getUnderruns(), underruns);
+		TS_ASSERT_EQUALS(memcmp(buffer, sine, total * sizeof(int16)), 0);
+
+		// The callback removes itself once the last stream is gone
+		delete s;
+		TS_ASSERT(timer->isInstalled());
+		timer->tick();
+		TS_ASSERT(!timer->isInstalled());
+
+		delete[] buffer;
+		delete[] sine;
+	}
+};
@@ -0,0 +1,181 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/dirtyregion.h"
+
+class DirtyRegionTestSuite : public CxxTest::TestSuite
+{
+	static bool isDisjoint(const Common::DirtyRegion &region) {
+		const Common::Array<Common::Rect> &rects = region.getRects();
+		for (uint i = 0; i < rects.size(); ++i)
+			for (uint j = i + 1; j < rects.size(); ++j)
+				if (rects[i].intersects(rects[j]))
+					return false;
+		return true;
+	}
+
+	public:
+	void test_merge_adjacent() {
+		Common::DirtyRegion region;
+		region.add(Common::Rect(0, 0, 10, 10));
+		region.add(Common::Rect(10, 0, 20, 10));
+		region.add(Common::Rect(0, 10, 20, 20));
+
+		TS_ASSERT_EQUALS(region.getRects().size(), 1u);
+		TS_ASSERT(region.getRects()[0] == Common::Rect(0, 0, 20, 20));
+	}
+
+	void test_contained() {
+		Common::DirtyRegion region;
+		region.add(Common::Rect(5, 5, 10, 10));
+		region.add(Common::Rect(0, 0, 20, 20));
+		region.add(Common::Rect(1, 1, 2, 2));
+		region.add(Common::Rect());
+
+		TS_ASSERT_EQUALS(region.getRects().size(), 1u);
+		TS_ASSERT_EQUALS(region.area(), 400u);
+	}
+
+	void test_overlap() {
+		Common::DirtyRegion region;
+		region.add(Common::Rect(0, 0, 10, 10));
+		region.add(Common::Rect(5, 5, 15, 15));
+
+		// Overlapping rectangles are kept as they are
+		TS_ASSERT_EQUALS(region.getRects().size(), 2u);
+		TS_ASSERT_EQUALS(region.area(), 200u);
+
+		region.limit(1);
+		TS_ASSERT_EQUALS(region.getRects().size(), 1u);
+		TS_ASSERT(region.getRects()[0] == Common::Rect(0, 0, 15, 15));
+	}
+
+	void test_many_small_rects() {
+		// Rows of sprites, each overlapping its neighbours
+		Common::DirtyRegion region;
+		for (int y = 0; y < 20; ++y)
+			for (int x = 0; x < 20; ++x)
+				region.add(Common::Rect(x * 8, y * 8 + x, x * 8 + 12, y * 8 + x + 12));
+
+		region.limit(30);
+		TS_ASSERT_LESS_THAN_EQUALS(region.getRects().size(), 30u);
+		TS_ASSERT(isDisjoint(region));
+		TS_ASSERT_LESS_THAN_EQUALS(region.area(), 164u * (164u + 19u));
+	}
+
+	void test_merge_recent() {
+		// A sprite moving along a row merges with its previous positions
+		Common::DirtyRegion region;
+		for (int x = 0; x < 100; ++x)
+			region.add(Common::Rect(x, 0, x + 10, 10));
+
+		TS_ASSERT_EQUALS(region.getRects().size(), 1u);
+		TS_ASSERT(region.getRects()[0] == Common::Rect(0, 0, 109, 10));
+	}
+
+	void test_limit() {
+		Common::DirtyRegion region;
+		for (int i = 0; i < 10; ++i)
+			region.add(Common::Rect(i * 20, i * 20, i * 20 + 5, i * 20 + 5));
+
+		TS_ASSERT_EQUALS(region.getRects().size(), 10u);
+		region.limit(4);
+		TS_ASSERT_LESS_THAN_EQUALS(region.getRects().size(), 4u);
+		TS_ASSERT(isDisjoint(region));
+		TS_ASSERT_LESS_THAN_EQUALS(250u, region.area());
+
+		region.clear();
+		TS_ASSERT(region.empty());
+	}
+
+	void test_limit_busy_frame() {
+		// Scattered sprites on a 320x200 screen
+		Common::DirtyRegion region;
+		Common::Array<Common::Rect> sprites;
+		uint seed = 1;
+		for (int i = 0; i < 300; ++i) {
+			seed = seed * 1103515245 + 12345;
+			const int x = (seed >> 8) % 300;
+			const int y = (seed >> 20) % 180;
+			sprites.push_back(Common::Rect(x, y, x + 1 + (seed & 15), y + 1 + ((seed >> 4) & 15)));
+			region.add(sprites.back());
+		}
+
+		Common::Rect bounds = region.getRects()[0];
+		for (uint i = 1; i < region.getRects().size(); ++i)
+			bounds.extend(region.getRects()[i]);
+
+		region.limit(50);
+		TS_ASSERT_LESS_THAN_EQUALS(region.getRects().size(), 50u);
+		TS_ASSERT(isDisjoint(region));
+		TS_ASSERT_LESS_THAN_EQUALS(region.area(), (uint32)bounds.width() * bounds.height());
+
+		// Every sprite pixel must still be covered
+		const Common::Array<Common::Rect> &rects = region.getRects();
+		for (uint i = 0; i < sprites.size(); ++i) {
+			uint32 covered = 0;
+			for (uint j = 0; j < rects.size(); ++j)
+				if (rects[j].intersects(sprites[i]))
+					covered += sprites[i].findIntersectingRect(rects[j]).width() * sprites[i].findIntersectingRect(rects[j]).height();
+			TS_ASSERT_EQUALS(covered, (uint32)sprites[i].width() * sprites[i].height());
+		}
+	}
+
+	void test_coverage() {
+		// Moving sprites on a 320x200 screen mark their old and new position.
+		// Without limit(), the region has to cover exactly the added pixels.
+		const int width = 320, height = 200;
+		const int sprites[] = { 20, 150, 400 };
+
+		for (int n = 0; n < ARRAYSIZE(sprites); ++n) {
+			Common::DirtyRegion region;
+			Common::Array<byte> added, covered;
+			added.resize(width * height);
+			covered.resize(width * height);
+			memset(&added[0], 0, width * height);
+			memset(&covered[0], 0, width * height);
+
+			uint seed = n + 1;
+			uint numAdded = 0;
+			for (int i = 0; i < sprites[n]; ++i) {
+				seed = seed * 1103515245 + 12345;
+				const int x = (seed >> 8) % 300;
+				const int y = (seed >> 20) % 180;
+				const Common::Rect r(x, y, x + 1 + (seed & 15), y + 1 + ((seed >> 4) & 15));
+
+				for (int pos = 0; pos < 2; ++pos) {
+					Common::Rect dirty(r);
+					dirty.translate(pos * 2, 0);
+					region.add(dirty);
+					++numAdded;
+
+					for (int py = dirty.top; py < dirty.bottom; ++py)
+						memset(&added[py * width + dirty.left], 1, dirty.width());
+				}
+			}
+
+			const Common::Array<Common::Rect> &rects = region.getRects();
+			TS_ASSERT_LESS_THAN_EQUALS(rects.size(), numAdded);
+
+			for (uint i = 0; i < rects.size(); ++i) {
+				TS_ASSERT(Common::Rect(width, height).contains(rects[i]));
+				for (int py = rects[i].top; py < rects[i].bottom; ++py)
+					memset(&covered[py * width + rects[i].left], 1, rects[i].width());
+			}
+
+			TS_ASSERT_EQUALS(memcmp(&added[0], &covered[0], width * height), 0);
+		}
+	}
+
+	void test_merge_moving() {
+		// A sprite moving by a few pixels leaves a single dirty rectangle
+		Common::DirtyRegion region;
+		for (int i = 0; i < 10; ++i) {
+			region.add(Common::Rect(100 + i, 50, 116 + i, 66));
+			region.add(Common::Rect(102 + i, 50, 118 + i, 66));
+		}
+
+		TS_ASSERT_EQUALS(region.getRects().size(), 1u);
+		TS_ASSERT(region.getRects()[0] == Common::Rect(100, 50, 127, 66));
+		TS_ASSERT_EQUALS(region.area(), 27u * 16u);
+	}
+};
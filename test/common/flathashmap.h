@@ -0,0 +1,215 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/flathashmap.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+#include "common/str.h"
+
+#include <time.h>
+
+class FlatHashMapTestSuite : public CxxTest::TestSuite
+{
+	template<class Map>
+	static uint32 benchmarkInts(Map &map, int count, uint &memory) {
+		const clock_t start = clock();
+
+		for (int i = 0; i < count; ++i)
+			map[i * 7919] = i;
+		memory = map.memoryUsage();
+
+		int found = 0;
+		for (int round = 0; round < 4; ++round) {
+			for (int i = 0; i < 2 * count; ++i) {
+				if (map.contains(i * 7919))
+					++found;
+			}
+		}
+		TS_ASSERT_EQUALS(found, 4 * count);
+
+		for (int i = 0; i < count; i += 2)
+			map.erase(i * 7919);
+		TS_ASSERT_EQUALS(map.size(), (uint)count / 2);
+
+		return (uint32)((clock() - start) * 1000 / CLOCKS_PER_SEC);
+	}
+
+	template<class Map>
+	static uint32 benchmarkStrings(Map &map, const Common::Array<Common::String> &keys, uint &memory) {
+		const clock_t start = clock();
+
+		for (uint i = 0; i < keys.size(); ++i)
+			map[keys[i]] = i;
+		memory = map.memoryUsage();
+
+		uint found = 0;
+		for (int round = 0; round < 4; ++round) {
+			for (uint i = 0; i < keys.size(); ++i) {
+				if (map.contains(keys[i]))
+					++found;
+			}
+		}
+		TS_ASSERT_EQUALS(found, 4 * keys.size());
+
+		for (uint i = 0; i < keys.size(); i += 2)
+			map.erase(keys[i]);
+
+		return (uint32)((clock() - start) * 1000 / CLOCKS_PER_SEC);
+	}
+
+	public:
+	void test_empty_clear() {
+		Common::FlatHashMap<int, int> container;
+		TS_ASSERT(container.empty());
+		container[0] = 17;
+		container[1] = 33;
+		TS_ASSERT(!container.empty());
+		container.clear();
+		TS_ASSERT(container.empty());
+
+		Common::FlatHashMap<Common::String, Common::String, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> container2;
+		TS_ASSERT(container2.empty());
+		container2["foo"] = "bar";
+		container2["quux"] = "blub";
+		TS_ASSERT(!container2.empty());
+		TS_ASSERT(container2.contains("FOO"));
+		container2.clear(true);
+		TS_ASSERT(container2.empty());
+		TS_ASSERT(!container2.contains("foo"));
+	}
+
+	void test_add_remove() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = 33;
+		container[2] = 45;
+		container[3] = 12;
+		container[4] = 96;
+		TS_ASSERT(container.contains(1));
+		container.erase(1);
+		TS_ASSERT(!container.contains(1));
+		container[1] = 42;
+		TS_ASSERT(container.contains(1));
+		TS_ASSERT_EQUALS(container[1], 42);
+		container.erase(0);
+		TS_ASSERT(!container.contains(0));
+		container.erase(4);
+		TS_ASSERT_EQUALS(container.size(), 3u);
+
+		Common::FlatHashMap<int, int>::iterator it = container.find(2);
+		TS_ASSERT_DIFFERS(it, container.end());
+		TS_ASSERT_EQUALS(it->_value, 45);
+		container.erase(it);
+		TS_ASSERT(!container.contains(2));
+		TS_ASSERT_EQUALS(container.find(2), container.end());
+	}
+
+	void test_lookup_with_default() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = -1;
+
+		const Common::FlatHashMap<int, int> &containerRef = container;
+
+		TS_ASSERT_EQUALS(containerRef.getVal(0), 17);
+		TS_ASSERT_EQUALS(containerRef.getVal(17), 0);
+		TS_ASSERT_EQUALS(containerRef.getVal(0, -10), 17);
+		TS_ASSERT_EQUALS(containerRef.getVal(17, -10), -10);
+		TS_ASSERT_EQUALS(container.size(), 2u);
+	}
+
+	void test_iterator() {
+		Common::FlatHashMap<int, int> container;
+		TS_ASSERT_EQUALS(container.begin(), container.end());
+
+		for (int i = 0; i < 100; ++i)
+			container[i] = i * 2;
+		for (int i = 0; i < 100; i += 3)
+			container.erase(i);
+
+		// Erasing while iterating must not skip other entries
+		int count = 0;
+		for (Common::FlatHashMap<int, int>::iterator i = container.begin(); i != container.end(); ++i) {
+			TS_ASSERT(i->_key % 3 != 0);
+			TS_ASSERT_EQUALS(i->_value, i->_key * 2);
+			if (i->_key % 3 == 1)
+				container.erase(i);
+			++count;
+		}
+		TS_ASSERT_EQUALS(count, 66);
+
+		count = 0;
+		const Common::FlatHashMap<int, int> &containerRef = container;
+		for (Common::FlatHashMap<int, int>::const_iterator i = containerRef.begin(); i != containerRef.end(); ++i) {
+			TS_ASSERT_EQUALS(i->_key % 3, 2);
+			++count;
+		}
+		TS_ASSERT_EQUALS(count, 33);
+	}
+
+	void test_copy() {
+		Common::FlatHashMap<Common::String, int> map1, map2;
+		for (int i = 0; i < 50; ++i)
+			map1[Common::String::format("key%d", i)] = i;
+		map1.erase("key7");
+
+		map2 = map1;
+		Common::FlatHashMap<Common::String, int> map3(map1);
+		map1.clear();
+
+		TS_ASSERT_EQUALS(map2.size(), 49u);
+		TS_ASSERT_EQUALS(map3.size(), 49u);
+		TS_ASSERT(!map2.contains("key7"));
+		TS_ASSERT_EQUALS(map2["key8"], 8);
+		TS_ASSERT_EQUALS(map3["key49"], 49);
+	}
+
+	void test_churn() {
+		// Lots of inserts and erases, to exercise erased slot reuse and
+		// rehashing, checked against HashMap.
+		Common::FlatHashMap<uint, uint> flat;
+		Common::HashMap<uint, uint> reference;
+		uint seed = 1;
+		for (int i = 0; i < 20000; ++i) {
+			seed = seed * 1103515245 + 12345;
+			const uint key = (seed >> 16) % 512;
+			if (seed & 1) {
+				flat[key] = i;
+				reference[key] = i;
+			} else {
+				flat.erase(key);
+				reference.erase(key);
+			}
+		}
+
+		TS_ASSERT_EQUALS(flat.size(), reference.size());
+		for (Common::HashMap<uint, uint>::const_iterator i = reference.begin(); i != reference.end(); ++i)
+			TS_ASSERT_EQUALS(flat.getVal(i->_key, 0xFFFFFFFF), i->_value);
+	}
+
+	void test_benchmark() {
+		// Compare the throughput against HashMap. This does not check
+		// anything about speed, it only reports the numbers.
+		const int count = 100000;
+
+		Common::HashMap<int, int> intMap;
+		Common::FlatHashMap<int, int> flatIntMap;
+		uint intMemory, flatIntMemory;
+		const uint32 intTime = benchmarkInts(intMap, count, intMemory);
+		const uint32 flatIntTime = benchmarkInts(flatIntMap, count, flatIntMemory);
+
+		Common::Array<Common::String> keys;
+		for (int i = 0; i < count / 4; ++i)
+			keys.push_back(Common::String::format("some/path/file%d.dat", i));
+
+		Common::StringMap stringMap;
+		Common::FlatHashMap<Common::String, Common::String, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> flatStringMap;
+		uint stringMemory, flatStringMemory;
+		const uint32 stringTime = benchmarkStrings(stringMap, keys, stringMemory);
+		const uint32 flatStringTime = benchmarkStrings(flatStringMap, keys, flatStringMemory);
+
+		TS_TRACE(Common::String::format("int keys: HashMap %u ms (%u bytes), FlatHashMap %u ms (%u bytes)",
+		         intTime, intMemory, flatIntTime, flatIntMemory).c_str());
+		TS_TRACE(Common::String::format("string keys: HashMap %u ms (%u bytes), FlatHashMap %u ms (%u bytes)",
+		         stringTime, stringMemory, flatStringTime, flatStringMemory).c_str());
+	}
+};
@@ -0,0 +1,151 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/recorderfile.h"
+
+#include "../system.h"
+
+/**
+ * Keeps all save files in memory.
+ */
+class MemorySaveFileManager : public Common::SaveFileManager {
+	typedef Common::HashMap<Common::String, Common::Array<byte> > FileMap;
+
+	class OutFile : public Common::MemoryWriteStreamDynamic {
+	public:
+		OutFile(Common::Array<byte> &file) : Common::MemoryWriteStreamDynamic(DisposeAfterUse::YES), _file(file) {}
+
+		~OutFile() {
+			_file.resize(size());
+			if (size())
+				memcpy(&_file[0], getData(), size());
+		}
+
+	private:
+		Common::Array<byte> &_file;
+	};
+
+	FileMap _files;
+
+public:
+	virtual Common::OutSaveFile *openForSaving(const Common::String &name, bool compress = true) {
+		_files[name].clear();
+		return new OutFile(_files[name]);
+	}
+
+	virtual Common::InSaveFile *openForLoading(const Common::String &name) {
+		if (!_files.contains(name))
+			return 0;
+
+		const Common::Array<byte> &file = _files[name];
+		byte *data = (byte *)malloc(file.size());
+		if (file.size())
+			memcpy(data, &file[0], file.size());
+		return new Common::MemoryReadStream(data, file.size(), DisposeAfterUse::YES);
+	}
+
+	virtual bool removeSavefile(const Common::String &name) {
+		_files.erase(name);
+		return true;
+	}
+
+	virtual Common::StringArray listSavefiles(const Common::String &pattern) {
+		Common::StringArray names;
+		for (FileMap::const_iterator i = _files.begin(); i != _files.end(); ++i) {
+			if (i->_key.matchString(pattern, true))
+				names.push_back(i->_key);
+		}
+		return names;
+	}
+};
+
+class PlaybackFileTestSuite : public CxxTest::TestSuite
+{
+	static Common::RecorderEvent timerEvent(uint32 time) {
+		Common::RecorderEvent event;
+		event.recordedtype = Common::kRecorderEventTypeTimer;
+		event.time = time;
+		return event;
+	}
+
+	static Common::RecorderEvent mouseEvent(uint32 time, int16 x, int16 y) {
+		Common::RecorderEvent event;
+		event.recordedtype = Common::kRecorderEventTypeNormal;
+		event.time = time;
+		event.type = Common::EVENT_MOUSEMOVE;
+		event.mouse = Common::Point(x, y);
+		return event;
+	}
+
+	static Common::String saveFileContents(Common::PlaybackFile &file, const Common::String &name) {
+		const Common::PlaybackFile::SaveFileBuffer &buf = file.getHeader().saveFiles[name];
+		return Common::String((const char *)buf.buffer, buf.size);
+	}
+
+	public:
+	void test_keyframe_round_trip() {
+		TestSystem system;
+		TestSystem::Scope scope(system);
+		system.setSavefileManager(new MemorySaveFileManager());
+
+		Common::PlaybackFile *file = new Common::PlaybackFile();
+
+		// Record a session, starting with a save file, which the game saves
+		// again at the keyframe
+		TS_ASSERT(file->openWrite("test.rec"));
+		Common::MemoryReadStream before((const byte *)"before", 6);
+		file->addSaveFile("game.099", &before);
+
+		file->writeEvent(timerEvent(100));
+		file->writeEvent(mouseEvent(150, 10, 20));
+
+		Common::HashMap<Common::String, Common::PlaybackFile::SaveFileBuffer> saves;
+		byte afterData[] = { 'a', 'f', 't', 'e', 'r' };
+		Common::PlaybackFile::SaveFileBuffer after;
+		after.buffer = afterData;
+		after.size = sizeof(afterData);
+		saves["game.099"] = after;
+		Common::PlaybackFile::RandomSeedsDictionary randomStates;
+		randomStates["game"] = 0x12345678;
+		randomStates["sound"] = 42;
+		file->writeKeyframe(300, 99, saves, randomStates);
+
+		file->writeEvent(timerEvent(400));
+		file->writeEvent(mouseEvent(450, 15, 5));
+		file->close();
+
+		// Play it back from the start
+		TS_ASSERT(file->openRead("test.rec"));
+		TS_ASSERT_EQUALS(file->getKeyframes().size(), 1u);
+		TS_ASSERT_EQUALS(file->getKeyframes()[0].time, 300u);
+		TS_ASSERT_EQUALS(file->getKeyframes()[0].slot, 99);
+		TS_ASSERT_EQUALS(saveFileContents(*file, "game.099"), "before");
+
+		Common::RecorderEvent event = file->getNextEvent();
+		TS_ASSERT_EQUALS(event.recordedtype, Common::kRecorderEventTypeTimer);
+		TS_ASSERT_EQUALS(event.time, 100u);
+
+		// Seek to the keyframe, which restores its save file and random
+		// source states, and continues with the events recorded after it
+		randomStates.clear();
+		TS_ASSERT(file->seekToKeyframe(0, randomStates));
+		TS_ASSERT_EQUALS(saveFileContents(*file, "game.099"), "after");
+		TS_ASSERT_EQUALS(randomStates.size(), 2u);
+		TS_ASSERT_EQUALS(randomStates["game"], 0x12345678u);
+		TS_ASSERT_EQUALS(randomStates["sound"], 42u);
+
+		event = file->getNextEvent();
+		TS_ASSERT_EQUALS(event.recordedtype, Common::kRecorderEventTypeTimer);
+		TS_ASSERT_EQUALS(event.time, 400u);
+
+		event = file->getNextEvent();
+		TS_ASSERT_EQUALS(event.recordedtype, Common::kRecorderEventTypeNormal);
+		TS_ASSERT_EQUALS(event.time, 450u);
+		TS_ASSERT_EQUALS(event.type, Common::EVENT_MOUSEMOVE);
+		TS_ASSERT_EQUALS(event.mouse.x, 15);
+		TS_ASSERT_EQUALS(event.mouse.y, 5);
+
+		TS_ASSERT(!file->seekToKeyframe(1, randomStates));
+		file->close();
+		delete file;
+	}
+};
@@ -0,0 +1,101 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/xmlparser.h"
+
+class XMLParserTestParser : public Common::XMLParser {
+public:
+	Common::String _log;
+
+protected:
+	CUSTOM_XML_PARSER(XMLParserTestParser) {
+		XML_KEY(list)
+			XML_PROP(name, true)
+			XML_KEY(item)
+				XML_PROP(id, true)
+				XML_PROP(label, false)
+			KEY_END()
+		KEY_END()
+	} PARSER_END()
+
+	bool parserCallback_list(ParserNode *node) {
+		_log += "list:" + node->values["name"] + ";";
+		node->ignore = (node->values["name"] == "skip");
+		return true;
+	}
+
+	bool parserCallback_item(ParserNode *node) {
+		_log += "item:" + node->values["id"];
+		if (node->values.contains("label"))
+			_log += "=" + node->values["label"];
+		_log += ";";
+		return true;
+	}
+
+	bool closedKeyCallback(ParserNode *node) {
+		_log += "/" + node->name + ";";
+		return true;
+	}
+
+	void cleanup() {
+		_log.clear();
+	}
+};
+
+class XMLParserTestSuite : public CxxTest::TestSuite {
+public:
+	bool parse(XMLParserTestParser &parser, const char *text) {
+		parser.loadBuffer((const byte *)text, strlen(text));
+		bool result = parser.parse();
+		parser.close();
+		return result;
+	}
+
+	void test_parse() {
+		XMLParserTestParser parser;
+
+		TS_ASSERT(parse(parser,
+			"<?xml version = '1.0'?>\n"
+			"<!-- A comment - with a hyphen -->\n"
+			"<list name = 'first'>\n"
+			"\t<item id = 1 label = \"one two\"/>\n"
+			"\t<item id = '2'></item>\n"
+			"</list>\n"
+			"<list name = \"\"/>\n"));
+		TS_ASSERT_EQUALS(parser._log, "/xml;list:first;item:1=one two;/item;item:2;/item;/list;list:;/list;");
+	}
+
+	void test_node_reuse() {
+		XMLParserTestParser parser;
+
+		// The second item reuses the node of the first one, and must not
+		// see its label.
+		TS_ASSERT(parse(parser,
+			"<?xml version = '1.0'?>"
+			"<list name = 'a'><item id = '1' label = 'x'/><item id = '2'/></list>"));
+		TS_ASSERT_EQUALS(parser._log, "/xml;list:a;item:1=x;/item;item:2;/item;/list;");
+
+		// Parsing a shorter text must not see the rest of the previous one
+		TS_ASSERT(parse(parser, "<?xml version = '1.0'?><list name = 'b'/>"));
+		TS_ASSERT_EQUALS(parser._log, "/xml;list:b;/list;");
+	}
+
+	void test_property_case() {
+		XMLParserTestParser parser;
+
+		// Property names are not case sensitive
+		TS_ASSERT(parse(parser,
+			"<?xml version = '1.0'?>"
+			"<list NAME = 'a'><item Id = '1' lAbEl = 'x'/></list>"));
+		TS_ASSERT_EQUALS(parser._log, "/xml;list:a;item:1=x;/item;/list;");
+	}
+
+	void test_ignore() {
+		XMLParserTestParser parser;
+
+		TS_ASSERT(parse(parser,
+			"<?xml version = '1.0'?>"
+			"<list name = 'skip'><item id = '1'/></list>"
+			"<list name = 'keep'><item id = '2'/></list>"));
+		TS_ASSERT_EQUALS(parser._log, "/xml;list:skip;list:keep;item:2;/item;/list;");
+	}
+};
@@ -0,0 +1,191 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/archive.h"
+#include "common/array.h"
+#include "common/memstream.h"
+#include "common/ptr.h"
+#include "common/unzip.h"
+#include "common/zlib.h"
+
+#include "../system.h"
+
+class ZlibTestSuite : public CxxTest::TestSuite
+{
+	Common::Array<byte> _data;
+	Common::Array<byte> _deflated;
+	Common::Array<byte> _gzipped;
+
+	void makeData(uint32 size) {
+		// Compressible, but not trivially so
+		_data.resize(size);
+		uint32 seed = 12345;
+		for (uint32 i = 0; i < size; ++i) {
+			seed = seed * 1103515245 + 12345;
+			_data[i] = (byte)('a' + ((seed >> 16) % 8) + (i / 4096) % 4);
+		}
+	}
+
+	void deflateData() {
+		// Strip the gzip header and trailer, to get raw deflate data
+		Common::MemoryWriteStreamDynamic *mem = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::NO);
+		Common::WriteStream *gzip = Common::wrapCompressedWriteStream(mem);
+		gzip->write(&_data[0], _data.size());
+		gzip->finalize();
+
+		byte *gzipData = mem->getData();
+		const uint32 gzipSize = mem->size();
+		_gzipped.resize(gzipSize);
+		memcpy(&_gzipped[0], gzipData, gzipSize);
+		_deflated.resize(gzipSize - 18);
+		memcpy(&_deflated[0], gzipData + 10, gzipSize - 18);
+
+		delete gzip;
+		free(gzipData);
+	}
+
+	static void writeZipEntry(Common::WriteStream &out, uint32 localHeaderPos, bool central, const char *name,
+	                          uint16 method, uint32 compressedSize, uint32 uncompressedSize) {
+		out.writeUint32LE(central ? 0x02014b50 : 0x04034b50);
+		if (central)
+			out.writeUint16LE(20);	// version made by
+		out.writeUint16LE(20);		// version needed
+		out.writeUint16LE(0);		// flags
+		out.writeUint16LE(method);
+		out.writeUint32LE(0);		// DOS date and time
+		out.writeUint32LE(0);		// CRC
+		out.writeUint32LE(compressedSize);
+		out.writeUint32LE(uncompressedSize);
+		out.writeUint16LE(strlen(name));
+		out.writeUint16LE(0);		// extra field length
+		if (central) {
+			out.writeUint16LE(0);	// comment length
+			out.writeUint16LE(0);	// disk number
+			out.writeUint16LE(0);	// internal attributes
+			out.writeUint32LE(0);	// external attributes
+			out.writeUint32LE(localHeaderPos);
+		}
+		out.write(name, strlen(name));
+	}
+
+	void checkRandomAccess(Common::SeekableReadStream &stream) {
+		TS_ASSERT_EQUALS((uint32)stream.size(), _data.size());
+
+		byte buf[1000];
+		uint32 seed = 1;
+		for (int i = 0; i < 40; ++i) {
+			seed = seed * 1103515245 + 12345;
+			const uint32 pos = (seed >> 8) % (_data.size() - sizeof(buf));
+
+			TS_ASSERT(stream.seek(pos));
+			TS_ASSERT_EQUALS((uint32)stream.pos(), pos);
+			TS_ASSERT_EQUALS(stream.read(buf, sizeof(buf)), sizeof(buf));
+			TS_ASSERT_EQUALS(memcmp(buf, &_data[pos], sizeof(buf)), 0);
+		}
+
+		// Read past the end
+		TS_ASSERT(stream.seek(-10, SEEK_END));
+		TS_ASSERT_EQUALS(stream.read(buf, sizeof(buf)), 10u);
+		TS_ASSERT(stream.eos());
+		TS_ASSERT_EQUALS(memcmp(buf, &_data[_data.size() - 10], 10), 0);
+	}
+
+	public:
+	void test_deflate_stream() {
+		makeData(3 * 1024 * 1024 + 777);
+		deflateData();
+
+		Common::SeekableReadStream *compressed = new Common::MemoryReadStream(&_deflated[0], _deflated.size());
+		Common::ScopedPtr<Common::SeekableReadStream> stream(Common::wrapDeflateReadStream(compressed, _data.size()));
+		TS_ASSERT(stream);
+
+		// Sequential read of everything first, then random access
+		Common::Array<byte> all;
+		all.resize(_data.size());
+		TS_ASSERT_EQUALS(stream->read(&all[0], all.size()), all.size());
+		TS_ASSERT(all == _data);
+		TS_ASSERT(!stream->err());
+
+		checkRandomAccess(*stream);
+	}
+
+	void test_gzip_stream() {
+		makeData(4 * 1024 * 1024 + 123);
+		deflateData();
+
+		Common::SeekableReadStream *compressed = new Common::MemoryReadStream(&_gzipped[0], _gzipped.size());
+		Common::ScopedPtr<Common::SeekableReadStream> stream(Common::wrapCompressedReadStream(compressed));
+		TS_ASSERT(stream);
+
+		// Backward seeks must not decompress everything from the start
+		// again, so this would be very slow without checkpoints.
+		Common::Array<byte> all;
+		all.resize(_data.size());
+		TS_ASSERT_EQUALS(stream->read(&all[0], all.size()), all.size());
+		TS_ASSERT(all == _data);
+
+		for (int i = 0; i < 5; ++i)
+			checkRandomAccess(*stream);
+	}
+
+	void test_zip_members() {
+		// The archive serializes the access to its stream with a mutex
+		TestSystem system;
+		TestSystem::Scope scope(system);
+
+		makeData(1500 * 1024);
+		deflateData();
+
+		// Build an archive with one stored and one deflated member
+		Common::MemoryWriteStreamDynamic zip(DisposeAfterUse::YES);
+		const uint32 storedPos = zip.pos();
+		writeZipEntry(zip, 0, false, "stored.bin", 0, _data.size(), _data.size());
+		zip.write(&_data[0], _data.size());
+		const uint32 deflatedPos = zip.pos();
+		writeZipEntry(zip, 0, false, "deflated.bin", 8, _deflated.size(), _data.size());
+		zip.write(&_deflated[0], _deflated.size());
+
+		const uint32 centralPos = zip.pos();
+		writeZipEntry(zip, storedPos, true, "stored.bin", 0, _data.size(), _data.size());
+		writeZipEntry(zip, deflatedPos, true, "deflated.bin", 8, _deflated.size(), _data.size());
+		const uint32 centralSize = zip.pos() - centralPos;
+
+		zip.writeUint32LE(0x06054b50);
+		zip.writeUint16LE(0);
+		zip.writeUint16LE(0);
+		zip.writeUint16LE(2);
+		zip.writeUint16LE(2);
+		zip.writeUint32LE(centralSize);
+		zip.writeUint32LE(centralPos);
+		zip.writeUint16LE(0);
+
+		byte *zipData = (byte *)malloc(zip.size());
+		memcpy(zipData, zip.getData(), zip.size());
+		Common::Archive *archive = Common::makeZipArchive(new Common::MemoryReadStream(zipData, zip.size(), DisposeAfterUse::YES));
+		TS_ASSERT(archive);
+
+		TS_ASSERT(archive->hasFile("STORED.BIN"));
+		TS_ASSERT(!archive->hasFile("missing.bin"));
+
+		Common::ScopedPtr<Common::SeekableReadStream> stored(archive->createReadStreamForMember("stored.bin"));
+		Common::ScopedPtr<Common::SeekableReadStream> deflated(archive->createReadStreamForMember("deflated.bin"));
+		TS_ASSERT(stored);
+		TS_ASSERT(deflated);
+
+		// The member streams must stay usable after the archive is gone
+		delete archive;
+
+		// Interleave reads from both members
+		byte a[100], b[100];
+		for (uint32 pos = 0; pos + sizeof(a) <= _data.size(); pos += 65536) {
+			TS_ASSERT(stored->seek(pos));
+			TS_ASSERT(deflated->seek(pos));
+			TS_ASSERT_EQUALS(stored->read(a, sizeof(a)), sizeof(a));
+			TS_ASSERT_EQUALS(deflated->read(b, sizeof(b)), sizeof(b));
+			TS_ASSERT_EQUALS(memcmp(a, &_data[pos], sizeof(a)), 0);
+			TS_ASSERT_EQUALS(memcmp(b, &_data[pos], sizeof(b)), 0);
+		}
+
+		checkRandomAccess(*stored);
+		checkRandomAccess(*deflated);
+	}
+};
@@ -0,0 +1,127 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/scummsys.h"
+
+#ifdef USE_SCALERS
+#include "graphics/scaler/scale3x.h"
+#endif
+
+class Scale3xTestSuite : public CxxTest::TestSuite
+{
+#ifdef USE_SCALERS
+	typedef void (*Scale3xProc)(scale3x_uint16 *, scale3x_uint16 *, scale3x_uint16 *, const scale3x_uint16 *, const scale3x_uint16 *, const scale3x_uint16 *, unsigned);
+
+	/**
+	 * Scale a whole image row by row, repeating the first and last row at
+	 * the borders like scalebit does. The scalers look one pixel past both
+	 * ends of a row, so the rows of the source are padded by one pixel.
+	 */
+	static void scaleImage(Scale3xProc proc, uint16 *dst, const uint16 *src, int width, int height) {
+		const int pitch = width + 2;
+
+		for (int y = 0; y < height; ++y) {
+			const uint16 *src1 = src + y * pitch + 1;
+			const uint16 *src0 = (y > 0) ? src1 - pitch : src1;
+			const uint16 *src2 = (y < height - 1) ? src1 + pitch : src1;
+			uint16 *dst0 = dst + y * 3 * width * 3;
+
+			proc(dst0, dst0 + width * 3, dst0 + width * 6, src0, src1, src2, width);
+		}
+	}
+
+	/**
+	 * Check that the vector version of Scale3x scales every image of the
+	 * given pattern exactly like the plain C version, for widths which do
+	 * and do not fill whole vectors.
+	 */
+	static void compareWithDef(Scale3xProc proc, uint16 (*pattern)(int x, int y, uint &seed, uint16 mask), uint16 mask) {
+		const int widths[] = { 1, 2, 3, 7, 8, 9, 15, 16, 17, 31, 64, 100, 321 };
+		const int height = 12;
+
+		for (int w = 0; w < ARRAYSIZE(widths); ++w) {
+			const int width = widths[w];
+			uint16 *src = new uint16[(width + 2) * height];
+			uint16 *expected = new uint16[width * height * 9];
+			uint16 *result = new uint16[width * height * 9];
+
+			uint seed = width;
+			for (int y = 0; y < height; ++y)
+				for (int x = 0; x < width + 2; ++x)
+					src[y * (width + 2) + x] = pattern(x - 1, y, seed, mask);
+
+			memset(expected, 0, width * height * 9 * sizeof(uint16));
+			memset(result, 0xFF, width * height * 9 * sizeof(uint16));
+			scaleImage(scale3x_16_def, expected, src, width, height);
+			scaleImage(proc, result, src, width, height);
+
+			TSM_ASSERT_EQUALS(width, memcmp(expected, result, width * height * 9 * sizeof(uint16)), 0);
+
+			delete[] src;
+			delete[] expected;
+			delete[] result;
+		}
+	}
+
+	static uint nextRandom(uint &seed) {
+		seed = seed * 1103515245 + 12345;
+		return seed >> 8;
+	}
+
+	static uint16 randomPixels(int x, int y, uint &seed, uint16 mask) {
+		return nextRandom(seed) & mask;
+	}
+
+	static uint16 fewColors(int x, int y, uint &seed, uint16 mask) {
+		// Mostly equal neighbours, which is where Scale3x does its work.
+		// The colors differ in the top and bottom bits only.
+		static const uint16 colors[] = { 0x0000, 0x0001, 0x8000, 0xFFFF };
+		return colors[nextRandom(seed) % 4] & mask;
+	}
+
+	static uint16 edges(int x, int y, uint &seed, uint16 mask) {
+		// Diagonal lines, stripes and single dots
+		if ((x + y) % 5 == 0)
+			return mask;
+		if (x % 7 == 3)
+			return 0x7C1F & mask;
+		if (x == y * 2)
+			return 0x8001 & mask;
+		return 0;
+	}
+
+	static Scale3xProc getVectorProc() {
+#if defined(__SSE2__)
+		return scale3x_16_sse2;
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+		return scale3x_16_neon;
+#else
+		return 0;
+#endif
+	}
+#endif
+
+public:
+	void test_scale3x_555() {
+#ifdef USE_SCALERS
+		Scale3xProc proc = getVectorProc();
+		if (!proc)
+			return;
+
+		compareWithDef(proc, randomPixels, 0x7FFF);
+		compareWithDef(proc, fewColors, 0x7FFF);
+		compareWithDef(proc, edges, 0x7FFF);
+#endif
+	}
+
+	void test_scale3x_565() {
+#ifdef USE_SCALERS
+		Scale3xProc proc = getVectorProc();
+		if (!proc)
+			return;
+
+		compareWithDef(proc, randomPixels, 0xFFFF);
+		compareWithDef(proc, fewColors, 0xFFFF);
+		compareWithDef(proc, edges, 0xFFFF);
+#endif
+	}
+};
@@ -5,8 +5,8 @@
 #
 ######################################################################
 
-TESTS        := $(srcdir)/test/common/*.h $(srcdir)/test/audio/*.h
-TEST_LIBS    := audio/libaudio.a common/libcommon.a
+TESTS        := $(srcdir)/test/common/*.h $(srcdir)/test/audio/*.h $(srcdir)/test/graphics/*.h
+TEST_LIBS    := backends/saves/savefile.o audio/libaudio.a common/libcommon.a graphics/libgraphics.a common/libcommon.a
 
 #
 TEST_FLAGS   := --runner=StdioPrinter --no-std --no-eh --include=$(srcdir)/test/cxxtest_mingw.h
@@ -21,6 +21,22 @@ ifdef HAVE_GCC3
 TEST_CFLAGS  +=  -Wno-format
 endif
 
+# The benchmarks in the tests measure their run time with clock().
+TEST_CFLAGS  +=  -DFORBIDDEN_SYMBOL_EXCEPTION_clock
+
+ifdef ENABLE_EVENTRECORDER
+# The event recorder is part of the GUI and needs the SDL backend, so the
+# test runner can't link it. The library files which call into it are built
+# once more without its hooks, and linked before the libraries instead of
+# their regular versions.
+TEST_NORECORDER_OBJS := common/system.o common/random.o audio/mixer.o
+TEST_LIBS    := $(addprefix test/norecorder/,$(TEST_NORECORDER_OBJS)) $(TEST_LIBS)
+
+test/norecorder/%.o: $(srcdir)/%.cpp
+	$(QUIET)$(MKDIR) $(@D)
+	$(QUIET_CXX)$(CXX) $(CXXFLAGS) $(CPPFLAGS) -include $(srcdir)/test/norecorder.h -c $(<) -o $@
+endif
+
 # Enable this to get an X11 GUI for the error reporter.
 #TEST_FLAGS   += --gui=X11Gui
 #TEST_LDFLAGS += -L/usr/X11R6/lib -lX11
@@ -38,5 +54,6 @@ test/runner.cpp: $(TESTS)
 clean: clean-test
 clean-test:
 	-$(RM) test/runner.cpp test/runner
+	-$(RM) -r test/norecorder
 
 .PHONY: test clean-test
@@ -0,0 +1,7 @@
+/*
+ * Forced into the library files which the test runner rebuilds without the
+ * event recorder hooks, see test/module.mk. config.h is read first, so that
+ * its own definition of ENABLE_EVENTRECORDER can be removed.
+ */
+#include "config.h"
+#undef ENABLE_EVENTRECORDER
@@ -0,0 +1,90 @@
+#ifndef TEST_SYSTEM_H
+#define TEST_SYSTEM_H
+
+#include "common/system.h"
+#include "graphics/pixelformat.h"
+
+/**
+ * Minimal OSystem for tests of code that needs a backend for mutexes,
+ * timers or the clock. Nothing is drawn, and mutexes do nothing, as the
+ * tests run on a single thread.
+ *
+ * Tests install it with a TestSystem::Scope, which restores the previous
+ * g_system when it goes out of scope. Timer and savefile managers passed to
+ * it are deleted along with it.
+ */
+class TestSystem : public OSystem {
+public:
+	class Scope {
+	public:
+		Scope(TestSystem &system) : _previous(g_system) { g_system = &system; }
+		~Scope() { g_system = _previous; }
+
+	private:
+		OSystem *_previous;
+	};
+
+	TestSystem() : _millis(0), _mutexLocks(0), _mixer(0) {}
+
+	void setTimerManager(Common::TimerManager *timerManager) { _timerManager = timerManager; }
+	void setSavefileManager(Common::SaveFileManager *saveFileManager) { _savefileManager = saveFileManager; }
+	void setMixer(Audio::Mixer *mixer) { _mixer = mixer; }
+	void advanceMillis(uint32 msecs) { _millis += msecs; }
+
+	/** Returns how often any mutex has been locked so far */
+	uint32 getMutexLocks() const { return _mutexLocks; }
+
+	virtual void initBackend() {}
+
+	virtual const GraphicsMode *getSupportedGraphicsModes() const {
+		static const GraphicsMode modes[] = { { 0, 0, 0 } };
+		return modes;
+	}
+	virtual int getDefaultGraphicsMode() const { return 0; }
+	virtual bool setGraphicsMode(int mode) { return true; }
+	virtual int getGraphicsMode() const { return 0; }
+	virtual Graphics::PixelFormat getScreenFormat() const { return Graphics::PixelFormat::createFormatCLUT8(); }
+	virtual Common::List<Graphics::PixelFormat> getSupportedFormats() const { return Common::List<Graphics::PixelFormat>(); }
+	virtual void initSize(uint width, uint height, const Graphics::PixelFormat *format = NULL) {}
+	virtual int16 getHeight() { return 0; }
+	virtual int16 getWidth() { return 0; }
+	virtual PaletteManager *getPaletteManager() { return 0; }
+	virtual void copyRectToScreen(const void *buf, int pitch, int x, int y, int w, int h) {}
+	virtual Graphics::Surface *lockScreen() { return 0; }
+	virtual void unlockScreen() {}
+	virtual void fillScreen(uint32 col) {}
+	virtual void updateScreen() {}
+	virtual void setShakePos(int shakeOffset) {}
+	virtual void showOverlay() {}
+	virtual void hideOverlay() {}
+	virtual Graphics::PixelFormat getOverlayFormat() const { return Graphics::PixelFormat::createFormatCLUT8(); }
+	virtual void clearOverlay() {}
+	virtual void grabOverlay(void *buf, int pitch) {}
+	virtual void copyRectToOverlay(const void *buf, int pitch, int x, int y, int w, int h) {}
+	virtual int16 getOverlayHeight() { return 0; }
+	virtual int16 getOverlayWidth() { return 0; }
+	virtual bool showMouse(bool visible) { return false; }
+	virtual void warpMouse(int x, int y) {}
+	virtual void setMouseCursor(const void *buf, uint w, uint h, int hotspotX, int hotspotY, uint32 keycolor, bool dontScale = false, const Graphics::PixelFormat *format = NULL) {}
+
+	virtual uint32 getMillis(bool skipRecord = false) { return _millis; }
+	virtual void delayMillis(uint msecs) { _millis += msecs; }
+	virtual void getTimeAndDate(TimeDate &t) const { memset(&t, 0, sizeof(t)); }
+
+	virtual MutexRef createMutex() { return (MutexRef)this; }
+	virtual void lockMutex(MutexRef mutex) { _mutexLocks++; }
+	virtual void unlockMutex(MutexRef mutex) {}
+	virtual void deleteMutex(MutexRef mutex) {}
+
+	virtual Audio::Mixer *getMixer() { return _mixer; }
+	virtual void quit() {}
+	virtual void displayMessageOnOSD(const char *msg) {}
+	virtual void logMessage(LogMessageType::Type type, const char *message) {}
+
+private:
+	uint32 _millis;
+	uint32 _mutexLocks;
+	Audio::Mixer *_mixer;
+};
+
+#endif